@@ -3,7 +3,27 @@
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
+#include <math.h>
 #include "fixedpoint.h"
+#include "fixedpoint_internal.h"
+
+// the calling thread's sticky status register (see fixedpoint_status_test)
+static _Thread_local int status;
+
+// OR the status flag for val's tag (if it has one) into the status register
+static Fixedpoint record_status(Fixedpoint val)
+{
+  status |= (1 << val.tag) & FIXEDPOINT_STATUS_ALL;
+  return val;
+}
+
+// Count a call of operation op which returned val (see fixedpoint_stats.h)
+static Fixedpoint count_op(int op, Fixedpoint val)
+{
+  (void)op;
+  STATS_RECORD(op, val.tag);
+  return val;
+}
 
 Fixedpoint fixedpoint_create(uint64_t whole)
 {
@@ -31,7 +51,7 @@ Fixedpoint fixedpoint_create_from_hex(const char *hex)
   // exceptions handling for  '-.' '.' will return 0
   if (strcmp(hex, "-.") == 0 || strcmp(hex, ".") == 0)
   {
-    return final;
+    return count_op(FIXEDPOINT_OP_CREATE_FROM_HEX, final);
   }
 
   uint64_t wholeStart = 0; // assume the char is positive
@@ -50,7 +70,8 @@ Fixedpoint fixedpoint_create_from_hex(const char *hex)
     else if (!((hex[i] >= '0' && hex[i] <= '9') || (hex[i] >= 'A' && hex[i] <= 'F') || (hex[i] >= 'a' && hex[i] <= 'f')))
     {
       final.tag = 2;
-      return final;
+      TRACE_PROBE(FIXEDPOINT_PROBE_HEX_INVALID, fixedpoint_create(0UL), fixedpoint_create(0UL), hex, final);
+      return count_op(FIXEDPOINT_OP_CREATE_FROM_HEX, record_status(final));
     }
   }
 
@@ -60,7 +81,8 @@ Fixedpoint fixedpoint_create_from_hex(const char *hex)
   if (wholeDigit > 16 || !(strlen(hex) == decPos || fracDigit - 1 <= 16))
   {
     final.tag = 2;
-    return final;
+    TRACE_PROBE(FIXEDPOINT_PROBE_HEX_INVALID, fixedpoint_create(0UL), fixedpoint_create(0UL), hex, final);
+    return count_op(FIXEDPOINT_OP_CREATE_FROM_HEX, record_status(final));
   }
 
   // truncate whole and frac part
@@ -84,7 +106,140 @@ Fixedpoint fixedpoint_create_from_hex(const char *hex)
 
   // change whole to uint64
   final.integer = (uint64_t)strtoul(whole_part, NULL, 16);
-  return final;
+  return count_op(FIXEDPOINT_OP_CREATE_FROM_HEX, final);
+}
+
+// Helpers for decimal parsing.  Digits are converted 8 at a time with SWAR
+// (SIMD within a register) arithmetic on a 64 bit word holding 8 characters.
+
+static const uint64_t pow10_table[9] = {1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL,
+                                        1000000UL, 10000000UL, 100000000UL};
+
+// load 8 characters so that the first one is in the low byte
+static uint64_t load_eight(const char *str)
+{
+  uint64_t chunk;
+  memcpy(&chunk, str, sizeof(chunk));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  chunk = __builtin_bswap64(chunk);
+#endif
+  return chunk;
+}
+
+// 1 if all 8 characters are digits: each byte must be 0x30-0x39, so its
+// high nibble is 3, and adding 6 must not carry into the high nibble
+static int is_eight_digits(uint64_t chunk)
+{
+  return ((chunk & 0xF0F0F0F0F0F0F0F0UL) |
+          (((chunk + 0x0606060606060606UL) & 0xF0F0F0F0F0F0F0F0UL) >> 4)) == 0x3333333333333333UL;
+}
+
+// combine 8 digits into their value, by pairs, then groups of 4
+static uint64_t parse_eight_digits(uint64_t chunk)
+{
+  chunk -= 0x3030303030303030UL;
+  chunk = (chunk * 10) + (chunk >> 8);
+  chunk = (((chunk & 0x000000FF000000FFUL) * (100 + (1000000UL << 32))) +
+           (((chunk >> 16) & 0x000000FF000000FFUL) * (1 + (10000UL << 32)))) >> 32;
+  return chunk;
+}
+
+// Parse n < 8 digits one at a time.  Returns 0 if any is not a digit.
+static int parse_few_digits(const char *str, size_t n, uint64_t *value)
+{
+  uint64_t result = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    if (str[i] < '0' || str[i] > '9')
+    {
+      return 0;
+    }
+    result = result * 10 + (uint64_t)(str[i] - '0');
+  }
+  *value = result;
+  return 1;
+}
+
+Fixedpoint fixedpoint_create_from_dec(const char *dec)
+{
+  return fixedpoint_create_from_dec_round(dec, FIXEDPOINT_ROUND_NEAREST_EVEN);
+}
+
+Fixedpoint fixedpoint_create_from_dec_round(const char *dec, int mode)
+{
+  Fixedpoint error = fixedpoint_create(0UL);
+  error.tag = 2;
+
+  int neg = (dec[0] == '-');
+  const char *whole = dec + neg;
+  size_t len = strlen(whole);
+  const char *dot = memchr(whole, '.', len);
+  size_t whole_len = dot ? (size_t)(dot - whole) : len;
+  const char *frac = dot ? dot + 1 : whole + len;
+  size_t frac_len = dot ? len - whole_len - 1 : 0;
+
+  // whole part: accumulate in 128 bits so overflow can be detected
+  u128 whole_val = 0;
+  int too_large = 0;
+  size_t i = 0;
+  for (; i + 8 <= whole_len; i += 8)
+  {
+    uint64_t chunk = load_eight(whole + i);
+    if (!is_eight_digits(chunk))
+    {
+      return count_op(FIXEDPOINT_OP_CREATE_FROM_DEC, record_status(error));
+    }
+    whole_val = whole_val * pow10_table[8] + parse_eight_digits(chunk);
+    too_large |= (whole_val >> 64) != 0;
+    whole_val &= 0xFFFFFFFFFFFFFFFFUL;
+  }
+  uint64_t digits;
+  if (!parse_few_digits(whole + i, whole_len - i, &digits))
+  {
+    return count_op(FIXEDPOINT_OP_CREATE_FROM_DEC, record_status(error));
+  }
+  whole_val = whole_val * pow10_table[whole_len - i] + digits;
+  too_large |= (whole_val >> 64) != 0;
+
+  // Fractional part: with the digits in groups of 8 from the start (the
+  // last group may be shorter), work backward from the last group,
+  // computing v = floor((group * 2^66 + v) / 10^k).  Since the floor of a
+  // floor divided by an integer is the floor of the whole quotient, v ends
+  // up as floor(fraction * 2^66) exactly: 64 bits of result, a rounding
+  // bit, and a bit that combines with the remainders into the sticky bit.
+  u128 v = 0;
+  int sticky = 0;
+  size_t last = frac_len % 8;
+  if (!parse_few_digits(frac + frac_len - last, last, &digits))
+  {
+    return count_op(FIXEDPOINT_OP_CREATE_FROM_DEC, record_status(error));
+  }
+  if (last != 0)
+  {
+    u128 t = ((u128)digits << 66) + v;
+    v = t / pow10_table[last];
+    sticky |= (t % pow10_table[last]) != 0;
+  }
+  for (size_t j = frac_len - last; j > 0; j -= 8)
+  {
+    uint64_t chunk = load_eight(frac + j - 8);
+    if (!is_eight_digits(chunk))
+    {
+      return count_op(FIXEDPOINT_OP_CREATE_FROM_DEC, record_status(error));
+    }
+    u128 t = ((u128)parse_eight_digits(chunk) << 66) + v;
+    v = t / pow10_table[8];
+    sticky |= (t % pow10_table[8]) != 0;
+  }
+
+  if (too_large)
+  {
+    Fixedpoint result = from_mag(MAX_MAG, neg);
+    result.tag = neg ? 3 : 4;
+    return count_op(FIXEDPOINT_OP_CREATE_FROM_DEC, record_status(result));
+  }
+  return count_op(FIXEDPOINT_OP_CREATE_FROM_DEC, round_mag((whole_val << 64) | (uint64_t)(v >> 2), (int)(v >> 1) & 1,
+                                                          sticky | (int)(v & 1), neg, mode));
 }
 
 uint64_t fixedpoint_whole_part(Fixedpoint val)
@@ -97,7 +252,8 @@ uint64_t fixedpoint_frac_part(Fixedpoint val)
   return val.fraction;
 }
 
-Fixedpoint fixedpoint_add(Fixedpoint left, Fixedpoint right)
+// fixedpoint_add, without counting the call
+static Fixedpoint add_values(Fixedpoint left, Fixedpoint right)
 {
   // create a new fixedpoint to represent the sum
   Fixedpoint sum = fixedpoint_create2(0UL, 0UL);
@@ -115,6 +271,10 @@ Fixedpoint fixedpoint_add(Fixedpoint left, Fixedpoint right)
     if (sum.fraction < left.fraction) // if carry happens
     {
       sum.integer += 1;
+      if (sum.integer == 0)
+      { // the carry itself overflowed the whole part
+        sum.tag = (left.tag == 1) ? 3 : 4;
+      }
     }
   }
   else
@@ -146,14 +306,26 @@ Fixedpoint fixedpoint_add(Fixedpoint left, Fixedpoint right)
     }
     sum.tag = big.tag; // sign goes with the big one
   }
-  return sum;
+  return record_status(sum);
 }
 
+Fixedpoint fixedpoint_add(Fixedpoint left, Fixedpoint right)
+{
+  Fixedpoint result = add_values(left, right);
+  if (result.tag == 3 || result.tag == 4)
+  {
+    TRACE_PROBE(FIXEDPOINT_PROBE_ADD_OVERFLOW, left, right, NULL, result);
+  }
+  return count_op(FIXEDPOINT_OP_ADD, result);
+}
+
+static Fixedpoint negate_value(Fixedpoint val);
+
 Fixedpoint fixedpoint_sub(Fixedpoint left, Fixedpoint right)
 {
   // initialize
   Fixedpoint result = fixedpoint_create2(0UL, 0UL);
-  result = fixedpoint_add(left, fixedpoint_negate(right));
+  result = add_values(left, negate_value(right));
 
   if (left.tag != right.tag && (result.integer < left.integer || result.integer < right.integer))
   {
@@ -168,11 +340,16 @@ Fixedpoint fixedpoint_sub(Fixedpoint left, Fixedpoint right)
       result.tag = 3;
     }
   }
+  if (result.tag == 3 || result.tag == 4)
+  {
+    TRACE_PROBE(FIXEDPOINT_PROBE_SUB_OVERFLOW, left, right, NULL, result);
+  }
 
-  return result;
+  return count_op(FIXEDPOINT_OP_SUB, record_status(result));
 }
 
-Fixedpoint fixedpoint_negate(Fixedpoint val)
+// fixedpoint_negate, without counting the call
+static Fixedpoint negate_value(Fixedpoint val)
 {
   if (fixedpoint_is_zero(val))
   {
@@ -183,8 +360,14 @@ Fixedpoint fixedpoint_negate(Fixedpoint val)
   return val;
 }
 
+Fixedpoint fixedpoint_negate(Fixedpoint val)
+{
+  return count_op(FIXEDPOINT_OP_NEGATE, negate_value(val));
+}
+
 Fixedpoint fixedpoint_halve(Fixedpoint val)
 {
+  Fixedpoint arg = val;
   int isOddFrac = (val.fraction % 2);
   // performing division
   val.fraction = val.fraction / 2;
@@ -201,18 +384,287 @@ Fixedpoint fixedpoint_halve(Fixedpoint val)
 
   // performing division
   val.integer = (val.integer / 2);
-  return val;
+  if (isOddFrac == 1)
+  {
+    TRACE_PROBE(FIXEDPOINT_PROBE_HALVE_UNDERFLOW, arg, fixedpoint_create(0UL), NULL, val);
+  }
+  return count_op(FIXEDPOINT_OP_HALVE, record_status(val));
 }
 
 Fixedpoint fixedpoint_double(Fixedpoint val)
 {
-  Fixedpoint result = fixedpoint_add(val, val);
-  return result;
+  Fixedpoint result = add_values(val, val);
+  return count_op(FIXEDPOINT_OP_DOUBLE, result);
+}
+
+Fixedpoint fixedpoint_mul(Fixedpoint left, Fixedpoint right)
+{
+  u128 hi, lo;
+  int neg = get_neg(left) ^ get_neg(right);
+
+  mul_mag(get_mag(left), get_mag(right), &hi, &lo);
+  // the result is the middle 128 bits of the 256 bit product
+  Fixedpoint product = from_mag((hi << 64) | (lo >> 64), neg);
+  if ((uint64_t)lo != 0)
+  {
+    product.tag = neg ? 5 : 6;
+  }
+  if ((hi >> 64) != 0)
+  {
+    product.tag = neg ? 3 : 4;
+  }
+  return count_op(FIXEDPOINT_OP_MUL, record_status(product));
+}
+
+Fixedpoint fixedpoint_halve_round(Fixedpoint val, int mode)
+{
+  return fixedpoint_shr_round(val, 1, mode);
+}
+
+Fixedpoint fixedpoint_shr_round(Fixedpoint val, int n, int mode)
+{
+  u128 mag = get_mag(val);
+  if (n == 0)
+  {
+    return val;
+  }
+  u128 dropped = mag & (((u128)1 << n) - 1);
+  int half = (int)(dropped >> (n - 1)) & 1;
+  int sticky = (dropped & (((u128)1 << (n - 1)) - 1)) != 0;
+  return round_mag(mag >> n, half, sticky, get_neg(val), mode);
+}
+
+Fixedpoint fixedpoint_shl(Fixedpoint val, int n)
+{
+  u128 mag = get_mag(val);
+  Fixedpoint result = from_mag(mag << n, get_neg(val));
+  if (n != 0 && (mag >> (128 - n)) != 0)
+  {
+    result.tag = get_neg(val) ? 3 : 4;
+  }
+  return record_status(result);
+}
+
+Fixedpoint fixedpoint_mul_round(Fixedpoint left, Fixedpoint right, int mode)
+{
+  u128 hi, lo;
+  int neg = get_neg(left) ^ get_neg(right);
+
+  mul_mag(get_mag(left), get_mag(right), &hi, &lo);
+  if ((hi >> 64) != 0)
+  {
+    Fixedpoint result = from_mag(MAX_MAG, neg);
+    result.tag = neg ? 3 : 4;
+    return count_op(FIXEDPOINT_OP_MUL_ROUND, record_status(result));
+  }
+  return count_op(FIXEDPOINT_OP_MUL_ROUND, round_mag((hi << 64) | (lo >> 64), (int)((uint64_t)lo >> 63) & 1,
+                                                     ((uint64_t)lo << 1) != 0, neg, mode));
+}
+
+Fixedpoint fixedpoint_div_round(Fixedpoint left, Fixedpoint right, int mode)
+{
+  u128 a = get_mag(left), b = get_mag(right);
+  int neg = get_neg(left) ^ get_neg(right);
+
+  if (b == 0)
+  {
+    Fixedpoint result = fixedpoint_create(0UL);
+    result.tag = 2;
+    return count_op(FIXEDPOINT_OP_DIV_ROUND, record_status(result));
+  }
+
+  // Restoring long division of the 192 bit dividend a * 2^64 by b.  Each
+  // step subtracts b under a mask rather than branching.
+  u128 q = 0, rem = 0;
+  int overflow = 0;
+  for (int i = 191; i >= 0; i--)
+  {
+    u128 top = rem >> 127;
+    u128 bit = (i >= 64) ? (a >> (i - 64)) & 1 : 0;
+    rem = (rem << 1) | bit;
+    u128 take = top | (rem >= b);
+    rem -= b & -take;
+    overflow |= (int)(q >> 127);
+    q = (q << 1) | take;
+  }
+
+  if (overflow)
+  {
+    Fixedpoint result = from_mag(MAX_MAG, neg);
+    result.tag = neg ? 3 : 4;
+    return count_op(FIXEDPOINT_OP_DIV_ROUND, record_status(result));
+  }
+  // compare 2 * rem with b without overflowing
+  int half = rem >= b - rem;
+  int sticky = half ? rem != b - rem : rem != 0;
+  return count_op(FIXEDPOINT_OP_DIV_ROUND, round_mag(q, half, sticky, neg, mode));
+}
+
+// Round a magnitude to 64 significant bits: the top 64 bits after
+// normalizing, with bit 0 set if any lower bit is set.  Converting the
+// result to double or float rounds correctly, since bit 0 is well below
+// the rounding position.  *exp is set to the power of 2 to scale by.
+static uint64_t round_to_64_bits(u128 mag, int *exp)
+{
+  int lz = (mag >> 64) ? __builtin_clzll((uint64_t)(mag >> 64))
+                       : 64 + __builtin_clzll((uint64_t)mag);
+  u128 norm = mag << lz;
+  *exp = -lz;
+  return (uint64_t)(norm >> 64) | ((uint64_t)norm != 0);
+}
+
+double fixedpoint_to_double(Fixedpoint val)
+{
+  u128 mag = get_mag(val);
+  int exp;
+  if (mag == 0)
+  {
+    return 0.0;
+  }
+  uint64_t bits = round_to_64_bits(mag, &exp);
+  double d = ldexp((double)bits, exp);
+  return get_neg(val) ? -d : d;
+}
+
+float fixedpoint_to_float(Fixedpoint val)
+{
+  u128 mag = get_mag(val);
+  int exp;
+  if (mag == 0)
+  {
+    return 0.0f;
+  }
+  uint64_t bits = round_to_64_bits(mag, &exp);
+  float f = ldexpf((float)bits, exp);
+  return get_neg(val) ? -f : f;
+}
+
+Fixedpoint fixedpoint_from_double(double d, int mode)
+{
+  int neg = signbit(d) != 0;
+  double a = fabs(d);
+  Fixedpoint result = fixedpoint_create(0UL);
+
+  if (isnan(d))
+  {
+    result.tag = 2;
+    return record_status(result);
+  }
+  if (a >= 0x1p64)
+  {
+    result = from_mag(MAX_MAG, neg);
+    result.tag = neg ? 3 : 4;
+    return record_status(result);
+  }
+  if (a == 0.0)
+  {
+    return result;
+  }
+
+  // a = m * 2^(e - 53) for an integer m < 2^53, so the magnitude in units
+  // of 2^-64 is m * 2^(e + 11)
+  int e;
+  u128 m = (uint64_t)ldexp(frexp(a, &e), 53);
+  int shift = e + 11;
+  if (shift >= 0)
+  {
+    return from_mag(m << shift, neg);
+  }
+  int n = -shift;
+  if (n >= 128)
+  {
+    return round_mag(0, 0, 1, neg, mode);
+  }
+  return round_mag(m >> n, (int)(m >> (n - 1)) & 1,
+                   (m & (((u128)1 << (n - 1)) - 1)) != 0, neg, mode);
+}
+
+Fixedpoint fixedpoint_from_int64(int64_t n)
+{
+  // negate in unsigned arithmetic so INT64_MIN works
+  uint64_t mag = (n < 0) ? -(uint64_t)n : (uint64_t)n;
+  return from_mag((u128)mag << 64, n < 0);
+}
+
+int fixedpoint_to_int64(Fixedpoint val, int mode, int64_t *out)
+{
+  return fixedpoint_to_scaled(val, 1UL, mode, out);
+}
+
+Fixedpoint fixedpoint_from_scaled(int64_t n, uint64_t scale, int mode)
+{
+  if (scale == 0)
+  {
+    Fixedpoint result = fixedpoint_create(0UL);
+    result.tag = 2;
+    return record_status(result);
+  }
+  uint64_t mag = (n < 0) ? -(uint64_t)n : (uint64_t)n;
+  u128 num = (u128)mag << 64;
+  u128 q = num / scale, rem = num % scale;
+  // compare 2 * rem with scale without overflowing
+  int half = rem >= scale - rem;
+  int sticky = half ? rem != scale - rem : rem != 0;
+  return round_mag(q, half, sticky, n < 0, mode);
+}
+
+int fixedpoint_to_scaled(Fixedpoint val, uint64_t scale, int mode, int64_t *out)
+{
+  u128 hi, lo;
+  int neg = get_neg(val);
+
+  // val * scale is hi:lo in units of 2^-64, so its integer part is the
+  // middle 128 bits (and the high 64 bits must be 0)
+  mul_mag(get_mag(val), scale, &hi, &lo);
+  u128 q = (hi << 64) | (lo >> 64);
+  int half = (int)((uint64_t)lo >> 63);
+  int sticky = ((uint64_t)lo << 1) != 0;
+  u128 r = q + round_inc(q, half, sticky, neg, mode);
+  int tag = neg;
+
+  if ((mode == FIXEDPOINT_ROUND_EXACT) & (half | sticky))
+  {
+    tag = neg ? 5 : 6;
+  }
+  // the result must be at most 2^63 - 1, or 2^63 if negative
+  if ((hi >> 64) != 0 || r < q || r > (((u128)1 << 63) - 1 + neg))
+  {
+    tag = neg ? 3 : 4;
+    r = ((u128)1 << 63) - 1 + neg;
+  }
+  *out = neg ? (int64_t)(0 - (uint64_t)r) : (int64_t)r;
+  fixedpoint_status_raise(1 << tag);
+  return tag;
+}
+
+Fixedpoint fixedpoint_add_sat(Fixedpoint left, Fixedpoint right)
+{
+  int saturated;
+  return add_sat(left, right, &saturated);
+}
+
+Fixedpoint fixedpoint_sub_sat(Fixedpoint left, Fixedpoint right)
+{
+  int saturated;
+  return sub_sat(left, right, &saturated);
+}
+
+Fixedpoint fixedpoint_double_sat(Fixedpoint val)
+{
+  int saturated;
+  return double_sat(val, &saturated);
+}
+
+Fixedpoint fixedpoint_mul_sat(Fixedpoint left, Fixedpoint right)
+{
+  int saturated;
+  return mul_sat(left, right, &saturated);
 }
 
 int fixedpoint_compare(Fixedpoint left, Fixedpoint right)
 {
   int result;
+  STATS_RECORD(FIXEDPOINT_OP_COMPARE, -1);
   if (sameSign(left, right) == 1) // same sign
   {
     if (left.integer == right.integer) // same whole part
@@ -335,42 +787,137 @@ int fixedpoint_is_valid(Fixedpoint val)
   return 0;
 }
 
+int fixedpoint_status_test(int flags)
+{
+  return status & flags;
+}
+
+void fixedpoint_status_clear(int flags)
+{
+  status &= ~flags;
+}
+
+void fixedpoint_status_raise(int flags)
+{
+  status |= flags & FIXEDPOINT_STATUS_ALL;
+}
+
 char *fixedpoint_format_as_hex(Fixedpoint val)
 {
-  char *result = malloc(35);
+  char *result = malloc(FIXEDPOINT_HEX_BUF_SIZE);
+  fixedpoint_format_as_hex_buf(val, result, FIXEDPOINT_HEX_BUF_SIZE);
+  return result;
+}
 
-  if (val.tag == 1 && val.fraction == 0)
-  { // negative whole only
-    sprintf(result, "-%lx", val.integer);
-  }
-  if (val.tag == 1 && val.fraction != 0)
-  { // negative both whole and frac
-    sprintf(result, "-%lx.%016lx", val.integer, val.fraction);
+int fixedpoint_format_as_hex_buf(Fixedpoint val, char *buf, size_t size)
+{
+  static const char hex_digits[] = "0123456789abcdef";
+  char result[FIXEDPOINT_HEX_BUF_SIZE];
+  int len = 0;
+  STATS_RECORD(FIXEDPOINT_OP_FORMAT_AS_HEX, -1);
 
-    // remove zeros in frac
-    int curr = strlen(result) - 1;
-    while (result[curr] == '0')
+  if (fixedpoint_is_valid(val))
+  {
+    // zero has no sign, even if it was produced as -0
+    if (get_neg(val))
     {
-      curr--;
+      result[len++] = '-';
     }
-    result[curr + 1] = '\0';
+    int shift = 60;
+    while (shift > 0 && (val.integer >> shift) == 0)
+    {
+      shift -= 4;
+    }
+    for (; shift >= 0; shift -= 4)
+    {
+      result[len++] = hex_digits[(val.integer >> shift) & 0xf];
+    }
+    // fraction digits, without trailing zeros
+    uint64_t frac = val.fraction;
+    if (frac != 0)
+    {
+      result[len++] = '.';
+    }
+    while (frac != 0)
+    {
+      result[len++] = hex_digits[frac >> 60];
+      frac <<= 4;
+    }
+  }
+  else
+  {
+    TRACE_PROBE(FIXEDPOINT_PROBE_FORMAT_INVALID, val, fixedpoint_create(0UL), NULL, val);
+  }
+  result[len] = '\0';
+
+  if (size > 0)
+  {
+    size_t n = ((size_t)len < size - 1) ? (size_t)len : size - 1;
+    memcpy(buf, result, n);
+    buf[n] = '\0';
+  }
+  return len;
+}
+
+int fixedpoint_format_as_dec(Fixedpoint val, char *buf, size_t size)
+{
+  char result[FIXEDPOINT_DEC_BUF_SIZE];
+  char digits[20];
+  int len = 0, num_digits = 0;
+  STATS_RECORD(FIXEDPOINT_OP_FORMAT_AS_DEC, -1);
+
+  if (get_neg(val))
+  {
+    result[len++] = '-';
   }
-  if (val.tag == 0 && val.fraction == 0)
-  { // positive whole only
-    sprintf(result, "%lx", val.integer);
+  uint64_t whole = val.integer;
+  do
+  {
+    digits[num_digits++] = (char)('0' + whole % 10);
+    whole /= 10;
+  } while (whole != 0);
+  while (num_digits > 0)
+  {
+    result[len++] = digits[--num_digits];
   }
-  if (val.tag == 0 && val.fraction != 0)
-  { // positive whole and frac
-    sprintf(result, "%lx.%016lx", val.integer, val.fraction);
 
-    // remove zeros in frac
-    int curr = strlen(result) - 1;
-    while (result[curr] == '0')
+  // Shortest round trip digits (Steele and White's free-format algorithm).
+  // Working in units of 2^-65, rem is what is left of the fraction and
+  // margin is half of 2^-64, scaled along with rem: any decimal closer to
+  // the fraction than margin converts back to it.  Generate digits until
+  // stopping (rounding the last digit down or up) is within the margin.
+  if (val.fraction != 0)
+  {
+    const u128 one = (u128)1 << 65;
+    u128 rem = (u128)val.fraction << 1;
+    u128 margin = 1;
+    int low = 0, high = 0;
+
+    result[len++] = '.';
+    while (!low && !high)
     {
-      curr--;
+      rem *= 10;
+      margin *= 10;
+      int digit = (int)(rem >> 65);
+      rem &= one - 1;
+      low = rem < margin;
+      high = margin > one || rem > one - margin;
+      // when both are possible, round to the nearer one
+      if (low && high)
+      {
+        low = rem <= one - rem;
+        high = !low;
+      }
+      result[len++] = (char)('0' + digit + high);
     }
-    result[curr + 1] = '\0';
   }
+  result[len] = '\0';
 
-  return result;
+  if (size > 0)
+  {
+    size_t n = ((size_t)len < size - 1) ? (size_t)len : size - 1;
+    memcpy(buf, result, n);
+    buf[n] = '\0';
+  }
+  return len;
 }
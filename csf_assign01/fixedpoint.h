@@ -1,7 +1,12 @@
 #ifndef FIXEDPREC_H
 #define FIXEDPREC_H
 
+#include <stddef.h>
 #include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 // typedef struct
 // {
 //   // TODO: add fields
@@ -28,6 +33,18 @@ typedef struct
   */
 } Fixedpoint;
 
+// Sticky status flags.  Each flag corresponds to one of the exceptional
+// tags above (the flag for tag t is 1 << t), so the flags raised by an
+// operation can be computed without branching on its result.
+#define FIXEDPOINT_STATUS_ERR           (1 << 2)
+#define FIXEDPOINT_STATUS_OVERFLOW_NEG  (1 << 3)
+#define FIXEDPOINT_STATUS_OVERFLOW_POS  (1 << 4)
+#define FIXEDPOINT_STATUS_UNDERFLOW_NEG (1 << 5)
+#define FIXEDPOINT_STATUS_UNDERFLOW_POS (1 << 6)
+#define FIXEDPOINT_STATUS_ALL           (FIXEDPOINT_STATUS_ERR | FIXEDPOINT_STATUS_OVERFLOW_NEG | \
+                                         FIXEDPOINT_STATUS_OVERFLOW_POS | FIXEDPOINT_STATUS_UNDERFLOW_NEG | \
+                                         FIXEDPOINT_STATUS_UNDERFLOW_POS)
+
 // Create a Fixedpoint value representing an integer.
 //
 // Parameters:
@@ -66,6 +83,62 @@ Fixedpoint fixedpoint_create2(uint64_t whole, uint64_t frac);
 //   fixedpoint_is_err returns true
 Fixedpoint fixedpoint_create_from_hex(const char *hex);
 
+// Fixedpoint constants written at compile time, with the hex digits of
+// the whole and fractional parts as the arguments, e.g.
+// FIXEDPOINT_LITERAL(1, 8) for 1.8 and FIXEDPOINT_LITERAL_NEG(0, 0004) for
+// -0.0004.  Each expands to an initializer, so it can be used in static
+// data:
+//
+//   static const Fixedpoint step = FIXEDPOINT_LITERAL(0, 8);
+//
+// or, as the compound literal (Fixedpoint)FIXEDPOINT_LITERAL(1, 8), in an
+// expression.  The value is exactly what fixedpoint_create_from_hex gives
+// for the same digits ("1.8", "-0.0004").  Both parts need at least one
+// digit; a character which isn't a hex digit, or more than 16 digits in
+// either part, is a compile error.  (For C only: C++ code can use the
+// _fx literals of fixedpoint_literals.hpp.)
+#define FIXEDPOINT_LITERAL(whole, frac) FIXEDPOINT_LITERAL_TAG_(whole, frac, 0)
+#define FIXEDPOINT_LITERAL_NEG(whole, frac) FIXEDPOINT_LITERAL_TAG_(whole, frac, 1)
+
+// (a bit-field of negative width, if there are too many digits)
+#define FIXEDPOINT_LITERAL_DIGITS_OK_(digits) \
+  (sizeof(struct { int too_many_hex_digits : sizeof(#digits) <= 17 ? 1 : -1; }) != 0)
+#define FIXEDPOINT_LITERAL_TAG_(whole, frac, neg)                                        \
+  {                                                                                      \
+    .integer = 0x##whole##ULL * FIXEDPOINT_LITERAL_DIGITS_OK_(whole),                    \
+    .fraction = (0x##frac##ULL << (4 * (16 - (sizeof(#frac) - 1)) % 64)) *               \
+                FIXEDPOINT_LITERAL_DIGITS_OK_(frac),                                     \
+    .tag = (neg)                                                                         \
+  }
+
+// Create a Fixedpoint value from a decimal string representation.
+// The string will have one of the following forms:
+//
+//    X
+//    -X
+//    X.Y
+//    -X.Y
+//
+// where X and Y are sequences of decimal digits (0-9).  There is no limit
+// on the number of digits.  A fraction which can't be represented exactly
+// in 64 bits (such as 0.1) is rounded to the nearest representable value,
+// with ties going to the even value.
+//
+// Returns:
+//   if the string is valid, the Fixedpoint value;
+//   if the string is invalid, a Fixedpoint value for which
+//   fixedpoint_is_err returns true;
+//   if the value is too large to represent, a value for which either
+//   fixedpoint_is_overflow_pos or fixedpoint_is_overflow_neg returns true
+Fixedpoint fixedpoint_create_from_dec(const char *dec);
+
+// Same as fixedpoint_create_from_dec, but rounds an inexact fraction
+// according to mode (one of the FIXEDPOINT_ROUND_ modes, defined below).
+// With FIXEDPOINT_ROUND_EXACT, an inexact fraction results in a value for
+// which fixedpoint_is_underflow_pos or fixedpoint_is_underflow_neg returns
+// true.
+Fixedpoint fixedpoint_create_from_dec_round(const char *dec, int mode);
+
 // Get the whole part of the given Fixedpoint value.
 //
 // Parameters:
@@ -149,6 +222,202 @@ Fixedpoint fixedpoint_halve(Fixedpoint val);
 //   computed value would have been positive or negative)
 Fixedpoint fixedpoint_double(Fixedpoint val);
 
+// Compute the product of two valid Fixedpoint values.
+//
+// Parameters:
+//   left - the left Fixedpoint value
+//   right - the right Fixedpoint value
+//
+// Returns:
+//   if the product left * right can be represented exactly, the product;
+//   if the magnitude of the product is too large to represent, a value for
+//   which either fixedpoint_is_overflow_pos or fixedpoint_is_overflow_neg
+//   returns true;
+//   otherwise, if the product has nonzero bits beyond the 64 bits of the
+//   fractional part, a value for which either fixedpoint_is_underflow_pos
+//   or fixedpoint_is_underflow_neg returns true
+Fixedpoint fixedpoint_mul(Fixedpoint left, Fixedpoint right);
+
+// Saturating versions of fixedpoint_add, fixedpoint_sub, fixedpoint_double
+// and fixedpoint_mul.  Instead of an overflow value, a result whose
+// magnitude is too large to represent is clamped to the largest
+// representable magnitude (whole and fractional parts all 1 bits) with the
+// sign the exact result would have had.  The result is always valid, and
+// no status flag is raised.  fixedpoint_mul_sat truncates (rounds toward
+// zero) product bits beyond the fractional part instead of underflowing.
+//
+// Parameters:
+//   left, right (or val) - valid Fixedpoint values
+//
+// Returns:
+//   the exact result, or the clamped result if it would have overflowed
+Fixedpoint fixedpoint_add_sat(Fixedpoint left, Fixedpoint right);
+Fixedpoint fixedpoint_sub_sat(Fixedpoint left, Fixedpoint right);
+Fixedpoint fixedpoint_double_sat(Fixedpoint val);
+Fixedpoint fixedpoint_mul_sat(Fixedpoint left, Fixedpoint right);
+
+// Rounding modes for the operations below which can produce a result with
+// more fractional bits than the representation has.
+//
+//   FIXEDPOINT_ROUND_EXACT - don't round: an inexact result is an underflow
+//                            value, as with fixedpoint_halve
+//   FIXEDPOINT_ROUND_NEAREST_EVEN - round to nearest, ties to even
+//   FIXEDPOINT_ROUND_TOWARD_ZERO - truncate the magnitude
+//   FIXEDPOINT_ROUND_FLOOR - round toward negative infinity
+//   FIXEDPOINT_ROUND_CEIL - round toward positive infinity
+#define FIXEDPOINT_ROUND_EXACT        0
+#define FIXEDPOINT_ROUND_NEAREST_EVEN 1
+#define FIXEDPOINT_ROUND_TOWARD_ZERO  2
+#define FIXEDPOINT_ROUND_FLOOR        3
+#define FIXEDPOINT_ROUND_CEIL         4
+
+// Return 1/2 of a valid Fixedpoint value, rounded according to mode.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded value; with FIXEDPOINT_ROUND_EXACT, the result is the same
+//   as fixedpoint_halve
+Fixedpoint fixedpoint_halve_round(Fixedpoint val, int mode);
+
+// Divide a valid Fixedpoint value by 2^n, rounding according to mode.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   n - the shift amount, from 0 to 127
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded value, or an underflow value if mode is
+//   FIXEDPOINT_ROUND_EXACT and the result can't be represented exactly
+Fixedpoint fixedpoint_shr_round(Fixedpoint val, int n, int mode);
+
+// Multiply a valid Fixedpoint value by 2^n.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   n - the shift amount, from 0 to 127
+//
+// Returns:
+//   the exact result, or an overflow value if its magnitude is too large
+//   to represent
+Fixedpoint fixedpoint_shl(Fixedpoint val, int n);
+
+// Compute the product of two valid Fixedpoint values, rounding according
+// to mode.  With FIXEDPOINT_ROUND_EXACT, this is the same as fixedpoint_mul.
+//
+// Parameters:
+//   left - the left Fixedpoint value
+//   right - the right Fixedpoint value
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded product, or an overflow value if its magnitude is too large
+//   to represent, or (with FIXEDPOINT_ROUND_EXACT) an underflow value if
+//   the product can't be represented exactly
+Fixedpoint fixedpoint_mul_round(Fixedpoint left, Fixedpoint right, int mode);
+
+// Compute the quotient of two valid Fixedpoint values, rounding according
+// to mode.
+//
+// Parameters:
+//   left - the dividend
+//   right - the divisor
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded quotient; an overflow value if its magnitude is too large
+//   to represent; with FIXEDPOINT_ROUND_EXACT, an underflow value if the
+//   quotient can't be represented exactly; or a value for which
+//   fixedpoint_is_err returns true if right is zero
+Fixedpoint fixedpoint_div_round(Fixedpoint left, Fixedpoint right, int mode);
+
+// Convert a valid Fixedpoint value to the nearest double (ties to even).
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//
+// Returns:
+//   the nearest double to val
+double fixedpoint_to_double(Fixedpoint val);
+
+// Convert a valid Fixedpoint value to the nearest float (ties to even).
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//
+// Returns:
+//   the nearest float to val
+float fixedpoint_to_float(Fixedpoint val);
+
+// Create a Fixedpoint value from a double.  Bits of d below 2^-64 are
+// rounded according to mode.
+//
+// Parameters:
+//   d - the value to convert
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the converted value; an overflow value if the magnitude of d (including
+//   infinity) is too large to represent; with FIXEDPOINT_ROUND_EXACT, an
+//   underflow value if d can't be represented exactly; or a value for which
+//   fixedpoint_is_err returns true if d is NaN
+Fixedpoint fixedpoint_from_double(double d, int mode);
+
+// Create a Fixedpoint value from an int64_t.  The conversion is always exact.
+//
+// Parameters:
+//   n - the value to convert
+//
+// Returns:
+//   the Fixedpoint value
+Fixedpoint fixedpoint_from_int64(int64_t n);
+
+// Convert a valid Fixedpoint value to an int64_t, rounding according to
+// mode.  A value too large for an int64_t is clamped to INT64_MIN or
+// INT64_MAX.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//   out - where to store the converted value
+//
+// Returns:
+//   the tag the result would have as a Fixedpoint value: 0 or 1 if the
+//   conversion succeeded, 3 or 4 if it overflowed, or (with
+//   FIXEDPOINT_ROUND_EXACT) 5 or 6 if val has a nonzero fractional part
+int fixedpoint_to_int64(Fixedpoint val, int mode, int64_t *out);
+
+// Create a Fixedpoint value from a scaled integer, i.e. compute
+// n / scale (for example, n cents with a scale of 100).
+//
+// Parameters:
+//   n - the scaled integer
+//   scale - the scale
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   n / scale, rounded according to mode; with FIXEDPOINT_ROUND_EXACT, an
+//   underflow value if the quotient can't be represented exactly; or an
+//   error value if scale is 0
+Fixedpoint fixedpoint_from_scaled(int64_t n, uint64_t scale, int mode);
+
+// Convert a valid Fixedpoint value to a scaled integer, i.e. compute
+// val * scale rounded to an integer according to mode.  As with
+// fixedpoint_to_int64, a result too large for an int64_t is clamped.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   scale - the scale
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//   out - where to store the scaled integer
+//
+// Returns:
+//   the tag of the result, as for fixedpoint_to_int64
+int fixedpoint_to_scaled(Fixedpoint val, uint64_t scale, int mode, int64_t *out);
+
 // Compare two valid Fixedpoint values.
 //
 // Parameters:
@@ -267,6 +536,33 @@ int fixedpoint_is_underflow_pos(Fixedpoint val);
 //   0 otherwise
 int fixedpoint_is_valid(Fixedpoint val);
 
+// Test the calling thread's sticky status register.  Every operation that
+// produces an error, overflow or underflow result ORs the corresponding
+// FIXEDPOINT_STATUS_ flag into the register, where it stays until cleared.
+// This allows a sequence of operations to run without checking each result,
+// and then check for exceptional results once at the end.
+//
+// Parameters:
+//   flags - the FIXEDPOINT_STATUS_ flags to test
+//
+// Returns:
+//   the subset of flags which are currently raised
+int fixedpoint_status_test(int flags);
+
+// Clear flags in the calling thread's sticky status register.
+//
+// Parameters:
+//   flags - the FIXEDPOINT_STATUS_ flags to clear
+void fixedpoint_status_clear(int flags);
+
+// Raise flags in the calling thread's sticky status register.  This is
+// used by operations outside of fixedpoint.c (such as the batch operations)
+// to merge the flags they accumulated locally.
+//
+// Parameters:
+//   flags - the FIXEDPOINT_STATUS_ flags to raise
+void fixedpoint_status_raise(int flags);
+
 // Return a dynamically allocated C character string with the representation of
 // the given valid Fixedpoint value.  The string should start with "-" if the
 // value is negative, and should use the characters 0-9 and a-f to represent
@@ -282,4 +578,44 @@ int fixedpoint_is_valid(Fixedpoint val);
 //   of the Fixedpoint value
 char *fixedpoint_format_as_hex(Fixedpoint val);
 
+// Size of a buffer large enough for any string produced by
+// fixedpoint_format_as_hex_buf, including the NUL terminator.
+#define FIXEDPOINT_HEX_BUF_SIZE 35
+
+// Format a valid Fixedpoint value as a hex string, as by
+// fixedpoint_format_as_hex, into a buffer supplied by the caller.  A value
+// which isn't valid is formatted as an empty string.
+//
+// Parameters:
+//   val - the Fixedpoint value
+//   buf - the buffer to write the NUL-terminated string to
+//   size - the size of buf; if it is too small, the string is truncated
+//
+// Returns:
+//   the length of the full string (not counting the NUL terminator)
+int fixedpoint_format_as_hex_buf(Fixedpoint val, char *buf, size_t size);
+
+// Size of a buffer large enough for any string produced by
+// fixedpoint_format_as_dec, including the NUL terminator.
+#define FIXEDPOINT_DEC_BUF_SIZE 43
+
+// Format a valid Fixedpoint value as a decimal string.  The fractional part
+// is the shortest sequence of digits which fixedpoint_create_from_dec
+// converts back to exactly the same value; as with
+// fixedpoint_format_as_hex, there is no decimal point if the fractional
+// part is 0.  The string starts with "-" if the value is negative.
+//
+// Parameters:
+//   val - the Fixedpoint value
+//   buf - the buffer to write the NUL-terminated string to
+//   size - the size of buf; if it is too small, the string is truncated
+//
+// Returns:
+//   the length of the full string (not counting the NUL terminator)
+int fixedpoint_format_as_dec(Fixedpoint val, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // FIXEDPREC_H
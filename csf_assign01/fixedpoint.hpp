@@ -0,0 +1,256 @@
+#ifndef FIXEDPOINT_HPP
+#define FIXEDPOINT_HPP
+
+// C++ front end for columns of Fixedpoint values.
+//
+// Arithmetic on columns builds a lazy expression tree instead of computing
+// anything, e.g.
+//
+//   fixedpoint::Column a = ..., b = ..., c = ...;
+//   auto r = (a + b).halve() - c;   // nothing computed yet
+//   fixedpoint::Column result = r;  // one loop over the rows
+//
+// When the tree is assigned to a Column (or passed to evaluate), each row
+// is computed by walking the tree with the C functions (fixedpoint_add,
+// fixedpoint_halve, ...), so there are no intermediate columns and the
+// results are exactly what the equivalent sequence of C calls gives.
+//
+// Expression trees hold references to the columns they use, so a tree
+// must not outlive them.
+
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+#include "fixedpoint.h"
+
+namespace fixedpoint
+{
+
+template <class E>
+class Expr;
+template <class E, Fixedpoint (*F)(Fixedpoint)>
+class Unary;
+class Column;
+class ColumnRef;
+
+namespace detail
+{
+
+// How an operand is stored in an expression node: columns by reference
+// (through ColumnRef), expression nodes by value.
+template <class E>
+struct Operand
+{
+  typedef E type;
+};
+
+template <>
+struct Operand<Column>
+{
+  typedef ColumnRef type;
+};
+
+} // namespace detail
+
+// Base class for expression nodes (the curiously recurring template
+// pattern lets operations be resolved at compile time, with no virtual
+// calls).  Every node has size() and operator[](i), which computes row i.
+template <class E>
+class Expr
+{
+public:
+  const E &self() const { return static_cast<const E &>(*this); }
+  std::size_t size() const { return self().size(); }
+  Fixedpoint operator[](std::size_t i) const { return self()[i]; }
+
+  // lazy versions of fixedpoint_halve, fixedpoint_double and
+  // fixedpoint_negate
+  Unary<E, fixedpoint_halve> halve() const;
+  Unary<E, fixedpoint_double> doubled() const;
+  Unary<E, fixedpoint_negate> operator-() const;
+};
+
+// Reference to the rows of a Column, used as a leaf of expression trees
+class ColumnRef : public Expr<ColumnRef>
+{
+public:
+  ColumnRef(const Fixedpoint *data, std::size_t size) : data_(data), size_(size) {}
+  std::size_t size() const { return size_; }
+  Fixedpoint operator[](std::size_t i) const { return data_[i]; }
+
+private:
+  const Fixedpoint *data_;
+  std::size_t size_;
+};
+
+// A single value used with every row of a column, e.g. a + Scalar(x)
+class Scalar : public Expr<Scalar>
+{
+public:
+  explicit Scalar(Fixedpoint val) : val_(val) {}
+  // a scalar matches the length of any column
+  std::size_t size() const { return static_cast<std::size_t>(-1); }
+  Fixedpoint operator[](std::size_t) const { return val_; }
+
+private:
+  Fixedpoint val_;
+};
+
+template <class E, Fixedpoint (*F)(Fixedpoint)>
+class Unary : public Expr<Unary<E, F>>
+{
+public:
+  explicit Unary(const typename detail::Operand<E>::type &arg) : arg_(arg) {}
+  std::size_t size() const { return arg_.size(); }
+  Fixedpoint operator[](std::size_t i) const { return F(arg_[i]); }
+
+private:
+  typename detail::Operand<E>::type arg_;
+};
+
+template <class L, class R, Fixedpoint (*F)(Fixedpoint, Fixedpoint)>
+class Binary : public Expr<Binary<L, R, F>>
+{
+public:
+  Binary(const typename detail::Operand<L>::type &left, const typename detail::Operand<R>::type &right)
+      : left_(left), right_(right)
+  {
+    assert(left.size() == right.size() || left.size() == static_cast<std::size_t>(-1) ||
+           right.size() == static_cast<std::size_t>(-1));
+  }
+  std::size_t size() const { return left_.size() < right_.size() ? left_.size() : right_.size(); }
+  Fixedpoint operator[](std::size_t i) const { return F(left_[i], right_[i]); }
+
+private:
+  typename detail::Operand<L>::type left_;
+  typename detail::Operand<R>::type right_;
+};
+
+// A column of values, stored contiguously so it can also be passed to the
+// C batch functions through data()
+class Column : public Expr<Column>
+{
+public:
+  Column() {}
+  explicit Column(std::size_t size) : data_(size, fixedpoint_create(0UL)) {}
+  Column(std::initializer_list<Fixedpoint> vals) : data_(vals) {}
+  Column(const Fixedpoint *vals, std::size_t size) : data_(vals, vals + size) {}
+
+  // evaluate an expression tree into a new column
+  template <class E>
+  Column(const Expr<E> &expr) : data_(expr.size())
+  {
+    evaluate_into(expr);
+  }
+
+  // evaluate an expression tree into this column; the tree may use this
+  // column, since each row is only read before it is written
+  template <class E>
+  Column &operator=(const Expr<E> &expr)
+  {
+    if (expr.size() != data_.size())
+    {
+      // resizing could move rows the tree refers to
+      Column result(expr);
+      data_.swap(result.data_);
+      return *this;
+    }
+    evaluate_into(expr);
+    return *this;
+  }
+
+  std::size_t size() const { return data_.size(); }
+  Fixedpoint operator[](std::size_t i) const { return data_[i]; }
+  Fixedpoint &operator[](std::size_t i) { return data_[i]; }
+  const Fixedpoint *data() const { return data_.data(); }
+  Fixedpoint *data() { return data_.data(); }
+
+  // columns are used in expression trees through a ColumnRef
+  operator ColumnRef() const { return ColumnRef(data_.data(), data_.size()); }
+
+private:
+  template <class E>
+  void evaluate_into(const Expr<E> &expr)
+  {
+    // the fused loop: each row goes through the whole tree at once
+    const E &e = expr.self();
+    for (std::size_t i = 0; i < data_.size(); i++)
+    {
+      data_[i] = e[i];
+    }
+  }
+
+  std::vector<Fixedpoint> data_;
+};
+
+// Evaluate an expression tree into an array of expr.size() values.
+template <class E>
+void evaluate(const Expr<E> &expr, Fixedpoint *out)
+{
+  const E &e = expr.self();
+  for (std::size_t i = 0; i < e.size(); i++)
+  {
+    out[i] = e[i];
+  }
+}
+
+template <class E>
+Unary<E, fixedpoint_halve> Expr<E>::halve() const
+{
+  return Unary<E, fixedpoint_halve>(self());
+}
+
+template <class E>
+Unary<E, fixedpoint_double> Expr<E>::doubled() const
+{
+  return Unary<E, fixedpoint_double>(self());
+}
+
+template <class E>
+Unary<E, fixedpoint_negate> Expr<E>::operator-() const
+{
+  return Unary<E, fixedpoint_negate>(self());
+}
+
+template <class L, class R>
+Binary<L, R, fixedpoint_add> operator+(const Expr<L> &left, const Expr<R> &right)
+{
+  return Binary<L, R, fixedpoint_add>(left.self(), right.self());
+}
+
+template <class L, class R>
+Binary<L, R, fixedpoint_sub> operator-(const Expr<L> &left, const Expr<R> &right)
+{
+  return Binary<L, R, fixedpoint_sub>(left.self(), right.self());
+}
+
+template <class L, class R>
+Binary<L, R, fixedpoint_mul> operator*(const Expr<L> &left, const Expr<R> &right)
+{
+  return Binary<L, R, fixedpoint_mul>(left.self(), right.self());
+}
+
+// operations between a column (or expression) and a single value
+
+template <class L>
+Binary<L, Scalar, fixedpoint_add> operator+(const Expr<L> &left, Fixedpoint right)
+{
+  return left + Scalar(right);
+}
+
+template <class L>
+Binary<L, Scalar, fixedpoint_sub> operator-(const Expr<L> &left, Fixedpoint right)
+{
+  return left - Scalar(right);
+}
+
+template <class L>
+Binary<L, Scalar, fixedpoint_mul> operator*(const Expr<L> &left, Fixedpoint right)
+{
+  return left * Scalar(right);
+}
+
+} // namespace fixedpoint
+
+#endif // FIXEDPOINT_HPP
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "fixedpoint.h"
+#include "fixedpoint_arena.h"
+
+#define DEFAULT_CHUNK_SIZE 65536
+
+typedef struct Chunk
+{
+  struct Chunk *next;
+  size_t size;
+  char data[];
+} Chunk;
+
+struct FixedpointArena
+{
+  Chunk *chunks;     // the current chunk, followed by the full ones
+  size_t chunk_size;
+  size_t pos;        // bytes used in the current chunk
+  size_t used;       // bytes used in all chunks
+};
+
+// key for the per-thread arenas, whose destructor frees them
+static pthread_key_t local_key;
+static pthread_once_t local_once = PTHREAD_ONCE_INIT;
+
+static Chunk *new_chunk(size_t size, Chunk *next)
+{
+  Chunk *chunk = malloc(sizeof(Chunk) + size);
+  if (chunk)
+  {
+    chunk->next = next;
+    chunk->size = size;
+  }
+  return chunk;
+}
+
+// Allocate size bytes (with no alignment) from an arena
+static char *arena_alloc(FixedpointArena *arena, size_t size)
+{
+  if (size > arena->chunks->size - arena->pos)
+  {
+    size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+    Chunk *chunk = new_chunk(chunk_size, arena->chunks);
+    if (!chunk)
+    {
+      return NULL;
+    }
+    arena->chunks = chunk;
+    arena->pos = 0;
+  }
+  char *p = arena->chunks->data + arena->pos;
+  arena->pos += size;
+  arena->used += size;
+  return p;
+}
+
+FixedpointArena *fixedpoint_arena_create(size_t chunk_size)
+{
+  FixedpointArena *arena = malloc(sizeof(FixedpointArena));
+  if (!arena)
+  {
+    return NULL;
+  }
+  arena->chunk_size = chunk_size ? chunk_size : DEFAULT_CHUNK_SIZE;
+  arena->chunks = new_chunk(arena->chunk_size, NULL);
+  arena->pos = 0;
+  arena->used = 0;
+  if (!arena->chunks)
+  {
+    free(arena);
+    return NULL;
+  }
+  return arena;
+}
+
+void fixedpoint_arena_destroy(FixedpointArena *arena)
+{
+  if (arena)
+  {
+    while (arena->chunks)
+    {
+      Chunk *next = arena->chunks->next;
+      free(arena->chunks);
+      arena->chunks = next;
+    }
+    free(arena);
+  }
+}
+
+void fixedpoint_arena_reset(FixedpointArena *arena)
+{
+  // keep the current chunk, which is the newest and (if a string was ever
+  // larger than the chunk size) possibly the largest
+  Chunk *chunk = arena->chunks->next;
+  while (chunk)
+  {
+    Chunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  arena->chunks->next = NULL;
+  arena->pos = 0;
+  arena->used = 0;
+}
+
+size_t fixedpoint_arena_used(const FixedpointArena *arena)
+{
+  return arena->used;
+}
+
+static void destroy_local(void *arena)
+{
+  fixedpoint_arena_destroy(arena);
+}
+
+static void create_local_key(void)
+{
+  pthread_key_create(&local_key, destroy_local);
+}
+
+FixedpointArena *fixedpoint_arena_local(void)
+{
+  pthread_once(&local_once, create_local_key);
+  FixedpointArena *arena = pthread_getspecific(local_key);
+  if (!arena)
+  {
+    arena = fixedpoint_arena_create(0);
+    if (arena && pthread_setspecific(local_key, arena) != 0)
+    {
+      fixedpoint_arena_destroy(arena);
+      arena = NULL;
+    }
+  }
+  return arena;
+}
+
+char *fixedpoint_format_as_hex_arena(Fixedpoint val, FixedpointArena *arena)
+{
+  // take room for the longest string, then give back what isn't used
+  char *result = arena_alloc(arena, FIXEDPOINT_HEX_BUF_SIZE);
+  if (!result)
+  {
+    return NULL;
+  }
+  size_t unused = FIXEDPOINT_HEX_BUF_SIZE - (fixedpoint_format_as_hex_buf(val, result, FIXEDPOINT_HEX_BUF_SIZE) + 1);
+  arena->pos -= unused;
+  arena->used -= unused;
+  return result;
+}
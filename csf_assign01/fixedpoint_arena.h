@@ -0,0 +1,82 @@
+#ifndef FIXEDPOINT_ARENA_H
+#define FIXEDPOINT_ARENA_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Arenas for formatted strings.
+//
+// fixedpoint_format_as_hex allocates each string separately, and each one
+// must be freed.  Formatting into an arena instead takes the string from
+// a large chunk of memory by bumping a pointer, and all the strings in an
+// arena are freed at once by fixedpoint_arena_reset (or
+// fixedpoint_arena_destroy).  Each string takes only as many bytes as it
+// needs.
+//
+// An arena must only be used by one thread at a time.  Multithreaded
+// callers can use fixedpoint_arena_local to get an arena of their own
+// for each thread.
+
+typedef struct FixedpointArena FixedpointArena;
+
+// Create an empty arena.
+//
+// Parameters:
+//   chunk_size - the size of the chunks of memory the arena gets from
+//                malloc, or 0 for a default of 64 KiB
+//
+// Returns:
+//   the arena, to be freed with fixedpoint_arena_destroy, or NULL if
+//   memory couldn't be allocated
+FixedpointArena *fixedpoint_arena_create(size_t chunk_size);
+
+// Free an arena, and all the strings in it.
+//
+// Parameters:
+//   arena - the arena (may be NULL)
+void fixedpoint_arena_destroy(FixedpointArena *arena);
+
+// Free all the strings in an arena at once.  The arena keeps one chunk of
+// memory to reuse.
+//
+// Parameters:
+//   arena - the arena
+void fixedpoint_arena_reset(FixedpointArena *arena);
+
+// Get the number of bytes used by the strings in an arena.
+//
+// Parameters:
+//   arena - the arena
+//
+// Returns:
+//   the total size of the strings, including their NUL terminators
+size_t fixedpoint_arena_used(const FixedpointArena *arena);
+
+// Get the calling thread's own arena, which is created the first time
+// the thread calls this function, and destroyed when the thread exits.
+//
+// Returns:
+//   the thread's arena, or NULL if memory couldn't be allocated
+FixedpointArena *fixedpoint_arena_local(void);
+
+// Format a valid Fixedpoint value as a hex string, as by
+// fixedpoint_format_as_hex, in an arena.
+//
+// Parameters:
+//   val - the Fixedpoint value
+//   arena - the arena to allocate the string in
+//
+// Returns:
+//   the string, which lasts until the arena is reset or destroyed, or
+//   NULL if memory couldn't be allocated
+char *fixedpoint_format_as_hex_arena(Fixedpoint val, FixedpointArena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_ARENA_H
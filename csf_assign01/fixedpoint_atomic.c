@@ -0,0 +1,254 @@
+// for sched_getcpu
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+#include "fixedpoint_internal.h"
+#include "fixedpoint_atomic.h"
+
+#define CACHE_LINE_SIZE 64
+
+struct FixedpointAtomic
+{
+  _Alignas(16) u128 word;
+};
+
+typedef struct
+{
+  _Alignas(CACHE_LINE_SIZE) u128 word;
+} Shard;
+
+struct FixedpointShardedSum
+{
+  Shard *shards;
+  unsigned num_shards;
+};
+
+// Compare *ptr with *expected and, if they are equal, set *ptr to desired;
+// otherwise set *expected to *ptr.  Elsewhere than x86-64 this needs
+// libatomic.
+static inline int cas128(u128 *ptr, u128 *expected, u128 desired)
+{
+#if defined(__x86_64__)
+  uint64_t lo = (uint64_t)*expected, hi = (uint64_t)(*expected >> 64);
+  unsigned char ok;
+  __asm__ __volatile__("lock cmpxchg16b %1"
+                       : "=@ccz"(ok), "+m"(*ptr), "+a"(lo), "+d"(hi)
+                       : "b"((uint64_t)desired), "c"((uint64_t)(desired >> 64))
+                       : "memory");
+  *expected = ((u128)hi << 64) | lo;
+  return ok;
+#else
+  return __atomic_compare_exchange_n(ptr, expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Read a word atomically (a compare-and-swap which stores the value it
+// finds, if it finds zero)
+static inline u128 load128(u128 *ptr)
+{
+  u128 val = 0;
+  cas128(ptr, &val, 0);
+  return val;
+}
+
+// Convert between a Fixedpoint value and the packed two's complement form
+static inline u128 pack(Fixedpoint val)
+{
+  return get_neg(val) ? -get_mag(val) : get_mag(val);
+}
+
+static inline Fixedpoint unpack(u128 word)
+{
+  return (word >> 127) ? from_mag(-word, 1) : from_mag(word, 0);
+}
+
+// Add a signed value to a word, returning the new word in *total.  The
+// result is 0 if it was added, otherwise the tag of the error or overflow.
+static int add_word(u128 *word, u128 mag, int neg, u128 *total)
+{
+  // first guess at the current value; a torn read just fails the CAS, but
+  // it may also look out of range, so overflow is only reported for a
+  // value read atomically
+  u128 old = *(volatile u128 *)word;
+  int confirmed = 0;
+  for (;;)
+  {
+    // the exact sum, which fits in 128 bits if its top 65 bits agree
+    WideSum sum = {old, (old >> 127) ? -1 : 0};
+    wide_add_mag(&sum, mag, neg);
+    if (sum.hi != ((sum.lo >> 127) ? -1 : 0))
+    {
+      if (confirmed)
+      {
+        return sum.hi < 0 ? 3 : 4;
+      }
+      // either way, this leaves the current value in old
+      cas128(word, &old, old);
+      confirmed = 1;
+      continue;
+    }
+    if (cas128(word, &old, sum.lo))
+    {
+      *total = sum.lo;
+      return 0;
+    }
+    // a failed CAS reads the current value atomically
+    confirmed = 1;
+  }
+}
+
+// Raise the status flag for a failed update
+static int fail(int tag)
+{
+  fixedpoint_status_raise(1 << tag);
+  return tag;
+}
+
+// The value returned for a failed update: an error, or an overflow with
+// the largest magnitude
+static Fixedpoint failure(int tag)
+{
+  Fixedpoint result = from_mag(tag == 2 ? 0 : MAX_MAG, tag == 3);
+  result.tag = fail(tag);
+  return result;
+}
+
+FixedpointAtomic *fixedpoint_atomic_create(Fixedpoint initial)
+{
+  // the packed range is [-2^127, 2^127 - 1] in units of 2^-64
+  if (!fixedpoint_is_valid(initial) || get_mag(initial) > ((u128)1 << 127) - !get_neg(initial))
+  {
+    return NULL;
+  }
+  FixedpointAtomic *acc = aligned_alloc(_Alignof(FixedpointAtomic), sizeof(FixedpointAtomic));
+  if (acc)
+  {
+    acc->word = pack(initial);
+  }
+  return acc;
+}
+
+void fixedpoint_atomic_destroy(FixedpointAtomic *acc)
+{
+  free(acc);
+}
+
+Fixedpoint fixedpoint_atomic_load(FixedpointAtomic *acc)
+{
+  return unpack(load128(&acc->word));
+}
+
+Fixedpoint fixedpoint_atomic_add(FixedpointAtomic *acc, Fixedpoint val)
+{
+  if (!fixedpoint_is_valid(val))
+  {
+    return failure(2);
+  }
+  u128 total;
+  int tag = add_word(&acc->word, get_mag(val), get_neg(val), &total);
+  return tag ? failure(tag) : unpack(total);
+}
+
+Fixedpoint fixedpoint_atomic_sub(FixedpointAtomic *acc, Fixedpoint val)
+{
+  if (!fixedpoint_is_valid(val))
+  {
+    return failure(2);
+  }
+  u128 total;
+  int tag = add_word(&acc->word, get_mag(val), !get_neg(val), &total);
+  return tag ? failure(tag) : unpack(total);
+}
+
+FixedpointShardedSum *fixedpoint_sharded_create(int num_shards)
+{
+  if (num_shards <= 0)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_shards = cpus > 0 ? (int)cpus : 1;
+  }
+  FixedpointShardedSum *sum = malloc(sizeof(FixedpointShardedSum));
+  if (!sum)
+  {
+    return NULL;
+  }
+  sum->shards = aligned_alloc(CACHE_LINE_SIZE, (size_t)num_shards * sizeof(Shard));
+  if (!sum->shards)
+  {
+    free(sum);
+    return NULL;
+  }
+  for (int i = 0; i < num_shards; i++)
+  {
+    sum->shards[i].word = 0;
+  }
+  sum->num_shards = (unsigned)num_shards;
+  return sum;
+}
+
+void fixedpoint_sharded_destroy(FixedpointShardedSum *sum)
+{
+  if (sum)
+  {
+    free(sum->shards);
+    free(sum);
+  }
+}
+
+// The shard for the calling thread: the one for its CPU, or (if the CPU
+// isn't known) one picked round robin when the thread first asks
+static Shard *local_shard(FixedpointShardedSum *sum)
+{
+  static unsigned next_thread;
+  static _Thread_local unsigned thread_index = (unsigned)-1;
+  int cpu = sched_getcpu();
+  if (cpu >= 0)
+  {
+    return &sum->shards[(unsigned)cpu % sum->num_shards];
+  }
+  if (thread_index == (unsigned)-1)
+  {
+    thread_index = __atomic_fetch_add(&next_thread, 1, __ATOMIC_RELAXED);
+  }
+  return &sum->shards[thread_index % sum->num_shards];
+}
+
+int fixedpoint_sharded_add(FixedpointShardedSum *sum, Fixedpoint val)
+{
+  if (!fixedpoint_is_valid(val))
+  {
+    return fail(2);
+  }
+  u128 total;
+  int tag = add_word(&local_shard(sum)->word, get_mag(val), get_neg(val), &total);
+  return tag ? fail(tag) : 0;
+}
+
+int fixedpoint_sharded_sub(FixedpointShardedSum *sum, Fixedpoint val)
+{
+  if (!fixedpoint_is_valid(val))
+  {
+    return fail(2);
+  }
+  u128 total;
+  int tag = add_word(&local_shard(sum)->word, get_mag(val), !get_neg(val), &total);
+  return tag ? fail(tag) : 0;
+}
+
+Fixedpoint fixedpoint_sharded_load(FixedpointShardedSum *sum)
+{
+  WideSum total = {0, 0};
+  for (unsigned i = 0; i < sum->num_shards; i++)
+  {
+    u128 word = load128(&sum->shards[i].word);
+    WideSum shard = {word, (word >> 127) ? -1 : 0};
+    wide_add_sum(&total, shard);
+  }
+  Fixedpoint result = wide_get(total);
+  if (!fixedpoint_is_valid(result))
+  {
+    fixedpoint_status_raise(1 << result.tag);
+  }
+  return result;
+}
@@ -0,0 +1,132 @@
+#ifndef FIXEDPOINT_ATOMIC_H
+#define FIXEDPOINT_ATOMIC_H
+
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Lock-free accumulators, for totals which several threads add into.
+//
+// A FixedpointAtomic packs its total into a single 128 bit two's
+// complement word (whole part in the high 64 bits, fraction in the low 64
+// bits), which is updated with a 128 bit compare-and-swap (cmpxchg16b on
+// x86-64).  The packed form has one bit fewer than a Fixedpoint, so the
+// total of an accumulator must stay within (-2^63, 2^63) (including the
+// whole part -2^63 itself); an update which would take it out of that
+// range fails with an overflow, and leaves the total unchanged.
+//
+// Under heavy contention every update competes for the same cache line.
+// A FixedpointShardedSum spreads updates over one such word per CPU (each
+// on a cache line of its own), and adds up the words only when the total
+// is loaded.
+
+typedef struct FixedpointAtomic FixedpointAtomic;
+typedef struct FixedpointShardedSum FixedpointShardedSum;
+
+// Create an accumulator.
+//
+// Parameters:
+//   initial - the initial total
+//
+// Returns:
+//   the accumulator, to be freed with fixedpoint_atomic_destroy, or NULL
+//   if initial is invalid or out of range (or memory can't be allocated)
+FixedpointAtomic *fixedpoint_atomic_create(Fixedpoint initial);
+
+// Free an accumulator.
+//
+// Parameters:
+//   acc - the accumulator (may be NULL)
+void fixedpoint_atomic_destroy(FixedpointAtomic *acc);
+
+// Get the total of an accumulator.
+//
+// Parameters:
+//   acc - the accumulator
+//
+// Returns:
+//   the total
+Fixedpoint fixedpoint_atomic_load(FixedpointAtomic *acc);
+
+// Atomically add a value to the total of an accumulator.
+//
+// Parameters:
+//   acc - the accumulator
+//   val - the value to add
+//
+// Returns:
+//   the new total; or, leaving the total unchanged, an error value if val
+//   is invalid, or a negative or positive overflow value (as from
+//   fixedpoint_add) if the total would be out of range.  The status flag
+//   for an error or overflow is raised.
+Fixedpoint fixedpoint_atomic_add(FixedpointAtomic *acc, Fixedpoint val);
+
+// Atomically subtract a value from the total of an accumulator.
+//
+// Parameters:
+//   acc - the accumulator
+//   val - the value to subtract
+//
+// Returns:
+//   the new total, or an error or overflow value as for
+//   fixedpoint_atomic_add
+Fixedpoint fixedpoint_atomic_sub(FixedpointAtomic *acc, Fixedpoint val);
+
+// Create a sharded accumulator, with a total of zero.
+//
+// Parameters:
+//   num_shards - the number of shards, or 0 for one per online CPU
+//
+// Returns:
+//   the accumulator, to be freed with fixedpoint_sharded_destroy, or NULL
+//   if memory can't be allocated
+FixedpointShardedSum *fixedpoint_sharded_create(int num_shards);
+
+// Free a sharded accumulator.
+//
+// Parameters:
+//   sum - the accumulator (may be NULL)
+void fixedpoint_sharded_destroy(FixedpointShardedSum *sum);
+
+// Atomically add a value to the shard of the CPU the calling thread runs
+// on.  Each shard's total must stay in the range of a FixedpointAtomic.
+//
+// Parameters:
+//   sum - the accumulator
+//   val - the value to add
+//
+// Returns:
+//   0 if the value was added, or (leaving the total unchanged) 2 if val
+//   is invalid, or 3 or 4 if the shard would overflow negatively or
+//   positively.  The status flag for an error or overflow is raised.
+int fixedpoint_sharded_add(FixedpointShardedSum *sum, Fixedpoint val);
+
+// Atomically subtract a value, as for fixedpoint_sharded_add.
+//
+// Parameters:
+//   sum - the accumulator
+//   val - the value to subtract
+//
+// Returns:
+//   0 if the value was subtracted, or 2, 3 or 4 as for
+//   fixedpoint_sharded_add
+int fixedpoint_sharded_sub(FixedpointShardedSum *sum, Fixedpoint val);
+
+// Get the total of a sharded accumulator.  The shards are read one at a
+// time, so updates made during the call may or may not be included.
+//
+// Parameters:
+//   sum - the accumulator
+//
+// Returns:
+//   the total of the shards, or a negative or positive overflow value if
+//   it is out of the range of a Fixedpoint
+Fixedpoint fixedpoint_sharded_load(FixedpointShardedSum *sum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_ATOMIC_H
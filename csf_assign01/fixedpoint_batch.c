@@ -0,0 +1,220 @@
+#include <stddef.h>
+#include "fixedpoint.h"
+#include "fixedpoint_batch.h"
+#include "fixedpoint_internal.h"
+
+void fixedpoint_add_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_add(left[i], right[i]);
+  }
+}
+
+void fixedpoint_sub_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_sub(left[i], right[i]);
+  }
+}
+
+void fixedpoint_negate_n(const Fixedpoint *vals, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_negate(vals[i]);
+  }
+}
+
+void fixedpoint_halve_n(const Fixedpoint *vals, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_halve(vals[i]);
+  }
+}
+
+void fixedpoint_double_n(const Fixedpoint *vals, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_double(vals[i]);
+  }
+}
+
+void fixedpoint_mul_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_mul(left[i], right[i]);
+  }
+}
+
+size_t fixedpoint_add_sat_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    int saturated;
+    out[i] = add_sat(left[i], right[i], &saturated);
+    count += saturated;
+  }
+  return count;
+}
+
+size_t fixedpoint_sub_sat_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    int saturated;
+    out[i] = sub_sat(left[i], right[i], &saturated);
+    count += saturated;
+  }
+  return count;
+}
+
+size_t fixedpoint_double_sat_n(const Fixedpoint *vals, Fixedpoint *out, size_t n)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    int saturated;
+    out[i] = double_sat(vals[i], &saturated);
+    count += saturated;
+  }
+  return count;
+}
+
+size_t fixedpoint_mul_sat_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    int saturated;
+    out[i] = mul_sat(left[i], right[i], &saturated);
+    count += saturated;
+  }
+  return count;
+}
+
+void fixedpoint_halve_round_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    out[i] = fixedpoint_shr_round(vals[i], 1, mode);
+  }
+}
+
+void fixedpoint_shr_round_n(const Fixedpoint *vals, int n, int mode, Fixedpoint *out, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    out[i] = fixedpoint_shr_round(vals[i], n, mode);
+  }
+}
+
+void fixedpoint_mul_round_n(const Fixedpoint *left, const Fixedpoint *right, int mode, Fixedpoint *out, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    out[i] = fixedpoint_mul_round(left[i], right[i], mode);
+  }
+}
+
+void fixedpoint_div_round_n(const Fixedpoint *left, const Fixedpoint *right, int mode, Fixedpoint *out, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    out[i] = fixedpoint_div_round(left[i], right[i], mode);
+  }
+}
+
+void fixedpoint_compare_n(const Fixedpoint *left, const Fixedpoint *right, int *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_compare(left[i], right[i]);
+  }
+}
+
+void fixedpoint_create_from_dec_n(const char *const *strs, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_create_from_dec(strs[i]);
+  }
+}
+
+void fixedpoint_format_as_dec_n(const Fixedpoint *vals, char (*out)[FIXEDPOINT_DEC_BUF_SIZE], size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    fixedpoint_format_as_dec(vals[i], out[i], FIXEDPOINT_DEC_BUF_SIZE);
+  }
+}
+
+void fixedpoint_to_double_n(const Fixedpoint *vals, double *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_to_double(vals[i]);
+  }
+}
+
+void fixedpoint_to_float_n(const Fixedpoint *vals, float *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_to_float(vals[i]);
+  }
+}
+
+void fixedpoint_from_double_n(const double *vals, int mode, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_from_double(vals[i], mode);
+  }
+}
+
+void fixedpoint_from_float_n(const float *vals, int mode, Fixedpoint *out, size_t n)
+{
+  // every float is exactly representable as a double
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_from_double(vals[i], mode);
+  }
+}
+
+void fixedpoint_from_int64_n(const int64_t *vals, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_from_int64(vals[i]);
+  }
+}
+
+size_t fixedpoint_to_int64_n(const Fixedpoint *vals, int mode, int64_t *out, size_t n)
+{
+  return fixedpoint_to_scaled_n(vals, 1UL, mode, out, n);
+}
+
+void fixedpoint_from_scaled_n(const int64_t *vals, uint64_t scale, int mode, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_from_scaled(vals[i], scale, mode);
+  }
+}
+
+size_t fixedpoint_to_scaled_n(const Fixedpoint *vals, uint64_t scale, int mode, int64_t *out, size_t n)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    count += fixedpoint_to_scaled(vals[i], scale, mode, &out[i]) > 1;
+  }
+  return count;
+}
@@ -0,0 +1,155 @@
+#ifndef FIXEDPOINT_BATCH_H
+#define FIXEDPOINT_BATCH_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Batch versions of the Fixedpoint operations.  Each function applies the
+// corresponding scalar operation to n elements, so out[i] is exactly the
+// value the scalar operation would return for the i-th input(s).  The
+// output array may be the same as one of the input arrays.  Exceptional
+// results raise the same sticky status flags as the scalar operations, so
+// a caller can run a batch without checking the results and then call
+// fixedpoint_status_test once.
+
+// Compute out[i] = left[i] + right[i] for 0 <= i < n.
+//
+// Parameters:
+//   left - array of n left operands
+//   right - array of n right operands
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_add_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n);
+
+// Compute out[i] = left[i] - right[i] for 0 <= i < n.
+//
+// Parameters:
+//   left - array of n left operands
+//   right - array of n right operands
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_sub_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n);
+
+// Compute out[i] = -vals[i] for 0 <= i < n.
+//
+// Parameters:
+//   vals - array of n operands
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_negate_n(const Fixedpoint *vals, Fixedpoint *out, size_t n);
+
+// Compute out[i] = vals[i] / 2 for 0 <= i < n.
+//
+// Parameters:
+//   vals - array of n operands
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_halve_n(const Fixedpoint *vals, Fixedpoint *out, size_t n);
+
+// Compute out[i] = vals[i] * 2 for 0 <= i < n.
+//
+// Parameters:
+//   vals - array of n operands
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_double_n(const Fixedpoint *vals, Fixedpoint *out, size_t n);
+
+// Compute out[i] = left[i] * right[i] for 0 <= i < n.
+//
+// Parameters:
+//   left - array of n left operands
+//   right - array of n right operands
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_mul_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n);
+
+// Batch versions of the saturating operations.  out[i] is the result of
+// fixedpoint_add_sat (etc.) on the i-th input(s).  The loops have no
+// data-dependent branches, so they can be vectorized.
+//
+// Parameters:
+//   left, right (or vals) - arrays of n operands
+//   out - array of n results
+//   n - number of elements
+//
+// Returns:
+//   the number of results which were clamped
+size_t fixedpoint_add_sat_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n);
+size_t fixedpoint_sub_sat_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n);
+size_t fixedpoint_double_sat_n(const Fixedpoint *vals, Fixedpoint *out, size_t n);
+size_t fixedpoint_mul_sat_n(const Fixedpoint *left, const Fixedpoint *right, Fixedpoint *out, size_t n);
+
+// Batch versions of the rounding operations.  out[i] is the result of
+// fixedpoint_halve_round (etc.) on the i-th input(s), using the same
+// rounding mode for every element.
+//
+// Parameters:
+//   left, right (or vals) - arrays of n operands
+//   n (shr only) - shift amount
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//   out - array of n results
+//   count - number of elements
+void fixedpoint_halve_round_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t count);
+void fixedpoint_shr_round_n(const Fixedpoint *vals, int n, int mode, Fixedpoint *out, size_t count);
+void fixedpoint_mul_round_n(const Fixedpoint *left, const Fixedpoint *right, int mode, Fixedpoint *out, size_t count);
+void fixedpoint_div_round_n(const Fixedpoint *left, const Fixedpoint *right, int mode, Fixedpoint *out, size_t count);
+
+// Compute out[i] = fixedpoint_compare(left[i], right[i]) for 0 <= i < n.
+//
+// Parameters:
+//   left - array of n left operands
+//   right - array of n right operands
+//   out - array of n comparison results (-1, 0 or 1)
+//   n - number of elements
+void fixedpoint_compare_n(const Fixedpoint *left, const Fixedpoint *right, int *out, size_t n);
+
+// Convert n decimal strings with fixedpoint_create_from_dec.
+//
+// Parameters:
+//   strs - array of n NUL-terminated decimal strings
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_create_from_dec_n(const char *const *strs, Fixedpoint *out, size_t n);
+
+// Format n valid values with fixedpoint_format_as_dec.  Each string is
+// written to its own fixed-size slot, so a column of values is formatted
+// into a single allocation.
+//
+// Parameters:
+//   vals - array of n values
+//   out - array of n buffers of FIXEDPOINT_DEC_BUF_SIZE characters
+//   n - number of elements
+void fixedpoint_format_as_dec_n(const Fixedpoint *vals, char (*out)[FIXEDPOINT_DEC_BUF_SIZE], size_t n);
+
+// Batch conversions.  Each element is converted as by the corresponding
+// scalar function (fixedpoint_to_double, etc.), and exceptional results
+// raise the sticky status flags.
+//
+// Parameters:
+//   vals - array of n values to convert
+//   mode (where present) - one of the FIXEDPOINT_ROUND_ modes
+//   scale (where present) - the scale of the scaled integers
+//   out - array of n results
+//   n - number of elements
+//
+// Returns (conversions to integers only):
+//   the number of elements which overflowed (and were clamped), or which
+//   were inexact when mode is FIXEDPOINT_ROUND_EXACT
+void fixedpoint_to_double_n(const Fixedpoint *vals, double *out, size_t n);
+void fixedpoint_to_float_n(const Fixedpoint *vals, float *out, size_t n);
+void fixedpoint_from_double_n(const double *vals, int mode, Fixedpoint *out, size_t n);
+void fixedpoint_from_float_n(const float *vals, int mode, Fixedpoint *out, size_t n);
+void fixedpoint_from_int64_n(const int64_t *vals, Fixedpoint *out, size_t n);
+size_t fixedpoint_to_int64_n(const Fixedpoint *vals, int mode, int64_t *out, size_t n);
+void fixedpoint_from_scaled_n(const int64_t *vals, uint64_t scale, int mode, Fixedpoint *out, size_t n);
+size_t fixedpoint_to_scaled_n(const Fixedpoint *vals, uint64_t scale, int mode, int64_t *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_BATCH_H
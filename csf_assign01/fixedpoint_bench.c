@@ -0,0 +1,327 @@
+// Microbenchmarks for the Fixedpoint library.
+//
+// Usage:
+//   fixedpoint_bench [-n ops] [-t threads] [benchmark...]
+//
+// Each benchmark runs ops operations on each of threads threads (all
+// starting together) and prints the time per operation and the total
+// rate.  With no benchmark names, all of them are run.  The benchmarks
+// are:
+//   mutex   - adding into a shared total with fixedpoint_add, behind a
+//             mutex
+//   atomic  - adding into a shared FixedpointAtomic
+//   sharded - adding into a shared FixedpointShardedSum
+//   checked   - a loop of fixedpoint_add, fixedpoint_compare and
+//               fixedpoint_negate over a table of values, in each thread
+//   unchecked - the same loop with the unchecked variants
+//
+// Every benchmark checks its result, and the exit status is 1 if any
+// result was wrong.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "fixedpoint.h"
+#include "fixedpoint_atomic.h"
+#include "fixedpoint_unchecked.h"
+
+typedef struct
+{
+  const char *name;
+  // set up shared state, run by one thread before the workers start
+  void (*setup)(long num_threads, uint64_t num_ops);
+  // the timed work of one worker
+  void (*run)(long index, uint64_t num_ops);
+  // check the result and free the shared state; returns 1 if correct
+  int (*finish)(long num_threads, uint64_t num_ops);
+} Benchmark;
+
+// the value each worker of the accumulator benchmarks adds, and the
+// expected total
+static Fixedpoint increment;
+
+static Fixedpoint expected_total(long num_threads, uint64_t num_ops)
+{
+  uint64_t count = (uint64_t)num_threads * num_ops;
+  // increment is 1.5, so the total is count + count/2
+  return fixedpoint_create2(count + count / 2, (count & 1) ? 1UL << 63 : 0);
+}
+
+static pthread_mutex_t total_lock = PTHREAD_MUTEX_INITIALIZER;
+static Fixedpoint locked_total;
+
+static void mutex_setup(long num_threads, uint64_t num_ops)
+{
+  (void)num_threads;
+  (void)num_ops;
+  locked_total = fixedpoint_create(0UL);
+}
+
+static void mutex_run(long index, uint64_t num_ops)
+{
+  (void)index;
+  for (uint64_t i = 0; i < num_ops; i++)
+  {
+    pthread_mutex_lock(&total_lock);
+    locked_total = fixedpoint_add(locked_total, increment);
+    pthread_mutex_unlock(&total_lock);
+  }
+}
+
+static int mutex_finish(long num_threads, uint64_t num_ops)
+{
+  return fixedpoint_compare(locked_total, expected_total(num_threads, num_ops)) == 0;
+}
+
+static FixedpointAtomic *atomic_total;
+
+static void atomic_setup(long num_threads, uint64_t num_ops)
+{
+  (void)num_threads;
+  (void)num_ops;
+  atomic_total = fixedpoint_atomic_create(fixedpoint_create(0UL));
+}
+
+static void atomic_run(long index, uint64_t num_ops)
+{
+  (void)index;
+  for (uint64_t i = 0; i < num_ops; i++)
+  {
+    fixedpoint_atomic_add(atomic_total, increment);
+  }
+}
+
+static int atomic_finish(long num_threads, uint64_t num_ops)
+{
+  int ok = fixedpoint_compare(fixedpoint_atomic_load(atomic_total), expected_total(num_threads, num_ops)) == 0;
+  fixedpoint_atomic_destroy(atomic_total);
+  return ok;
+}
+
+static FixedpointShardedSum *sharded_total;
+
+static void sharded_setup(long num_threads, uint64_t num_ops)
+{
+  (void)num_threads;
+  (void)num_ops;
+  sharded_total = fixedpoint_sharded_create(0);
+}
+
+static void sharded_run(long index, uint64_t num_ops)
+{
+  (void)index;
+  for (uint64_t i = 0; i < num_ops; i++)
+  {
+    fixedpoint_sharded_add(sharded_total, increment);
+  }
+}
+
+static int sharded_finish(long num_threads, uint64_t num_ops)
+{
+  int ok = fixedpoint_compare(fixedpoint_sharded_load(sharded_total), expected_total(num_threads, num_ops)) == 0;
+  fixedpoint_sharded_destroy(sharded_total);
+  return ok;
+}
+
+// the operands of the checked and unchecked benchmarks: valid values of
+// either sign (including negative zero), small enough that the running
+// sum can't overflow
+#define TABLE_SIZE 1024
+static Fixedpoint table[TABLE_SIZE];
+static Fixedpoint limit;
+static Fixedpoint *loop_results;
+
+static void loop_setup(long num_threads, uint64_t num_ops)
+{
+  (void)num_ops;
+  uint64_t state = 0x9e3779b97f4a7c15UL;
+  for (int i = 0; i < TABLE_SIZE; i++)
+  {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    Fixedpoint val = fixedpoint_create2((state >> 40) & 0xffff, state << 8);
+    table[i] = (state >> 33) & 1 ? fixedpoint_negate(val) : val;
+  }
+  table[0] = fixedpoint_create_from_hex("-0");
+  limit = fixedpoint_create(0x100000UL);
+  loop_results = calloc(num_threads, sizeof(Fixedpoint));
+}
+
+// each operation is an add, a compare and (sometimes) a negate
+static Fixedpoint checked_loop(uint64_t num_ops)
+{
+  Fixedpoint acc = fixedpoint_create(0UL);
+  for (uint64_t i = 0; i < num_ops; i++)
+  {
+    acc = fixedpoint_add(acc, table[i % TABLE_SIZE]);
+    if (fixedpoint_compare(acc, limit) > 0)
+    {
+      acc = fixedpoint_negate(acc);
+    }
+  }
+  return acc;
+}
+
+static Fixedpoint unchecked_loop(uint64_t num_ops)
+{
+  Fixedpoint acc = fixedpoint_create(0UL);
+  for (uint64_t i = 0; i < num_ops; i++)
+  {
+    acc = fixedpoint_add_unchecked(acc, table[i % TABLE_SIZE]);
+    if (fixedpoint_compare_unchecked(acc, limit) > 0)
+    {
+      acc = fixedpoint_negate_unchecked(acc);
+    }
+  }
+  return acc;
+}
+
+static void checked_run(long index, uint64_t num_ops)
+{
+  loop_results[index] = checked_loop(num_ops);
+}
+
+static void unchecked_run(long index, uint64_t num_ops)
+{
+  loop_results[index] = unchecked_loop(num_ops);
+}
+
+static int loop_finish(long num_threads, uint64_t num_ops)
+{
+  // both loops must give the checked loop's result, bit for bit
+  Fixedpoint expected = checked_loop(num_ops);
+  int ok = 1;
+  for (long i = 0; i < num_threads; i++)
+  {
+    ok &= loop_results[i].integer == expected.integer && loop_results[i].fraction == expected.fraction &&
+          loop_results[i].tag == expected.tag;
+  }
+  free(loop_results);
+  return ok;
+}
+
+static const Benchmark benchmarks[] = {
+    {"mutex", mutex_setup, mutex_run, mutex_finish},
+    {"atomic", atomic_setup, atomic_run, atomic_finish},
+    {"sharded", sharded_setup, sharded_run, sharded_finish},
+    {"checked", loop_setup, checked_run, loop_finish},
+    {"unchecked", loop_setup, unchecked_run, loop_finish},
+};
+
+#define NUM_BENCHMARKS (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+typedef struct
+{
+  const Benchmark *bench;
+  long index;
+  uint64_t num_ops;
+  pthread_barrier_t *start;
+} Worker;
+
+static void *worker_main(void *arg)
+{
+  Worker *w = arg;
+  pthread_barrier_wait(w->start);
+  w->bench->run(w->index, w->num_ops);
+  return NULL;
+}
+
+// Run a benchmark, returning 1 if its result was correct
+static int run_benchmark(const Benchmark *bench, long num_threads, uint64_t num_ops)
+{
+  Worker *workers = calloc(num_threads, sizeof(Worker));
+  pthread_t *threads = calloc(num_threads, sizeof(pthread_t));
+  pthread_barrier_t start;
+  struct timespec start_time, end_time;
+
+  bench->setup(num_threads, num_ops);
+  pthread_barrier_init(&start, NULL, (unsigned)num_threads + 1);
+  for (long i = 0; i < num_threads; i++)
+  {
+    workers[i].bench = bench;
+    workers[i].index = i;
+    workers[i].num_ops = num_ops;
+    workers[i].start = &start;
+    pthread_create(&threads[i], NULL, worker_main, &workers[i]);
+  }
+  pthread_barrier_wait(&start);
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+  for (long i = 0; i < num_threads; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end_time);
+  pthread_barrier_destroy(&start);
+  int ok = bench->finish(num_threads, num_ops);
+
+  double secs = (end_time.tv_sec - start_time.tv_sec) + (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+  double total_ops = (double)num_ops * num_threads;
+  printf("%-10s %2ld thread(s): %8.2f ns/op per thread, %10.0f ops/s%s\n", bench->name, num_threads,
+         secs * 1e9 / num_ops, total_ops / secs, ok ? "" : "  WRONG RESULT");
+
+  free(threads);
+  free(workers);
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  uint64_t num_ops = 1000000;
+  long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:t:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      num_ops = strtoull(optarg, NULL, 0);
+      break;
+    case 't':
+      num_threads = strtol(optarg, NULL, 0);
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-n ops] [-t threads] [benchmark...]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (num_threads < 1)
+  {
+    num_threads = 1;
+  }
+  if (num_ops < 1)
+  {
+    num_ops = 1;
+  }
+  for (int i = optind; i < argc; i++)
+  {
+    size_t b = 0;
+    while (b < NUM_BENCHMARKS && strcmp(argv[i], benchmarks[b].name) != 0)
+    {
+      b++;
+    }
+    if (b == NUM_BENCHMARKS)
+    {
+      fprintf(stderr, "%s: unknown benchmark %s\n", argv[0], argv[i]);
+      return 2;
+    }
+  }
+  increment = fixedpoint_create_from_hex("1.8");
+
+  int all_ok = 1;
+  for (size_t b = 0; b < NUM_BENCHMARKS; b++)
+  {
+    int selected = optind == argc;
+    for (int i = optind; i < argc; i++)
+    {
+      selected |= strcmp(argv[i], benchmarks[b].name) == 0;
+    }
+    if (selected)
+    {
+      all_ok &= run_benchmark(&benchmarks[b], num_threads, num_ops);
+    }
+  }
+  return !all_ok;
+}
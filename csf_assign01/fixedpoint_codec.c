@@ -0,0 +1,378 @@
+#include "fixedpoint.h"
+#include "fixedpoint_internal.h"
+#include "fixedpoint_codec.h"
+
+#define BLOCK_SIZE FIXEDPOINT_CODEC_BLOCK_SIZE
+
+// The encoding is the value count (8 bytes), then the blocks.  A block
+// header is the bit width (0 to 128, or RAW_BLOCK), the shift, and the
+// reference (a sign byte and a 16 byte magnitude).  A packed block follows
+// its header with the packed distances in 64 bit words; a raw block, with
+// each value's integer, fraction and tag.
+#define COUNT_SIZE 8
+#define BLOCK_HEADER_SIZE 19
+#define RAW_BLOCK 0xFF
+#define RAW_VALUE_SIZE 17
+
+// enough words for a block of 128 bit distances, plus the two words the
+// unpacking reads past the end
+#define MAX_WORDS (2 * BLOCK_SIZE + 2)
+
+static void store64(unsigned char *p, uint64_t x)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    p[i] = (unsigned char)(x >> (8 * i));
+  }
+}
+
+static uint64_t load64(const unsigned char *p)
+{
+  uint64_t x = 0;
+  for (int i = 0; i < 8; i++)
+  {
+    x |= (uint64_t)p[i] << (8 * i);
+  }
+  return x;
+}
+
+// number of bits needed to hold x
+static int bit_width(u128 x)
+{
+  uint64_t hi = (uint64_t)(x >> 64), lo = (uint64_t)x;
+  if (hi)
+  {
+    return 128 - __builtin_clzll(hi);
+  }
+  return lo ? 64 - __builtin_clzll(lo) : 0;
+}
+
+// number of trailing zero bits of a nonzero x
+static int trailing_zeros(u128 x)
+{
+  uint64_t lo = (uint64_t)x;
+  return lo ? __builtin_ctzll(lo) : 64 + __builtin_ctzll((uint64_t)(x >> 64));
+}
+
+// Distance from the reference to a value at least as large.  Clears *fits
+// if it doesn't fit in 128 bits.
+static u128 distance(u128 ref, int ref_neg, u128 mag, int neg, int *fits)
+{
+  if (ref_neg == neg)
+  {
+    return neg ? ref - mag : mag - ref;
+  }
+  // the reference is negative and the value isn't
+  u128 dist = mag + ref;
+  *fits &= dist >= mag;
+  return dist;
+}
+
+static size_t encode_raw(const Fixedpoint *vals, size_t len, unsigned char *buf)
+{
+  unsigned char *p = buf + BLOCK_HEADER_SIZE;
+  for (int i = 0; i < BLOCK_HEADER_SIZE; i++)
+  {
+    buf[i] = 0;
+  }
+  buf[0] = RAW_BLOCK;
+  for (size_t i = 0; i < len; i++)
+  {
+    store64(p, vals[i].integer);
+    store64(p + 8, vals[i].fraction);
+    p[16] = (unsigned char)vals[i].tag;
+    p += RAW_VALUE_SIZE;
+  }
+  return p - buf;
+}
+
+static size_t encode_block(const Fixedpoint *vals, size_t len, unsigned char *buf)
+{
+  size_t min = 0;
+  for (size_t i = 0; i < len; i++)
+  {
+    if (!fixedpoint_is_valid(vals[i]))
+    {
+      return encode_raw(vals, len, buf);
+    }
+    if (fixedpoint_compare(vals[i], vals[min]) < 0)
+    {
+      min = i;
+    }
+  }
+
+  u128 ref = get_mag(vals[min]);
+  int ref_neg = get_neg(vals[min]);
+  u128 dist[BLOCK_SIZE];
+  u128 all = 0;
+  int fits = 1;
+  for (size_t i = 0; i < len; i++)
+  {
+    dist[i] = distance(ref, ref_neg, get_mag(vals[i]), get_neg(vals[i]), &fits);
+    all |= dist[i];
+  }
+  if (!fits)
+  {
+    return encode_raw(vals, len, buf);
+  }
+
+  int shift = all ? trailing_zeros(all) : 0;
+  int width = bit_width(all >> shift);
+  buf[0] = (unsigned char)width;
+  buf[1] = (unsigned char)shift;
+  buf[2] = (unsigned char)ref_neg;
+  store64(buf + 3, (uint64_t)ref);
+  store64(buf + 11, (uint64_t)(ref >> 64));
+
+  // pack the shifted distances, least significant bits first
+  uint64_t words[MAX_WORDS] = {0};
+  for (size_t i = 0; i < len; i++)
+  {
+    u128 v = dist[i] >> shift;
+    size_t pos = i * width;
+    size_t w = pos / 64;
+    int off = pos % 64;
+    words[w] |= (uint64_t)(v << off);
+    if (off + width > 64)
+    {
+      words[w + 1] |= (uint64_t)(v >> (64 - off));
+    }
+    if (off + width > 128)
+    {
+      words[w + 2] |= (uint64_t)(v >> (128 - off));
+    }
+  }
+  size_t num_words = (len * width + 63) / 64;
+  for (size_t w = 0; w < num_words; w++)
+  {
+    store64(buf + BLOCK_HEADER_SIZE + 8 * w, words[w]);
+  }
+  return BLOCK_HEADER_SIZE + 8 * num_words;
+}
+
+size_t fixedpoint_encode_bound(size_t n)
+{
+  size_t num_blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  return COUNT_SIZE + num_blocks * BLOCK_HEADER_SIZE + n * RAW_VALUE_SIZE;
+}
+
+size_t fixedpoint_encode(const Fixedpoint *vals, size_t n, unsigned char *buf)
+{
+  size_t size = COUNT_SIZE;
+  store64(buf, n);
+  for (size_t start = 0; start < n; start += BLOCK_SIZE)
+  {
+    size_t len = n - start < BLOCK_SIZE ? n - start : BLOCK_SIZE;
+    size += encode_block(vals + start, len, buf + size);
+  }
+  return size;
+}
+
+// A block being decoded
+typedef struct
+{
+  size_t len;
+  int raw;
+  int width;
+  int shift;
+  u128 ref;
+  int ref_neg;
+  const unsigned char *data;
+} Block;
+
+// Read the header of the next block of len values, which starts at p.
+//
+// Returns:
+//   the start of the block after it, or NULL if the block is malformed
+static const unsigned char *read_block(const unsigned char *p, const unsigned char *end, size_t len, Block *block)
+{
+  if (end - p < BLOCK_HEADER_SIZE)
+  {
+    return NULL;
+  }
+  block->len = len;
+  block->raw = p[0] == RAW_BLOCK;
+  block->width = p[0];
+  block->shift = p[1];
+  block->ref_neg = p[2];
+  block->ref = ((u128)load64(p + 11) << 64) | load64(p + 3);
+  block->data = p + BLOCK_HEADER_SIZE;
+
+  size_t data_size = block->raw ? len * RAW_VALUE_SIZE : 8 * ((len * block->width + 63) / 64);
+  // the shifted distances must fit in 128 bits
+  if ((!block->raw && (block->width > 128 || block->shift > 127 || block->width + block->shift > 128 ||
+                       block->ref_neg > 1)) ||
+      (size_t)(end - block->data) < data_size)
+  {
+    return NULL;
+  }
+  return block->data + data_size;
+}
+
+// Unpack the (still shifted) distances of a packed block.  The loop
+// for widths up to 64 bits, the common case, uses only 64 bit shifts.
+static void unpack(const Block *block, u128 *dist)
+{
+  uint64_t words[MAX_WORDS] = {0};
+  size_t num_words = (block->len * block->width + 63) / 64;
+  int width = block->width;
+
+  for (size_t w = 0; w < num_words; w++)
+  {
+    words[w] = load64(block->data + 8 * w);
+  }
+  if (width <= 64)
+  {
+    uint64_t mask = width == 64 ? ~0UL : (1UL << width) - 1;
+    for (size_t i = 0; i < block->len; i++)
+    {
+      size_t pos = i * width;
+      int off = pos % 64;
+      uint64_t v = words[pos / 64] >> off;
+      if (off != 0)
+      {
+        v |= words[pos / 64 + 1] << (64 - off);
+      }
+      dist[i] = v & mask;
+    }
+    return;
+  }
+  u128 mask = width == 128 ? MAX_MAG : ((u128)1 << width) - 1;
+  for (size_t i = 0; i < block->len; i++)
+  {
+    size_t pos = i * width;
+    size_t w = pos / 64;
+    int off = pos % 64;
+    u128 v = (((u128)words[w + 1] << 64) | words[w]) >> off;
+    if (off + width > 128)
+    {
+      v |= (u128)words[w + 2] << (128 - off);
+    }
+    dist[i] = v & mask;
+  }
+}
+
+size_t fixedpoint_encoded_count(const unsigned char *buf, size_t size)
+{
+  return size < COUNT_SIZE ? (size_t)-1 : load64(buf);
+}
+
+int fixedpoint_decode(const unsigned char *buf, size_t size, Fixedpoint *out)
+{
+  size_t n = fixedpoint_encoded_count(buf, size);
+  const unsigned char *p = buf + COUNT_SIZE, *end = buf + size;
+  if (n == (size_t)-1)
+  {
+    return 0;
+  }
+
+  for (size_t start = 0; start < n; start += BLOCK_SIZE)
+  {
+    Block block;
+    p = read_block(p, end, n - start < BLOCK_SIZE ? n - start : BLOCK_SIZE, &block);
+    if (!p)
+    {
+      return 0;
+    }
+    Fixedpoint *vals = out + start;
+
+    if (block.raw)
+    {
+      for (size_t i = 0; i < block.len; i++)
+      {
+        const unsigned char *v = block.data + i * RAW_VALUE_SIZE;
+        vals[i].integer = load64(v);
+        vals[i].fraction = load64(v + 8);
+        vals[i].tag = v[16];
+        if (vals[i].tag > 6)
+        {
+          return 0;
+        }
+      }
+      continue;
+    }
+
+    u128 dist[BLOCK_SIZE];
+    unpack(&block, dist);
+    for (size_t i = 0; i < block.len; i++)
+    {
+      u128 d = dist[i] << block.shift;
+      if (!block.ref_neg)
+      {
+        if (block.ref + d < d)
+        {
+          return 0;
+        }
+        vals[i] = from_mag(block.ref + d, 0);
+      }
+      else
+      {
+        vals[i] = d >= block.ref ? from_mag(d - block.ref, 0) : from_mag(block.ref - d, 1);
+      }
+    }
+  }
+  return 1;
+}
+
+Fixedpoint fixedpoint_encoded_sum(const unsigned char *buf, size_t size)
+{
+  size_t n = fixedpoint_encoded_count(buf, size);
+  const unsigned char *p = buf + COUNT_SIZE, *end = buf + size;
+  WideSum sum = {0, 0};
+  Fixedpoint err = fixedpoint_create(0UL);
+  err.tag = 2;
+
+  for (size_t start = 0; n != (size_t)-1 && start < n; start += BLOCK_SIZE)
+  {
+    Block block;
+    p = read_block(p, end, n - start < BLOCK_SIZE ? n - start : BLOCK_SIZE, &block);
+    if (!p)
+    {
+      break;
+    }
+
+    if (block.raw)
+    {
+      for (size_t i = 0; i < block.len; i++)
+      {
+        const unsigned char *v = block.data + i * RAW_VALUE_SIZE;
+        if (v[16] > 1)
+        {
+          fixedpoint_status_raise(1 << err.tag);
+          return err;
+        }
+        wide_add_mag(&sum, ((u128)load64(v) << 64) | load64(v + 8), v[16]);
+      }
+      continue;
+    }
+
+    wide_add_sum(&sum, wide_product(block.ref, block.ref_neg, block.len));
+
+    // the sum of the distances, shifted once at the end (it is less than
+    // 2^7 times the largest distance, so at most 136 bits)
+    u128 dist[BLOCK_SIZE];
+    unpack(&block, dist);
+    WideSum dist_sum = {0, 0};
+    for (size_t i = 0; i < block.len; i++)
+    {
+      wide_add_mag(&dist_sum, dist[i], 0);
+    }
+    if (block.shift > 0)
+    {
+      // the high word is only nonzero for shifts below 7
+      uint64_t high = block.shift < 64 ? (uint64_t)dist_sum.hi << block.shift : 0;
+      dist_sum.hi = (int64_t)(high | (uint64_t)(dist_sum.lo >> (128 - block.shift)));
+      dist_sum.lo <<= block.shift;
+    }
+    wide_add_sum(&sum, dist_sum);
+  }
+
+  if (n == (size_t)-1 || !p)
+  {
+    fixedpoint_status_raise(1 << err.tag);
+    return err;
+  }
+  Fixedpoint result = wide_get(sum);
+  fixedpoint_status_raise(1 << result.tag);
+  return result;
+}
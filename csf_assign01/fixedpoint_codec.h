@@ -0,0 +1,87 @@
+#ifndef FIXEDPOINT_CODEC_H
+#define FIXEDPOINT_CODEC_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compressed storage for columns of Fixedpoint values.
+//
+// Values are encoded in blocks of FIXEDPOINT_CODEC_BLOCK_SIZE.  Each block
+// stores its minimum as a reference value, and each value as its distance
+// from the reference (frame of reference).  The distances are shifted
+// right by the number of trailing zero bits they all have in common
+// (values with short fractions leave many), then packed using only as
+// many bits as the largest one needs.  A block of prices in a narrow range
+// with cent-sized steps packs into a few bytes per value instead of 24.
+//
+// Blocks containing values which aren't valid, or whose range is too wide
+// for 128 bit distances, are stored as is.  The encoding is little-endian
+// regardless of the host, so it can be written to disk.
+
+#define FIXEDPOINT_CODEC_BLOCK_SIZE 128
+
+// Get the largest number of bytes fixedpoint_encode can write for n
+// values.
+//
+// Parameters:
+//   n - the number of values
+//
+// Returns:
+//   the size of a buffer large enough to encode n values
+size_t fixedpoint_encode_bound(size_t n);
+
+// Encode an array of values.
+//
+// Parameters:
+//   vals - array of n values
+//   n - number of values
+//   buf - buffer of at least fixedpoint_encode_bound(n) bytes
+//
+// Returns:
+//   the number of bytes written to buf
+size_t fixedpoint_encode(const Fixedpoint *vals, size_t n, unsigned char *buf);
+
+// Get the number of values in encoded data.
+//
+// Parameters:
+//   buf - the encoded data
+//   size - the size of the encoded data in bytes
+//
+// Returns:
+//   the number of values, or (size_t)-1 if the data is too short
+size_t fixedpoint_encoded_count(const unsigned char *buf, size_t size);
+
+// Decode encoded data.
+//
+// Parameters:
+//   buf - the encoded data
+//   size - the size of the encoded data in bytes
+//   out - array of fixedpoint_encoded_count(buf, size) values
+//
+// Returns:
+//   1 if the data was decoded, 0 if it is malformed
+int fixedpoint_decode(const unsigned char *buf, size_t size, Fixedpoint *out);
+
+// Compute the sum of the encoded values without decoding them: each
+// block contributes its reference times its length plus the sum of its
+// packed distances.  The sum is exact, as by fixedpoint_scan_inclusive_n.
+//
+// Parameters:
+//   buf - the encoded data
+//   size - the size of the encoded data in bytes
+//
+// Returns:
+//   the sum; an overflow value if it is out of range; or a value for
+//   which fixedpoint_is_err returns true if the data is malformed or
+//   contains values which aren't valid
+Fixedpoint fixedpoint_encoded_sum(const unsigned char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_CODEC_H
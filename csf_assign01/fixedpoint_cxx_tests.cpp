@@ -0,0 +1,172 @@
+#include <cstdio>
+#include <cstdlib>
+#include "fixedpoint.h"
+#include "fixedpoint.hpp"
+#include "fixedpoint_literals.hpp"
+#include "tctest.h"
+
+// Tests for the C++ front end (fixedpoint.hpp)
+
+typedef struct
+{
+  fixedpoint::Column a;
+  fixedpoint::Column b;
+  fixedpoint::Column c;
+} TestObjs;
+
+TestObjs *setup(void);
+void cleanup(TestObjs *objs);
+
+void test_lazy_chain(TestObjs *objs);
+void test_in_place(TestObjs *objs);
+void test_scalar_operand(TestObjs *objs);
+void test_exceptional_values(TestObjs *objs);
+void test_literals(TestObjs *objs);
+
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+  {
+    tctest_testname_to_execute = argv[1];
+  }
+
+  TEST_INIT();
+
+  TEST(test_lazy_chain);
+  TEST(test_in_place);
+  TEST(test_scalar_operand);
+  TEST(test_exceptional_values);
+  TEST(test_literals);
+
+  TEST_FINI();
+}
+
+TestObjs *setup(void)
+{
+  TestObjs *objs = new TestObjs;
+
+  objs->a = fixedpoint::Column(100);
+  objs->b = fixedpoint::Column(100);
+  objs->c = fixedpoint::Column(100);
+  for (uint64_t i = 0; i < 100; i++)
+  {
+    objs->a[i] = fixedpoint_create2(i, i << 60);
+    objs->b[i] = fixedpoint_negate(fixedpoint_create2(i * 3, i << 50));
+    objs->c[i] = fixedpoint_create2(7, 0x8000000000000000UL);
+  }
+
+  return objs;
+}
+
+void cleanup(TestObjs *objs)
+{
+  delete objs;
+}
+
+void test_lazy_chain(TestObjs *objs)
+{
+  auto r = (objs->a + objs->b).halve() - objs->c;
+  ASSERT(100 == r.size());
+
+  fixedpoint::Column result = r;
+  ASSERT(100 == result.size());
+  for (size_t i = 0; i < result.size(); i++)
+  {
+    Fixedpoint expected = fixedpoint_sub(fixedpoint_halve(fixedpoint_add(objs->a[i], objs->b[i])), objs->c[i]);
+    ASSERT(expected.tag == result[i].tag);
+    ASSERT(expected.integer == result[i].integer);
+    ASSERT(expected.fraction == result[i].fraction);
+  }
+
+  // a tree can be evaluated into a plain array too
+  Fixedpoint out[100];
+  fixedpoint::evaluate(-(objs->a * objs->c).doubled(), out);
+  for (size_t i = 0; i < 100; i++)
+  {
+    Fixedpoint expected = fixedpoint_negate(fixedpoint_double(fixedpoint_mul(objs->a[i], objs->c[i])));
+    ASSERT(0 == fixedpoint_compare(expected, out[i]));
+  }
+}
+
+void test_in_place(TestObjs *objs)
+{
+  fixedpoint::Column before = objs->a;
+
+  objs->a = objs->a + objs->a.halve();
+  for (size_t i = 0; i < 100; i++)
+  {
+    ASSERT(0 == fixedpoint_compare(objs->a[i], fixedpoint_add(before[i], fixedpoint_halve(before[i]))));
+  }
+
+  // assigning a tree of a different length
+  fixedpoint::Column empty;
+  empty = objs->b - objs->c;
+  ASSERT(100 == empty.size());
+  ASSERT(0 == fixedpoint_compare(empty[1], fixedpoint_sub(objs->b[1], objs->c[1])));
+}
+
+void test_scalar_operand(TestObjs *objs)
+{
+  fixedpoint::Column result = objs->a * fixedpoint_create(2UL) + fixedpoint_create_from_hex("0.8");
+  for (size_t i = 0; i < 100; i++)
+  {
+    Fixedpoint expected = fixedpoint_add(fixedpoint_double(objs->a[i]), fixedpoint_create_from_hex("0.8"));
+    ASSERT(0 == fixedpoint_compare(expected, result[i]));
+  }
+}
+
+void test_exceptional_values(TestObjs *objs)
+{
+  (void)objs;
+  fixedpoint::Column big{fixedpoint_create2(0xFFFFFFFFFFFFFFFFUL, 0UL), fixedpoint_create2(0UL, 1UL)};
+
+  fixedpoint::Column result = big.doubled();
+  ASSERT(fixedpoint_is_overflow_pos(result[0]));
+  result = big.halve();
+  ASSERT(fixedpoint_is_underflow_pos(result[1]));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+using namespace fixedpoint::literals;
+
+// the literals are constants
+static_assert("1.8"_fx.integer == 1 && "1.8"_fx.fraction == 0x8000000000000000UL && "1.8"_fx.tag == 0,
+              "1.8 is folded");
+static_assert("-0.0004"_fx.fraction == 0x0004000000000000UL && "-0.0004"_fx.tag == 1, "-0.0004 is folded");
+static_assert("-."_fx.tag == 0 && "-"_fx.tag == 1, "special cases match fixedpoint_create_from_hex");
+constexpr Fixedpoint table[] = {"0"_fx, "ffffffffffffffff.ffffffffffffffff"_fx, "-DeadBeef.cafe"_fx};
+
+void test_literals(TestObjs *)
+{
+  // every literal matches the runtime parser, bit for bit
+  const Fixedpoint lits[] = {"0"_fx,
+                             "1.8"_fx,
+                             "-0.0004"_fx,
+                             "-0"_fx,
+                             "."_fx,
+                             "-."_fx,
+                             ""_fx,
+                             "-"_fx,
+                             "1."_fx,
+                             ".1"_fx,
+                             "ffffffffffffffff.ffffffffffffffff"_fx,
+                             "0000000000000001.1000000000000000"_fx,
+                             "-DeadBeef.cafe"_fx};
+  const char *strings[] = {"0", "1.8", "-0.0004", "-0", ".", "-.", "", "-", "1.", ".1",
+                           "ffffffffffffffff.ffffffffffffffff", "0000000000000001.1000000000000000", "-DeadBeef.cafe"};
+  for (std::size_t i = 0; i < sizeof(lits) / sizeof(lits[0]); i++)
+  {
+    Fixedpoint expected = fixedpoint_create_from_hex(strings[i]);
+    ASSERT(lits[i].integer == expected.integer);
+    ASSERT(lits[i].fraction == expected.fraction);
+    ASSERT(lits[i].tag == expected.tag);
+  }
+  ASSERT(0 == fixedpoint_compare(table[2], fixedpoint_create_from_hex("-deadbeef.cafe")));
+
+  // the parser itself, evaluated at run time, rejects what the runtime
+  // parser rejects
+  ASSERT(fixedpoint_is_err(fixedpoint::detail::parse_hex_literal("1.2.3", 5)));
+  ASSERT(fixedpoint_is_err(fixedpoint::detail::parse_hex_literal("12345678901234567", 17)));
+  ASSERT(fixedpoint_is_err(fixedpoint::detail::parse_hex_literal("0.12345678901234567", 19)));
+  ASSERT(fixedpoint_is_err(fixedpoint::detail::parse_hex_literal("x", 1)));
+}
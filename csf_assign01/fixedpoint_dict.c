@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include "fixedpoint.h"
+#include "fixedpoint_internal.h"
+#include "fixedpoint_dict.h"
+
+struct FixedpointDict
+{
+  Fixedpoint *vals;
+  size_t size;
+};
+
+// Open addressing hash table used while building a dictionary.  Each
+// slot holds 1 + the index of a distinct value, or 0 if it is empty.
+typedef struct
+{
+  uint32_t *slots;
+  size_t mask;
+} HashTable;
+
+static size_t hash_value(Fixedpoint val)
+{
+  uint64_t h = val.integer * 0x9E3779B97F4A7C15UL ^ val.fraction ^ (uint64_t)val.tag;
+  h *= 0xBF58476D1CE4E5B9UL;
+  return h ^ (h >> 31);
+}
+
+static int same_value(Fixedpoint a, Fixedpoint b)
+{
+  return a.integer == b.integer && a.fraction == b.fraction && a.tag == b.tag;
+}
+
+// Find the slot holding val, or the empty slot where it would go
+static uint32_t *find_slot(const HashTable *table, const Fixedpoint *distinct, Fixedpoint val)
+{
+  size_t i = hash_value(val) & table->mask;
+  while (table->slots[i] != 0 && !same_value(distinct[table->slots[i] - 1], val))
+  {
+    i = (i + 1) & table->mask;
+  }
+  return &table->slots[i];
+}
+
+static int grow(HashTable *table, const Fixedpoint *distinct, size_t num_distinct)
+{
+  HashTable bigger;
+  bigger.mask = table->mask * 2 + 1;
+  bigger.slots = calloc(bigger.mask + 1, sizeof(uint32_t));
+  if (!bigger.slots)
+  {
+    return 0;
+  }
+  for (size_t d = 0; d < num_distinct; d++)
+  {
+    *find_slot(&bigger, distinct, distinct[d]) = (uint32_t)(d + 1);
+  }
+  free(table->slots);
+  *table = bigger;
+  return 1;
+}
+
+// A distinct value and the code it had before sorting
+typedef struct
+{
+  Fixedpoint val;
+  uint32_t first_code;
+} Entry;
+
+static int compare_entries(const void *a, const void *b)
+{
+  return fixedpoint_compare(((const Entry *)a)->val, ((const Entry *)b)->val);
+}
+
+FixedpointDict *fixedpoint_dict_build(const Fixedpoint *vals, size_t n, uint32_t *codes)
+{
+  FixedpointDict *dict = calloc(1, sizeof(FixedpointDict));
+  HashTable table = {calloc(64, sizeof(uint32_t)), 63};
+  size_t cap = 16, num_distinct = 0;
+  Fixedpoint *distinct = malloc(cap * sizeof(Fixedpoint));
+  uint32_t *remap = NULL;
+  Entry *entries = NULL;
+  int ok = dict && table.slots && distinct;
+
+  // First pass: give each distinct value a code in order of appearance.
+  // Values are stored in canonical form, so a negative zero matches zero.
+  for (size_t i = 0; ok && i < n; i++)
+  {
+    if (!fixedpoint_is_valid(vals[i]))
+    {
+      ok = 0;
+      break;
+    }
+    Fixedpoint val = from_mag(get_mag(vals[i]), get_neg(vals[i]));
+    uint32_t *slot = find_slot(&table, distinct, val);
+    uint32_t code = *slot - 1;
+    if (*slot == 0)
+    {
+      if (num_distinct == UINT32_MAX)
+      {
+        ok = 0;
+        break;
+      }
+      if (num_distinct == cap)
+      {
+        Fixedpoint *more = realloc(distinct, 2 * cap * sizeof(Fixedpoint));
+        if (!more)
+        {
+          ok = 0;
+          break;
+        }
+        distinct = more;
+        cap *= 2;
+      }
+      code = (uint32_t)num_distinct;
+      distinct[num_distinct++] = val;
+      *slot = code + 1;
+      // keep the table at most half full
+      if (2 * num_distinct > table.mask && !grow(&table, distinct, num_distinct))
+      {
+        ok = 0;
+        break;
+      }
+    }
+    if (codes)
+    {
+      codes[i] = code;
+    }
+  }
+  free(table.slots);
+
+  // Second pass: sort the distinct values, and renumber the codes
+  if (ok)
+  {
+    entries = malloc((num_distinct + 1) * sizeof(Entry));
+    remap = malloc((num_distinct + 1) * sizeof(uint32_t));
+    dict->vals = malloc((num_distinct + 1) * sizeof(Fixedpoint));
+    ok = entries && remap && dict->vals;
+  }
+  if (ok)
+  {
+    for (size_t d = 0; d < num_distinct; d++)
+    {
+      entries[d].val = distinct[d];
+      entries[d].first_code = (uint32_t)d;
+    }
+    qsort(entries, num_distinct, sizeof(Entry), compare_entries);
+    for (size_t d = 0; d < num_distinct; d++)
+    {
+      dict->vals[d] = entries[d].val;
+      remap[entries[d].first_code] = (uint32_t)d;
+    }
+    dict->size = num_distinct;
+    for (size_t i = 0; codes && i < n; i++)
+    {
+      codes[i] = remap[codes[i]];
+    }
+  }
+
+  free(distinct);
+  free(entries);
+  free(remap);
+  if (!ok)
+  {
+    fixedpoint_dict_destroy(dict);
+    return NULL;
+  }
+  return dict;
+}
+
+void fixedpoint_dict_destroy(FixedpointDict *dict)
+{
+  if (dict)
+  {
+    free(dict->vals);
+    free(dict);
+  }
+}
+
+size_t fixedpoint_dict_size(const FixedpointDict *dict)
+{
+  return dict->size;
+}
+
+const Fixedpoint *fixedpoint_dict_values(const FixedpointDict *dict)
+{
+  return dict->vals;
+}
+
+uint32_t fixedpoint_dict_lower_bound(const FixedpointDict *dict, Fixedpoint val)
+{
+  size_t lo = 0, hi = dict->size;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (fixedpoint_compare(dict->vals[mid], val) < 0)
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return (uint32_t)lo;
+}
+
+int fixedpoint_dict_lookup(const FixedpointDict *dict, Fixedpoint val, uint32_t *code)
+{
+  uint32_t c = fixedpoint_dict_lower_bound(dict, val);
+  if (c == dict->size || fixedpoint_compare(dict->vals[c], val) != 0)
+  {
+    return 0;
+  }
+  *code = c;
+  return 1;
+}
+
+void fixedpoint_dict_decode(const FixedpointDict *dict, const uint32_t *codes, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = dict->vals[codes[i]];
+  }
+}
+
+size_t fixedpoint_dict_select_range(const FixedpointDict *dict, const uint32_t *codes, size_t n, Fixedpoint lo,
+                                    Fixedpoint hi, size_t *rows)
+{
+  uint32_t lo_code = fixedpoint_dict_lower_bound(dict, lo);
+  uint32_t hi_code = fixedpoint_dict_lower_bound(dict, hi);
+  size_t count = 0;
+
+  // one unsigned comparison tests lo_code <= code < hi_code, and the row
+  // is written unconditionally, so the loop has no data-dependent branches
+  uint32_t width = hi_code > lo_code ? hi_code - lo_code : 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    rows[count] = i;
+    count += (uint32_t)(codes[i] - lo_code) < width;
+  }
+  return count;
+}
+
+Fixedpoint fixedpoint_dict_sum(const FixedpointDict *dict, const uint32_t *codes, size_t n)
+{
+  uint64_t *counts = calloc(dict->size + 1, sizeof(uint64_t));
+  WideSum sum = {0, 0};
+  Fixedpoint result;
+
+  if (!counts)
+  {
+    result = fixedpoint_create(0UL);
+    result.tag = 2;
+    fixedpoint_status_raise(1 << result.tag);
+    return result;
+  }
+  for (size_t i = 0; i < n; i++)
+  {
+    counts[codes[i]]++;
+  }
+  for (size_t d = 0; d < dict->size; d++)
+  {
+    wide_add_sum(&sum, wide_product(get_mag(dict->vals[d]), get_neg(dict->vals[d]), counts[d]));
+  }
+  free(counts);
+  result = wide_get(sum);
+  fixedpoint_status_raise(1 << result.tag);
+  return result;
+}
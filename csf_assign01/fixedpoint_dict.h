@@ -0,0 +1,130 @@
+#ifndef FIXEDPOINT_DICT_H
+#define FIXEDPOINT_DICT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Dictionary encoding for columns with few distinct values.
+//
+// A dictionary holds the distinct values of a column, sorted in
+// fixedpoint_compare order, and the column is stored as an array of
+// codes (indices into the dictionary).  Since the dictionary is sorted,
+// codes compare the same way as the values they stand for, so equality
+// tests and range filters can work on the codes alone, and an aggregate
+// only needs to look at each distinct value once.
+//
+// The dictionary is built with a hash table, so building it takes time
+// proportional to the column length plus the time to sort the distinct
+// values.  Dictionaries hold valid values only.
+
+typedef struct FixedpointDict FixedpointDict;
+
+// Build the dictionary of a column, and encode the column.
+//
+// Parameters:
+//   vals - array of n valid values
+//   n - number of values
+//   codes - array of n codes to fill in (may be NULL)
+//
+// Returns:
+//   the dictionary, to be freed with fixedpoint_dict_destroy, or NULL if
+//   a value isn't valid or memory couldn't be allocated
+FixedpointDict *fixedpoint_dict_build(const Fixedpoint *vals, size_t n, uint32_t *codes);
+
+// Free a dictionary.
+//
+// Parameters:
+//   dict - the dictionary (may be NULL)
+void fixedpoint_dict_destroy(FixedpointDict *dict);
+
+// Get the number of distinct values in a dictionary.
+//
+// Parameters:
+//   dict - the dictionary
+//
+// Returns:
+//   the number of values; codes are less than this
+size_t fixedpoint_dict_size(const FixedpointDict *dict);
+
+// Get the values in a dictionary.
+//
+// Parameters:
+//   dict - the dictionary
+//
+// Returns:
+//   the array of fixedpoint_dict_size(dict) values, in increasing order,
+//   so code c stands for the value at index c
+const Fixedpoint *fixedpoint_dict_values(const FixedpointDict *dict);
+
+// Find the code of a value.
+//
+// Parameters:
+//   dict - the dictionary
+//   val - a valid Fixedpoint value
+//   code - set to the code of val, if it is in the dictionary
+//
+// Returns:
+//   1 if val is in the dictionary, 0 if not
+int fixedpoint_dict_lookup(const FixedpointDict *dict, Fixedpoint val, uint32_t *code);
+
+// Find where a value would go in a dictionary.  The codes of the values
+// in a range lo <= v < hi are those from fixedpoint_dict_lower_bound(lo)
+// up to (not including) fixedpoint_dict_lower_bound(hi).
+//
+// Parameters:
+//   dict - the dictionary
+//   val - a valid Fixedpoint value
+//
+// Returns:
+//   the smallest code whose value is at least val, or the dictionary size
+//   if there is none
+uint32_t fixedpoint_dict_lower_bound(const FixedpointDict *dict, Fixedpoint val);
+
+// Decode a column.
+//
+// Parameters:
+//   dict - the dictionary
+//   codes - array of n codes
+//   out - array of n values
+//   n - number of values
+void fixedpoint_dict_decode(const FixedpointDict *dict, const uint32_t *codes, Fixedpoint *out, size_t n);
+
+// Find the rows of a column whose values are in a range, using only the
+// codes.
+//
+// Parameters:
+//   dict - the dictionary
+//   codes - array of n codes
+//   n - number of rows
+//   lo - the smallest value to select
+//   hi - the value above the largest value to select
+//   rows - array filled in with the indices of the selected rows (room
+//          for n indices is always enough)
+//
+// Returns:
+//   the number of rows selected
+size_t fixedpoint_dict_select_range(const FixedpointDict *dict, const uint32_t *codes, size_t n, Fixedpoint lo,
+                                    Fixedpoint hi, size_t *rows);
+
+// Compute the sum of a column by counting each code, then adding each
+// distinct value times its count.  The sum is exact.
+//
+// Parameters:
+//   dict - the dictionary
+//   codes - array of n codes
+//   n - number of rows
+//
+// Returns:
+//   the sum, or an overflow value if it is out of range
+Fixedpoint fixedpoint_dict_sum(const FixedpointDict *dict, const uint32_t *codes, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_DICT_H
@@ -0,0 +1,457 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "fixedpoint.h"
+#include "fixedpoint_batch.h"
+#include "fixedpoint_expr.h"
+
+// instruction opcodes
+enum
+{
+  OP_COL,    // reg[dst] = column a
+  OP_CONST,  // reg[dst] = constant a
+  OP_ADD,    // reg[dst] = reg[a] + reg[b]
+  OP_SUB,    // reg[dst] = reg[a] - reg[b]
+  OP_MUL,    // reg[dst] = reg[a] * reg[b]
+  OP_DIV,    // reg[dst] = reg[a] / reg[b]
+  OP_NEG,    // reg[dst] = -reg[a]
+  OP_HALVE,  // reg[dst] = reg[a] / 2
+  OP_DOUBLE, // reg[dst] = reg[a] * 2
+};
+
+typedef struct
+{
+  unsigned char op;
+  unsigned char dst;
+  unsigned short a;
+  unsigned short b;
+} Instr;
+
+struct FixedpointExpr
+{
+  Instr *code;
+  int code_len;
+  Fixedpoint *consts;
+  int num_consts;
+  int num_regs;
+  int mode;
+};
+
+// Compiler state.  Registers are allocated like a stack: the value of a
+// subexpression goes in the register at the current depth.
+typedef struct
+{
+  const char *src;
+  const char *pos;
+  const char *const *col_names;
+  int num_cols;
+  FixedpointExpr *expr;
+  int code_cap;
+  int consts_cap;
+  // current nesting of unary minuses and parentheses, which the parser
+  // recurses on
+  int depth;
+  int failed;
+} Compiler;
+
+static int parse_expr(Compiler *c, int dst);
+
+static void skip_space(Compiler *c)
+{
+  while (isspace((unsigned char)*c->pos))
+  {
+    c->pos++;
+  }
+}
+
+static void emit(Compiler *c, int op, int dst, int a, int b)
+{
+  FixedpointExpr *expr = c->expr;
+  if (dst >= FIXEDPOINT_EXPR_MAX_REGS)
+  {
+    c->failed = 1;
+    return;
+  }
+  if (expr->code_len == c->code_cap)
+  {
+    int cap = c->code_cap ? c->code_cap * 2 : 16;
+    Instr *code = realloc(expr->code, cap * sizeof(Instr));
+    if (!code)
+    {
+      // the old code is still freed by fixedpoint_expr_destroy
+      c->failed = 1;
+      return;
+    }
+    expr->code = code;
+    c->code_cap = cap;
+  }
+  Instr instr = {(unsigned char)op, (unsigned char)dst, (unsigned short)a, (unsigned short)b};
+  expr->code[expr->code_len++] = instr;
+  if (dst + 1 > expr->num_regs)
+  {
+    expr->num_regs = dst + 1;
+  }
+}
+
+static int add_const(Compiler *c, Fixedpoint val)
+{
+  FixedpointExpr *expr = c->expr;
+  if (expr->num_consts == c->consts_cap)
+  {
+    int cap = c->consts_cap ? c->consts_cap * 2 : 8;
+    Fixedpoint *consts = realloc(expr->consts, cap * sizeof(Fixedpoint));
+    if (!consts)
+    {
+      c->failed = 1;
+      return 0;
+    }
+    expr->consts = consts;
+    c->consts_cap = cap;
+  }
+  expr->consts[expr->num_consts] = val;
+  return expr->num_consts++;
+}
+
+// Enter a nested unary minus or parenthesis, failing (at the current
+// position) if that is too deep.
+static int enter_nested(Compiler *c)
+{
+  if (c->depth == FIXEDPOINT_EXPR_MAX_DEPTH)
+  {
+    c->failed = 1;
+    return 0;
+  }
+  c->depth++;
+  return 1;
+}
+
+// primary := number | name | '(' expr ')'
+static int parse_primary(Compiler *c, int dst)
+{
+  skip_space(c);
+  const char *start = c->pos;
+
+  if (*c->pos == '(')
+  {
+    if (!enter_nested(c))
+    {
+      return 0;
+    }
+    c->pos++;
+    int ok = parse_expr(c, dst);
+    c->depth--;
+    if (!ok)
+    {
+      return 0;
+    }
+    skip_space(c);
+    if (*c->pos != ')')
+    {
+      return 0;
+    }
+    c->pos++;
+    return 1;
+  }
+
+  if (isdigit((unsigned char)*c->pos) || *c->pos == '.')
+  {
+    int hex = c->pos[0] == '0' && (c->pos[1] == 'x' || c->pos[1] == 'X');
+    if (hex)
+    {
+      c->pos += 2;
+    }
+    const char *digits = c->pos;
+    while ((hex ? isxdigit((unsigned char)*c->pos) : isdigit((unsigned char)*c->pos)) || *c->pos == '.')
+    {
+      c->pos++;
+    }
+    char literal[64];
+    size_t len = c->pos - digits;
+    if (len == 0 || len >= sizeof(literal))
+    {
+      c->pos = start;
+      return 0;
+    }
+    memcpy(literal, digits, len);
+    literal[len] = '\0';
+    Fixedpoint val = hex ? fixedpoint_create_from_hex(literal) : fixedpoint_create_from_dec(literal);
+    if (!fixedpoint_is_valid(val))
+    {
+      c->pos = start;
+      return 0;
+    }
+    int index = add_const(c, val);
+    if (c->failed)
+    {
+      return 0;
+    }
+    emit(c, OP_CONST, dst, index, 0);
+    return 1;
+  }
+
+  if (isalpha((unsigned char)*c->pos) || *c->pos == '_')
+  {
+    while (isalnum((unsigned char)*c->pos) || *c->pos == '_')
+    {
+      c->pos++;
+    }
+    size_t len = c->pos - start;
+    for (int i = 0; i < c->num_cols; i++)
+    {
+      if (strlen(c->col_names[i]) == len && strncmp(c->col_names[i], start, len) == 0)
+      {
+        emit(c, OP_COL, dst, i, 0);
+        return 1;
+      }
+    }
+    c->pos = start;
+    return 0;
+  }
+  return 0;
+}
+
+// unary := '-' unary | primary
+static int parse_unary(Compiler *c, int dst)
+{
+  skip_space(c);
+  if (*c->pos == '-')
+  {
+    if (!enter_nested(c))
+    {
+      return 0;
+    }
+    c->pos++;
+    int ok = parse_unary(c, dst);
+    c->depth--;
+    if (!ok)
+    {
+      return 0;
+    }
+    emit(c, OP_NEG, dst, dst, 0);
+    return 1;
+  }
+  return parse_primary(c, dst);
+}
+
+// Is the last instruction a load of the constant 2 into reg?  If so,
+// the operation using it can be replaced by a halve or double.
+static int last_is_const_two(Compiler *c, int reg)
+{
+  FixedpointExpr *expr = c->expr;
+  if (expr->code_len == 0)
+  {
+    return 0;
+  }
+  Instr last = expr->code[expr->code_len - 1];
+  return last.op == OP_CONST && last.dst == reg &&
+         fixedpoint_compare(expr->consts[last.a], fixedpoint_create(2UL)) == 0;
+}
+
+// term := unary (('*' | '/') unary)*
+static int parse_term(Compiler *c, int dst)
+{
+  if (!parse_unary(c, dst))
+  {
+    return 0;
+  }
+  for (;;)
+  {
+    skip_space(c);
+    char op = *c->pos;
+    if (op != '*' && op != '/')
+    {
+      return 1;
+    }
+    c->pos++;
+    if (!parse_unary(c, dst + 1))
+    {
+      return 0;
+    }
+    if (last_is_const_two(c, dst + 1))
+    {
+      c->expr->code_len--;
+      emit(c, op == '*' ? OP_DOUBLE : OP_HALVE, dst, dst, 0);
+    }
+    else
+    {
+      emit(c, op == '*' ? OP_MUL : OP_DIV, dst, dst, dst + 1);
+    }
+  }
+}
+
+// expr := term (('+' | '-') term)*
+static int parse_expr(Compiler *c, int dst)
+{
+  if (!parse_term(c, dst))
+  {
+    return 0;
+  }
+  for (;;)
+  {
+    skip_space(c);
+    char op = *c->pos;
+    if (op != '+' && op != '-')
+    {
+      return 1;
+    }
+    c->pos++;
+    if (!parse_term(c, dst + 1))
+    {
+      return 0;
+    }
+    emit(c, op == '+' ? OP_ADD : OP_SUB, dst, dst, dst + 1);
+  }
+}
+
+FixedpointExpr *fixedpoint_expr_compile(const char *src, const char *const *col_names, int num_cols,
+                                        int mode, size_t *err_pos)
+{
+  Compiler c;
+  c.src = src;
+  c.pos = src;
+  c.col_names = col_names;
+  c.num_cols = num_cols;
+  c.expr = calloc(1, sizeof(FixedpointExpr));
+  if (!c.expr)
+  {
+    return NULL;
+  }
+  c.expr->mode = mode;
+  c.code_cap = 0;
+  c.consts_cap = 0;
+  c.depth = 0;
+  c.failed = 0;
+
+  int ok = parse_expr(&c, 0);
+  skip_space(&c);
+  if (!ok || c.failed || *c.pos != '\0')
+  {
+    if (err_pos)
+    {
+      *err_pos = c.pos - src;
+    }
+    fixedpoint_expr_destroy(c.expr);
+    return NULL;
+  }
+  return c.expr;
+}
+
+void fixedpoint_expr_destroy(FixedpointExpr *expr)
+{
+  if (expr)
+  {
+    free(expr->code);
+    free(expr->consts);
+    free(expr);
+  }
+}
+
+// Record, for each row, the tag of an exceptional operand (the left one
+// if both are exceptional), or -1 if both operands are valid.  This is
+// done before the operation, since its output may overwrite an operand.
+static void exceptional_tags(const Fixedpoint *left, const Fixedpoint *right, int *tags, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    int right_tag = (right && !fixedpoint_is_valid(right[i])) ? right[i].tag : -1;
+    tags[i] = !fixedpoint_is_valid(left[i]) ? left[i].tag : right_tag;
+  }
+}
+
+// Give results the recorded exceptional tags, so that errors, overflows
+// and underflows flow through to the output.
+static void apply_tags(const int *tags, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i].tag = (tags[i] >= 0) ? tags[i] : out[i].tag;
+  }
+}
+
+// Run the program over one block of n <= FIXEDPOINT_EXPR_BLOCK_SIZE rows.
+// reg[r] points to the current value of register r, which is either a
+// slice of an input column or the register's scratch column.
+static void eval_block(const FixedpointExpr *expr, const Fixedpoint *const *cols, size_t start,
+                       Fixedpoint *const *scratch, Fixedpoint *out, size_t n)
+{
+  const Fixedpoint *reg[FIXEDPOINT_EXPR_MAX_REGS];
+  int tags[FIXEDPOINT_EXPR_BLOCK_SIZE];
+
+  for (int pc = 0; pc < expr->code_len; pc++)
+  {
+    Instr in = expr->code[pc];
+    Fixedpoint *dst = scratch[in.dst];
+
+    if (in.op == OP_COL)
+    {
+      reg[in.dst] = cols[in.a] + start;
+      continue;
+    }
+    if (in.op == OP_CONST)
+    {
+      for (size_t i = 0; i < n; i++)
+      {
+        dst[i] = expr->consts[in.a];
+      }
+      reg[in.dst] = dst;
+      continue;
+    }
+
+    // a and b are registers for the remaining instructions
+    const Fixedpoint *a = reg[in.a];
+    const Fixedpoint *b = (in.op <= OP_DIV) ? reg[in.b] : NULL;
+    exceptional_tags(a, b, tags, n);
+    // the batch operations are scalar loops: the 24-byte values, with a
+    // tag per lane and sticky status flags, leave nothing for portable
+    // SIMD to do, so the block structure is what keeps this fast
+    switch (in.op)
+    {
+    case OP_ADD:
+      fixedpoint_add_n(a, b, dst, n);
+      break;
+    case OP_SUB:
+      fixedpoint_sub_n(a, b, dst, n);
+      break;
+    case OP_MUL:
+      fixedpoint_mul_round_n(a, b, expr->mode, dst, n);
+      break;
+    case OP_DIV:
+      fixedpoint_div_round_n(a, b, expr->mode, dst, n);
+      break;
+    case OP_NEG:
+      fixedpoint_negate_n(a, dst, n);
+      break;
+    case OP_HALVE:
+      fixedpoint_halve_round_n(a, expr->mode, dst, n);
+      break;
+    case OP_DOUBLE:
+      fixedpoint_double_n(a, dst, n);
+      break;
+    }
+    apply_tags(tags, dst, n);
+    reg[in.dst] = dst;
+  }
+  memmove(out, reg[0], n * sizeof(Fixedpoint));
+}
+
+int fixedpoint_expr_eval(const FixedpointExpr *expr, const Fixedpoint *const *cols, Fixedpoint *out, size_t n)
+{
+  Fixedpoint *scratch[FIXEDPOINT_EXPR_MAX_REGS];
+  Fixedpoint *buf = malloc((size_t)expr->num_regs * FIXEDPOINT_EXPR_BLOCK_SIZE * sizeof(Fixedpoint));
+  if (!buf)
+  {
+    return 0;
+  }
+
+  for (int r = 0; r < expr->num_regs; r++)
+  {
+    scratch[r] = buf + (size_t)r * FIXEDPOINT_EXPR_BLOCK_SIZE;
+  }
+  for (size_t start = 0; start < n; start += FIXEDPOINT_EXPR_BLOCK_SIZE)
+  {
+    size_t len = n - start < FIXEDPOINT_EXPR_BLOCK_SIZE ? n - start : FIXEDPOINT_EXPR_BLOCK_SIZE;
+    eval_block(expr, cols, start, scratch, out + start, len);
+  }
+  free(buf);
+  return 1;
+}
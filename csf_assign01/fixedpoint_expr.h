@@ -0,0 +1,85 @@
+#ifndef FIXEDPOINT_EXPR_H
+#define FIXEDPOINT_EXPR_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compiled formulas over columns of Fixedpoint values.
+//
+// A formula such as "(a + b) * c - d/2" is compiled to bytecode for a
+// small register machine.  Each instruction is applied to a whole block of
+// values at a time, using the batch operations, so intermediate results
+// live in a few block-sized scratch columns rather than being created one
+// value at a time.
+//
+// Formulas may use:
+//   - column names (letters, digits and underscores, not starting with
+//     a digit), which refer to the columns passed to fixedpoint_expr_eval
+//   - decimal constants (e.g. 2, 0.25), or hex constants with a 0x prefix
+//     (e.g. 0x1.8)
+//   - binary + - * / and unary -, with the usual precedence, and
+//     parentheses
+//
+// Multiplying or dividing by the constant 2 compiles to fixedpoint_double
+// or a halve.  If an operand of an operation is an error, overflow or
+// underflow value, the result has the same tag (the left operand's, if
+// both are exceptional), so exceptional values propagate to the output.
+
+// number of values processed by each instruction at a time
+#define FIXEDPOINT_EXPR_BLOCK_SIZE 1024
+
+// maximum number of registers (intermediate columns) a formula may need
+#define FIXEDPOINT_EXPR_MAX_REGS 16
+
+// maximum nesting of unary minuses and parentheses in a formula
+#define FIXEDPOINT_EXPR_MAX_DEPTH 256
+
+typedef struct FixedpointExpr FixedpointExpr;
+
+// Compile a formula.
+//
+// Parameters:
+//   src - the formula
+//   col_names - array of num_cols column names
+//   num_cols - the number of columns
+//   mode - the FIXEDPOINT_ROUND_ mode used by *, / and halving
+//   err_pos - if not NULL, set to the offset in src of a syntax error
+//
+// Returns:
+//   the compiled formula, to be freed with fixedpoint_expr_destroy, or
+//   NULL if the formula is invalid (uses an unknown column, has a syntax
+//   error, needs too many registers, or is nested too deeply) or memory
+//   couldn't be allocated
+FixedpointExpr *fixedpoint_expr_compile(const char *src, const char *const *col_names, int num_cols,
+                                        int mode, size_t *err_pos);
+
+// Evaluate a compiled formula for n rows.  This may be called from several
+// threads at once for the same formula.
+//
+// Parameters:
+//   expr - the compiled formula
+//   cols - array of column pointers, in the order of the col_names passed
+//          to fixedpoint_expr_compile; each column has n values
+//   out - array of n results (which may be one of the columns)
+//   n - number of rows
+//
+// Returns:
+//   1 if successful, 0 if memory for the scratch columns couldn't be
+//   allocated (in which case out is unchanged)
+int fixedpoint_expr_eval(const FixedpointExpr *expr, const Fixedpoint *const *cols, Fixedpoint *out, size_t n);
+
+// Free a compiled formula.
+//
+// Parameters:
+//   expr - the compiled formula (may be NULL)
+void fixedpoint_expr_destroy(FixedpointExpr *expr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_EXPR_H
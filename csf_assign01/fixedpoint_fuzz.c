@@ -0,0 +1,450 @@
+// Randomized differential harness for the Fixedpoint library.
+//
+// Every operation is checked against an exact reference model that keeps
+// the magnitude of a value in an unsigned __int128 (whole part in the high
+// 64 bits, fraction in the low 64 bits) plus a separate sign.  Operands are
+// generated in blocks by per-thread xorshift generators, mixing uniformly
+// random values with edge cases (0, 1, max, single bits, values near a
+// carry boundary), and the blocks are split across worker threads.
+//
+// Usage:
+//   fixedpoint_fuzz [-n cases] [-t threads] [-s seed] [-m max_reports]
+//
+// When a mismatch is found, the operands are shrunk (bits are cleared one
+// at a time while the mismatch persists) and the minimized counterexample
+// is printed.  The exit status is 0 if no mismatch was found, 1 otherwise.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "fixedpoint.h"
+
+__extension__ typedef unsigned __int128 u128;
+
+// number of operand pairs generated and checked at a time
+#define BLOCK_SIZE 256
+
+enum
+{
+  OP_ADD,
+  OP_SUB,
+  OP_HALVE,
+  OP_DOUBLE,
+  OP_COMPARE,
+  OP_HEX,
+  OP_DEC,
+  NUM_OPS
+};
+
+static const char *op_names[NUM_OPS] = {"add", "sub", "halve", "double", "compare", "hex", "dec"};
+
+// Reference model result: tag uses the same encoding as Fixedpoint.tag
+typedef struct
+{
+  u128 mag;
+  int tag;
+} RefResult;
+
+typedef struct
+{
+  uint64_t seed;
+  uint64_t num_cases;
+  uint64_t mismatches;
+} Worker;
+
+static int max_reports = 10;
+static int num_reports;
+static pthread_mutex_t report_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t next_rand(uint64_t *state)
+{
+  // xorshift64*
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DUL;
+}
+
+static u128 ref_mag(Fixedpoint val)
+{
+  return ((u128)val.integer << 64) | val.fraction;
+}
+
+static int ref_neg(Fixedpoint val)
+{
+  return val.tag == 1 && ref_mag(val) != 0;
+}
+
+static RefResult ref_make(u128 mag, int neg)
+{
+  RefResult r;
+  r.mag = mag;
+  r.tag = (neg && mag != 0) ? 1 : 0;
+  return r;
+}
+
+static RefResult ref_add(Fixedpoint left, Fixedpoint right)
+{
+  u128 a = ref_mag(left), b = ref_mag(right);
+  int na = ref_neg(left), nb = ref_neg(right);
+  RefResult r;
+
+  if (na == nb)
+  {
+    r = ref_make(a + b, na);
+    if (a + b < a)
+    { // carry out of bit 127
+      r.tag = na ? 3 : 4;
+    }
+    return r;
+  }
+  if (a >= b)
+  {
+    return ref_make(a - b, na);
+  }
+  return ref_make(b - a, nb);
+}
+
+static RefResult ref_sub(Fixedpoint left, Fixedpoint right)
+{
+  if (ref_mag(right) != 0)
+  {
+    right.tag = ref_neg(right) ? 0 : 1;
+  }
+  return ref_add(left, right);
+}
+
+static RefResult ref_halve(Fixedpoint val)
+{
+  RefResult r = ref_make(ref_mag(val) >> 1, ref_neg(val));
+  if (ref_mag(val) & 1)
+  {
+    r.tag = ref_neg(val) ? 5 : 6;
+  }
+  return r;
+}
+
+static int ref_compare(Fixedpoint left, Fixedpoint right)
+{
+  u128 a = ref_mag(left), b = ref_mag(right);
+  int na = ref_neg(left), nb = ref_neg(right);
+
+  if (na != nb)
+  {
+    return na ? -1 : 1;
+  }
+  if (a == b)
+  {
+    return 0;
+  }
+  return ((a > b) != na) ? 1 : -1;
+}
+
+// Format a value without going through the library, for reports and for
+// checking fixedpoint_format_as_hex.
+static void ref_format(Fixedpoint val, char *buf)
+{
+  int n = sprintf(buf, "%s%lx", ref_neg(val) ? "-" : "", val.integer);
+  if (val.fraction != 0)
+  {
+    n += sprintf(buf + n, ".%016lx", val.fraction);
+    while (buf[n - 1] == '0')
+    {
+      n--;
+    }
+    buf[n] = '\0';
+  }
+}
+
+// Write the exact decimal expansion of a value (every 64 bit fraction has
+// one, with at most 64 digits).
+static void ref_format_dec(Fixedpoint val, char *buf)
+{
+  int n = sprintf(buf, "%s%lu", ref_neg(val) ? "-" : "", val.integer);
+  u128 frac = val.fraction;
+  if (frac != 0)
+  {
+    buf[n++] = '.';
+    while (frac != 0)
+    {
+      frac *= 10;
+      buf[n++] = (char)('0' + (int)(frac >> 64));
+      frac &= 0xFFFFFFFFFFFFFFFFUL;
+    }
+  }
+  buf[n] = '\0';
+}
+
+// Does the library result agree with the reference result?  Overflow and
+// underflow results only need the right tag; the value they carry is
+// unspecified.  The sign of a zero result is not significant.
+static int result_matches(Fixedpoint actual, RefResult expected)
+{
+  if (expected.tag == 0 || expected.tag == 1)
+  {
+    if (!fixedpoint_is_valid(actual) || ref_mag(actual) != expected.mag)
+    {
+      return 0;
+    }
+    return expected.mag == 0 || actual.tag == expected.tag;
+  }
+  return actual.tag == expected.tag;
+}
+
+// Returns 1 if the library agrees with the reference model on the given
+// operation and operands.
+static int check_case(int op, Fixedpoint a, Fixedpoint b)
+{
+  switch (op)
+  {
+  case OP_ADD:
+    return result_matches(fixedpoint_add(a, b), ref_add(a, b));
+  case OP_SUB:
+    return result_matches(fixedpoint_sub(a, b), ref_sub(a, b));
+  case OP_HALVE:
+    return result_matches(fixedpoint_halve(a), ref_halve(a));
+  case OP_DOUBLE:
+    return result_matches(fixedpoint_double(a), ref_add(a, a));
+  case OP_COMPARE:
+    return fixedpoint_compare(a, b) == ref_compare(a, b);
+  case OP_HEX:
+  {
+    char expected[40];
+    char *s = fixedpoint_format_as_hex(a);
+    Fixedpoint back = fixedpoint_create_from_hex(s);
+    int ok;
+
+    ref_format(a, expected);
+    ok = strcmp(s, expected) == 0 && back.integer == a.integer &&
+         back.fraction == a.fraction && ref_neg(back) == ref_neg(a) &&
+         fixedpoint_is_valid(back);
+    free(s);
+    return ok;
+  }
+  case OP_DEC:
+  {
+    char exact[100], shortest[FIXEDPOINT_DEC_BUF_SIZE];
+    Fixedpoint from_exact, from_shortest;
+
+    ref_format_dec(a, exact);
+    fixedpoint_format_as_dec(a, shortest, sizeof(shortest));
+    from_exact = fixedpoint_create_from_dec_round(exact, FIXEDPOINT_ROUND_EXACT);
+    from_shortest = fixedpoint_create_from_dec(shortest);
+    return strlen(shortest) <= strlen(exact) &&
+           ref_mag(from_exact) == ref_mag(a) && ref_neg(from_exact) == ref_neg(a) &&
+           fixedpoint_is_valid(from_exact) &&
+           ref_mag(from_shortest) == ref_mag(a) && ref_neg(from_shortest) == ref_neg(a) &&
+           fixedpoint_is_valid(from_shortest);
+  }
+  }
+  return 1;
+}
+
+// Shrink a failing case by clearing bits of the operands (and dropping
+// negative signs) for as long as the case keeps failing.
+static void minimize(int op, Fixedpoint *a, Fixedpoint *b)
+{
+  int progress = 1;
+  while (progress)
+  {
+    progress = 0;
+    Fixedpoint *vals[2] = {a, b};
+    for (int v = 0; v < 2; v++)
+    {
+      uint64_t *words[2] = {&vals[v]->integer, &vals[v]->fraction};
+      for (int w = 0; w < 2; w++)
+      {
+        for (int bit = 63; bit >= 0; bit--)
+        {
+          uint64_t saved = *words[w];
+          if (!(saved & (1UL << bit)))
+          {
+            continue;
+          }
+          *words[w] = saved & ~(1UL << bit);
+          if (check_case(op, *a, *b))
+          {
+            *words[w] = saved;
+          }
+          else
+          {
+            progress = 1;
+          }
+        }
+      }
+      if (vals[v]->tag == 1)
+      {
+        vals[v]->tag = 0;
+        if (check_case(op, *a, *b))
+        {
+          vals[v]->tag = 1;
+        }
+        else
+        {
+          progress = 1;
+        }
+      }
+    }
+  }
+}
+
+static void report(int op, Fixedpoint a, Fixedpoint b)
+{
+  char sa[40], sb[40];
+
+  pthread_mutex_lock(&report_lock);
+  if (num_reports < max_reports)
+  {
+    minimize(op, &a, &b);
+    ref_format(a, sa);
+    ref_format(b, sb);
+    if (op == OP_HALVE || op == OP_DOUBLE || op == OP_HEX || op == OP_DEC)
+    {
+      fprintf(stderr, "MISMATCH %s(%s)\n", op_names[op], sa);
+    }
+    else
+    {
+      fprintf(stderr, "MISMATCH %s(%s, %s)\n", op_names[op], sa, sb);
+    }
+  }
+  num_reports++;
+  pthread_mutex_unlock(&report_lock);
+}
+
+static uint64_t gen_word(uint64_t *state)
+{
+  uint64_t r = next_rand(state);
+  switch (r & 7)
+  {
+  case 0:
+    return 0UL;
+  case 1:
+    return 0xFFFFFFFFFFFFFFFFUL - (next_rand(state) & 3);
+  case 2:
+    return 1UL << (next_rand(state) & 63);
+  case 3:
+    // random magnitude, so small and mid-sized values show up often
+    return next_rand(state) >> (next_rand(state) & 63);
+  default:
+    return next_rand(state);
+  }
+}
+
+static Fixedpoint gen_value(uint64_t *state)
+{
+  Fixedpoint val = fixedpoint_create2(gen_word(state), gen_word(state));
+  val.tag = (int)(next_rand(state) & 1);
+  return val;
+}
+
+static void *worker_main(void *arg)
+{
+  Worker *w = arg;
+  uint64_t state = w->seed * 0x9E3779B97F4A7C15UL + 1;
+  Fixedpoint left[BLOCK_SIZE], right[BLOCK_SIZE];
+
+  for (uint64_t done = 0; done < w->num_cases; done += BLOCK_SIZE)
+  {
+    size_t n = BLOCK_SIZE;
+    if (w->num_cases - done < n)
+    {
+      n = w->num_cases - done;
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+      left[i] = gen_value(&state);
+      switch (next_rand(&state) & 7)
+      {
+      case 0: // same value
+        right[i] = left[i];
+        break;
+      case 1: // opposite value
+        right[i] = left[i];
+        right[i].tag ^= 1;
+        break;
+      default:
+        right[i] = gen_value(&state);
+      }
+    }
+    // run each operation over the whole block before moving on
+    for (int op = 0; op < NUM_OPS; op++)
+    {
+      for (size_t i = 0; i < n; i++)
+      {
+        if (!check_case(op, left[i], right[i]))
+        {
+          w->mismatches++;
+          report(op, left[i], right[i]);
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+int main(int argc, char **argv)
+{
+  uint64_t num_cases = 1000000;
+  uint64_t seed = (uint64_t)time(NULL);
+  long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:t:s:m:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      num_cases = strtoull(optarg, NULL, 0);
+      break;
+    case 't':
+      num_threads = strtol(optarg, NULL, 0);
+      break;
+    case 's':
+      seed = strtoull(optarg, NULL, 0);
+      break;
+    case 'm':
+      max_reports = atoi(optarg);
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-n cases] [-t threads] [-s seed] [-m max_reports]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (num_threads < 1)
+  {
+    num_threads = 1;
+  }
+
+  Worker *workers = calloc(num_threads, sizeof(Worker));
+  pthread_t *threads = calloc(num_threads, sizeof(pthread_t));
+  struct timespec start, end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (long i = 0; i < num_threads; i++)
+  {
+    workers[i].seed = seed + i;
+    workers[i].num_cases = num_cases / num_threads + ((uint64_t)i < num_cases % num_threads);
+    pthread_create(&threads[i], NULL, worker_main, &workers[i]);
+  }
+
+  uint64_t mismatches = 0;
+  for (long i = 0; i < num_threads; i++)
+  {
+    pthread_join(threads[i], NULL);
+    mismatches += workers[i].mismatches;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  double secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  printf("seed %lu: %lu cases x %d ops on %ld thread(s) in %.2fs (%.0f cases/s), %lu mismatch(es)\n",
+         seed, num_cases, NUM_OPS, num_threads, secs, num_cases / secs, mismatches);
+
+  free(threads);
+  free(workers);
+  return mismatches != 0;
+}
@@ -0,0 +1,781 @@
+// for syscall
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "fixedpoint.h"
+#include "fixedpoint_ingest.h"
+
+// liburing isn't needed: the kernel's interface is driven directly
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#define DEFAULT_CHUNK_SIZE (1 << 20)
+#define DEFAULT_QUEUE_DEPTH 8
+
+// Bytes read past the end of a chunk, so that the last line starting in
+// it can usually be parsed without another read.  Longer lines than this
+// are invalid anyway.
+#define OVERHANG 64
+
+// A line longer than this can't be a valid value, and stays invalid when
+// cut to this length (it still has more than 16 digits before or after
+// the point, or a character which isn't allowed).
+#define MAX_LINE 63
+
+typedef struct Chunk
+{
+  struct Chunk *next;
+  uint64_t index;  // the chunk number
+  uint64_t offset; // file offset of data[0]
+  size_t len;      // bytes read so far
+  size_t want;     // bytes to read
+  int error;       // errno of a failed read
+  char *data;      // with room for a terminating NUL after want bytes
+  size_t cap;
+  Fixedpoint *vals;
+  size_t vals_cap;
+  struct iovec iov; // the part of data being read by io_uring
+} Chunk;
+
+typedef struct
+{
+  Chunk *head, *tail;
+} ChunkQueue;
+
+typedef struct
+{
+  int fd;
+  uint64_t size;
+  size_t chunk_size;
+  FixedpointIngestSink sink;
+  void *ctx;
+
+  pthread_mutex_t lock; // protects everything below
+  pthread_cond_t parse_ready;
+  pthread_cond_t free_ready;
+  pthread_cond_t read_ready;
+  pthread_cond_t done_ready;
+  ChunkQueue parse; // read chunks waiting for a parser
+  ChunkQueue free;  // chunks not in use
+  ChunkQueue reads; // chunks waiting for a pread thread
+  ChunkQueue done;  // chunks read by the pread threads
+  int shutdown;
+  int error; // errno of the first failure in a parser
+  uint64_t values;
+  uint64_t invalid;
+  int flags; // status flags of the parsers
+} Ingest;
+
+static void queue_push(ChunkQueue *q, Chunk *c)
+{
+  c->next = NULL;
+  if (q->tail)
+  {
+    q->tail->next = c;
+  }
+  else
+  {
+    q->head = c;
+  }
+  q->tail = c;
+}
+
+static Chunk *queue_pop(ChunkQueue *q)
+{
+  Chunk *c = q->head;
+  if (c)
+  {
+    q->head = c->next;
+    if (!q->head)
+    {
+      q->tail = NULL;
+    }
+  }
+  return c;
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000UL + (uint64_t)ts.tv_nsec;
+}
+
+// Parsing
+
+// read more of the file onto the end of a chunk, returning 0 at the end
+// of the file, -1 on failure
+static ssize_t extend_chunk(Ingest *in, Chunk *c)
+{
+  size_t more = OVERHANG * 4;
+  if (c->len + more + 1 > c->cap)
+  {
+    size_t cap = c->cap * 2 > c->len + more + 1 ? c->cap * 2 : c->len + more + 1;
+    char *data = realloc(c->data, cap);
+    if (!data)
+    {
+      return -1;
+    }
+    c->data = data;
+    c->cap = cap;
+  }
+  ssize_t got;
+  do
+  {
+    got = pread(in->fd, c->data + c->len, more, (off_t)(c->offset + c->len));
+  } while (got < 0 && errno == EINTR);
+  if (got > 0)
+  {
+    c->len += got;
+  }
+  return got;
+}
+
+// parse the lines starting in a chunk, returning the number of values, or
+// -1 on failure (with errno set)
+static ssize_t parse_chunk(Ingest *in, Chunk *c)
+{
+  uint64_t end = (c->index + 1) * in->chunk_size;
+  if (end > in->size)
+  {
+    end = in->size;
+  }
+  // the file may have shrunk since its size was taken, leaving nothing
+  // of the chunk itself to parse
+  if (c->len <= (c->index > 0 ? 1u : 0u))
+  {
+    return 0;
+  }
+  size_t pos = 0;
+  if (c->index > 0)
+  {
+    // data[0] is the byte before the chunk: unless it ends a line, the
+    // first line belongs to the previous chunk
+    pos = 1;
+    if (c->data[0] != '\n')
+    {
+      char *nl = memchr(c->data + 1, '\n', c->len - 1);
+      if (!nl)
+      {
+        // the data reaches past the end of the chunk, so no line starts in it
+        return 0;
+      }
+      pos = nl - c->data + 1;
+    }
+  }
+
+  size_t n = 0;
+  int eof = c->offset + c->len >= in->size;
+  // (a shrunk file can also run out before the end of the chunk)
+  while (c->offset + pos < end && (pos < c->len || !eof))
+  {
+    char *nl = memchr(c->data + pos, '\n', c->len - pos);
+    while (!nl && !eof)
+    {
+      size_t old_len = c->len;
+      ssize_t got = extend_chunk(in, c);
+      if (got < 0)
+      {
+        return -1;
+      }
+      eof = got == 0;
+      nl = memchr(c->data + old_len, '\n', c->len - old_len);
+    }
+    size_t line_end = nl ? (size_t)(nl - c->data) : c->len;
+    if (line_end - pos > MAX_LINE)
+    {
+      line_end = pos + MAX_LINE;
+    }
+    c->data[line_end] = '\0';
+
+    if (n == c->vals_cap)
+    {
+      size_t cap = c->vals_cap ? c->vals_cap * 2 : 1024;
+      Fixedpoint *vals = realloc(c->vals, cap * sizeof(Fixedpoint));
+      if (!vals)
+      {
+        return -1;
+      }
+      c->vals = vals;
+      c->vals_cap = cap;
+    }
+    c->vals[n++] = fixedpoint_create_from_hex(c->data + pos);
+    pos = (nl ? (size_t)(nl - c->data) : c->len) + 1;
+  }
+  return n;
+}
+
+static void *parser_main(void *arg)
+{
+  Ingest *in = arg;
+  uint64_t values = 0, invalid = 0;
+  int error = 0;
+
+  pthread_mutex_lock(&in->lock);
+  for (;;)
+  {
+    while (!in->parse.head && !in->shutdown)
+    {
+      pthread_cond_wait(&in->parse_ready, &in->lock);
+    }
+    Chunk *c = queue_pop(&in->parse);
+    if (!c)
+    {
+      break;
+    }
+    pthread_mutex_unlock(&in->lock);
+
+    ssize_t n = parse_chunk(in, c);
+    if (n < 0)
+    {
+      error = errno;
+    }
+    else
+    {
+      values += n;
+      for (ssize_t i = 0; i < n; i++)
+      {
+        invalid += fixedpoint_is_err(c->vals[i]) != 0;
+      }
+      if (in->sink && n > 0)
+      {
+        in->sink(c->vals, n, c->index, in->ctx);
+      }
+    }
+
+    pthread_mutex_lock(&in->lock);
+    queue_push(&in->free, c);
+    pthread_cond_signal(&in->free_ready);
+  }
+  in->values += values;
+  in->invalid += invalid;
+  in->flags |= fixedpoint_status_test(FIXEDPOINT_STATUS_ALL);
+  if (error && !in->error)
+  {
+    in->error = error;
+  }
+  pthread_mutex_unlock(&in->lock);
+  return NULL;
+}
+
+// Reading
+//
+// A reader starts reads of whole chunks, and gives back each chunk once
+// it has been read (or the read failed).
+
+typedef struct
+{
+  int backend;
+  Ingest *in;
+  // pread threads
+  pthread_t *threads;
+  int num_threads;
+#ifdef HAVE_IO_URING
+  int ring_fd;
+  void *sq_ptr, *cq_ptr;
+  size_t sq_len, cq_len;
+  struct io_uring_sqe *sqes;
+  size_t sqes_len;
+  unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_cqe *cqes;
+  unsigned to_submit; // entries queued since the last io_uring_enter
+#endif
+} Reader;
+
+static void *pread_main(void *arg)
+{
+  Ingest *in = arg;
+  pthread_mutex_lock(&in->lock);
+  for (;;)
+  {
+    while (!in->reads.head && !in->shutdown)
+    {
+      pthread_cond_wait(&in->read_ready, &in->lock);
+    }
+    Chunk *c = queue_pop(&in->reads);
+    if (!c)
+    {
+      break;
+    }
+    pthread_mutex_unlock(&in->lock);
+
+    while (c->len < c->want)
+    {
+      ssize_t got = pread(in->fd, c->data + c->len, c->want - c->len, (off_t)(c->offset + c->len));
+      if (got < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (got <= 0)
+      {
+        // a file which shrank ends early
+        c->error = got < 0 ? errno : 0;
+        break;
+      }
+      c->len += got;
+    }
+
+    pthread_mutex_lock(&in->lock);
+    queue_push(&in->done, c);
+    pthread_cond_signal(&in->done_ready);
+  }
+  pthread_mutex_unlock(&in->lock);
+  return NULL;
+}
+
+#ifdef HAVE_IO_URING
+static void uring_close(Reader *r)
+{
+  int err = errno;
+  if (r->sqes)
+  {
+    munmap(r->sqes, r->sqes_len);
+  }
+  if (r->cq_ptr && r->cq_ptr != r->sq_ptr)
+  {
+    munmap(r->cq_ptr, r->cq_len);
+  }
+  if (r->sq_ptr)
+  {
+    munmap(r->sq_ptr, r->sq_len);
+  }
+  close(r->ring_fd);
+  errno = err;
+}
+
+static int uring_open(Reader *r, unsigned entries)
+{
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  r->ring_fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (r->ring_fd < 0)
+  {
+    return 0;
+  }
+  r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single)
+  {
+    r->sq_len = r->cq_len = r->sq_len > r->cq_len ? r->sq_len : r->cq_len;
+  }
+  r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ring_fd, IORING_OFF_SQ_RING);
+  if (r->sq_ptr == MAP_FAILED)
+  {
+    r->sq_ptr = NULL;
+    uring_close(r);
+    return 0;
+  }
+  r->cq_ptr = single ? r->sq_ptr
+                     : mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ring_fd,
+                            IORING_OFF_CQ_RING);
+  if (r->cq_ptr == MAP_FAILED)
+  {
+    r->cq_ptr = NULL;
+    uring_close(r);
+    return 0;
+  }
+  r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, r->ring_fd, IORING_OFF_SQES);
+  if (r->sqes == MAP_FAILED)
+  {
+    r->sqes = NULL;
+    uring_close(r);
+    return 0;
+  }
+
+  char *sq = r->sq_ptr, *cq = r->cq_ptr;
+  r->sq_head = (unsigned *)(sq + p.sq_off.head);
+  r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+  r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+  r->sq_array = (unsigned *)(sq + p.sq_off.array);
+  r->cq_head = (unsigned *)(cq + p.cq_off.head);
+  r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+  r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+  r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+  r->to_submit = 0;
+  return 1;
+}
+
+// queue a read of the rest of a chunk (the ring has an entry for every
+// chunk, so it never fills up)
+static void uring_queue(Reader *r, Chunk *c)
+{
+  unsigned tail = *r->sq_tail;
+  unsigned idx = tail & *r->sq_mask;
+  struct io_uring_sqe *sqe = &r->sqes[idx];
+  c->iov.iov_base = c->data + c->len;
+  c->iov.iov_len = c->want - c->len;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READV;
+  sqe->fd = r->in->fd;
+  sqe->addr = (uint64_t)(uintptr_t)&c->iov;
+  sqe->len = 1;
+  sqe->off = c->offset + c->len;
+  sqe->user_data = (uint64_t)(uintptr_t)c;
+  r->sq_array[idx] = idx;
+  __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  r->to_submit++;
+}
+
+static Chunk *uring_wait(Reader *r)
+{
+  for (;;)
+  {
+    unsigned head = *r->cq_head;
+    if (head != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE))
+    {
+      struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+      Chunk *c = (Chunk *)(uintptr_t)cqe->user_data;
+      int res = cqe->res;
+      __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+      if (res == -EINTR || res == -EAGAIN || (res > 0 && c->len + res < c->want))
+      {
+        // retry, or read the rest of a short read
+        c->len += res > 0 ? res : 0;
+        uring_queue(r, c);
+        continue;
+      }
+      if (res < 0)
+      {
+        c->error = -res;
+      }
+      else
+      {
+        // 0 means a file which shrank ends early
+        c->len += res;
+      }
+      return c;
+    }
+
+    long ret = syscall(__NR_io_uring_enter, r->ring_fd, r->to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+    {
+      return NULL;
+    }
+    if (ret > 0)
+    {
+      r->to_submit -= (unsigned)ret;
+    }
+  }
+}
+#endif
+
+static int reader_open(Reader *r, Ingest *in, int backend, int depth)
+{
+  memset(r, 0, sizeof(*r));
+  r->in = in;
+#ifdef HAVE_IO_URING
+  if (backend != FIXEDPOINT_INGEST_PREAD)
+  {
+    if (uring_open(r, (unsigned)depth))
+    {
+      r->backend = FIXEDPOINT_INGEST_IO_URING;
+      return 1;
+    }
+    if (backend == FIXEDPOINT_INGEST_IO_URING)
+    {
+      return 0;
+    }
+  }
+#else
+  if (backend == FIXEDPOINT_INGEST_IO_URING)
+  {
+    errno = ENOSYS;
+    return 0;
+  }
+#endif
+
+  r->backend = FIXEDPOINT_INGEST_PREAD;
+  r->threads = malloc(depth * sizeof(pthread_t));
+  if (!r->threads)
+  {
+    return 0;
+  }
+  for (r->num_threads = 0; r->num_threads < depth; r->num_threads++)
+  {
+    if (pthread_create(&r->threads[r->num_threads], NULL, pread_main, in) != 0)
+    {
+      break;
+    }
+  }
+  // a few readers will do, but not none
+  if (r->num_threads == 0)
+  {
+    free(r->threads);
+    errno = EAGAIN;
+    return 0;
+  }
+  return 1;
+}
+
+// the reads must all have finished
+static void reader_close(Reader *r)
+{
+#ifdef HAVE_IO_URING
+  if (r->backend == FIXEDPOINT_INGEST_IO_URING)
+  {
+    uring_close(r);
+    return;
+  }
+#endif
+  pthread_mutex_lock(&r->in->lock);
+  r->in->shutdown = 1;
+  pthread_cond_broadcast(&r->in->read_ready);
+  pthread_mutex_unlock(&r->in->lock);
+  for (int i = 0; i < r->num_threads; i++)
+  {
+    pthread_join(r->threads[i], NULL);
+  }
+  free(r->threads);
+}
+
+static void reader_start(Reader *r, Chunk *c)
+{
+#ifdef HAVE_IO_URING
+  if (r->backend == FIXEDPOINT_INGEST_IO_URING)
+  {
+    uring_queue(r, c);
+    return;
+  }
+#endif
+  pthread_mutex_lock(&r->in->lock);
+  queue_push(&r->in->reads, c);
+  pthread_cond_signal(&r->in->read_ready);
+  pthread_mutex_unlock(&r->in->lock);
+}
+
+// wait for a read to finish, returning NULL if io_uring fails
+static Chunk *reader_wait(Reader *r)
+{
+#ifdef HAVE_IO_URING
+  if (r->backend == FIXEDPOINT_INGEST_IO_URING)
+  {
+    return uring_wait(r);
+  }
+#endif
+  pthread_mutex_lock(&r->in->lock);
+  while (!r->in->done.head)
+  {
+    pthread_cond_wait(&r->in->done_ready, &r->in->lock);
+  }
+  Chunk *c = queue_pop(&r->in->done);
+  pthread_mutex_unlock(&r->in->lock);
+  return c;
+}
+
+// Ingestion
+
+static void free_chunks(Chunk *chunks, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    free(chunks[i].data);
+    free(chunks[i].vals);
+  }
+  free(chunks);
+}
+
+int fixedpoint_ingest_file(const char *path, FixedpointIngestSink sink, void *ctx,
+                           const FixedpointIngestConfig *config, FixedpointIngestStats *stats)
+{
+  FixedpointIngestConfig cfg = {FIXEDPOINT_INGEST_AUTO, 0, 0, 0};
+  if (config)
+  {
+    cfg = *config;
+  }
+  if (cfg.parse_threads < 1)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cfg.parse_threads = cpus > 0 ? (int)cpus : 1;
+  }
+  if (cfg.queue_depth < 1)
+  {
+    cfg.queue_depth = DEFAULT_QUEUE_DEPTH;
+  }
+  if (cfg.chunk_size < 1)
+  {
+    cfg.chunk_size = DEFAULT_CHUNK_SIZE;
+  }
+
+  uint64_t start = now_ns();
+  Ingest in;
+  memset(&in, 0, sizeof(in));
+  in.fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (in.fd < 0)
+  {
+    return 0;
+  }
+  struct stat st;
+  if (fstat(in.fd, &st) != 0)
+  {
+    int err = errno;
+    close(in.fd);
+    errno = err;
+    return 0;
+  }
+  posix_fadvise(in.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  in.size = (uint64_t)st.st_size;
+  in.chunk_size = cfg.chunk_size;
+  in.sink = sink;
+  in.ctx = ctx;
+  pthread_mutex_init(&in.lock, NULL);
+  pthread_cond_init(&in.parse_ready, NULL);
+  pthread_cond_init(&in.free_ready, NULL);
+  pthread_cond_init(&in.read_ready, NULL);
+  pthread_cond_init(&in.done_ready, NULL);
+
+  // enough chunks for every read in flight, and one for each parser
+  size_t num_chunks = (size_t)cfg.queue_depth + cfg.parse_threads;
+  Chunk *chunks = calloc(num_chunks, sizeof(Chunk));
+  pthread_t *parsers = malloc(cfg.parse_threads * sizeof(pthread_t));
+  int error = !chunks || !parsers ? ENOMEM : 0;
+  for (size_t i = 0; !error && i < num_chunks; i++)
+  {
+    chunks[i].cap = cfg.chunk_size + 1 + OVERHANG + 1;
+    chunks[i].data = malloc(chunks[i].cap);
+    if (!chunks[i].data)
+    {
+      error = ENOMEM;
+    }
+    queue_push(&in.free, &chunks[i]);
+  }
+  Reader reader;
+  if (!error && !reader_open(&reader, &in, cfg.backend, cfg.queue_depth))
+  {
+    error = errno;
+  }
+  if (error)
+  {
+    if (chunks)
+    {
+      free_chunks(chunks, num_chunks);
+    }
+    free(parsers);
+    close(in.fd);
+    errno = error;
+    return 0;
+  }
+
+  int num_parsers = 0;
+  while (num_parsers < cfg.parse_threads && pthread_create(&parsers[num_parsers], NULL, parser_main, &in) == 0)
+  {
+    num_parsers++;
+  }
+  if (num_parsers == 0)
+  {
+    error = EAGAIN;
+  }
+
+  uint64_t total = (in.size + cfg.chunk_size - 1) / cfg.chunk_size;
+  uint64_t next = 0;
+  int in_flight = 0;
+  while ((!error && next < total) || in_flight > 0)
+  {
+    while (!error && next < total && in_flight < cfg.queue_depth)
+    {
+      // wait for a free chunk only if there are no reads to wait for
+      pthread_mutex_lock(&in.lock);
+      while (!in.free.head && in_flight == 0)
+      {
+        pthread_cond_wait(&in.free_ready, &in.lock);
+      }
+      Chunk *c = queue_pop(&in.free);
+      pthread_mutex_unlock(&in.lock);
+      if (!c)
+      {
+        break;
+      }
+      uint64_t chunk_start = next * cfg.chunk_size;
+      uint64_t read_end = chunk_start + cfg.chunk_size + OVERHANG;
+      c->index = next++;
+      c->offset = chunk_start > 0 ? chunk_start - 1 : 0;
+      c->want = (read_end < in.size ? read_end : in.size) - c->offset;
+      c->len = 0;
+      c->error = 0;
+      reader_start(&reader, c);
+      in_flight++;
+    }
+
+    Chunk *c = reader_wait(&reader);
+    if (!c)
+    {
+      // io_uring failed with reads in flight, whose buffers can't be reused
+      error = errno;
+      break;
+    }
+    in_flight--;
+    pthread_mutex_lock(&in.lock);
+    if (c->error)
+    {
+      if (!error)
+      {
+        error = c->error;
+      }
+      queue_push(&in.free, c);
+    }
+    else
+    {
+      queue_push(&in.parse, c);
+      pthread_cond_signal(&in.parse_ready);
+    }
+    pthread_mutex_unlock(&in.lock);
+  }
+
+  pthread_mutex_lock(&in.lock);
+  in.shutdown = 1;
+  pthread_cond_broadcast(&in.parse_ready);
+  pthread_mutex_unlock(&in.lock);
+  for (int i = 0; i < num_parsers; i++)
+  {
+    pthread_join(parsers[i], NULL);
+  }
+  int backend = reader.backend;
+  reader_close(&reader);
+  if (in_flight == 0)
+  {
+    free_chunks(chunks, num_chunks);
+  }
+  free(parsers);
+  close(in.fd);
+  pthread_cond_destroy(&in.done_ready);
+  pthread_cond_destroy(&in.read_ready);
+  pthread_cond_destroy(&in.free_ready);
+  pthread_cond_destroy(&in.parse_ready);
+  pthread_mutex_destroy(&in.lock);
+
+  // the parsers' status flags are thread-local, so raise them here
+  fixedpoint_status_raise(in.flags);
+  if (stats)
+  {
+    stats->backend = backend;
+    stats->bytes = in.size;
+    stats->values = in.values;
+    stats->invalid = in.invalid;
+    stats->seconds = (now_ns() - start) / 1e9;
+  }
+  if (!error)
+  {
+    error = in.error;
+  }
+  if (error)
+  {
+    errno = error;
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,77 @@
+#ifndef FIXEDPOINT_INGEST_H
+#define FIXEDPOINT_INGEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bulk ingestion of files of hex values, one per line.
+//
+// The file is read in large chunks, with several reads in flight at once,
+// and each chunk is handed to a pool of parser threads as soon as its
+// read completes, so reading and parsing overlap.  Reads go through
+// io_uring where the kernel supports it, and otherwise through a pool of
+// threads calling pread.
+//
+// A line belongs to the chunk it starts in.  Each line is parsed with
+// fixedpoint_create_from_hex (without its newline), so an invalid line
+// gives an error value.  A final line without a newline counts as a line,
+// but the empty "line" after a final newline does not.
+
+// ways of reading
+enum
+{
+  FIXEDPOINT_INGEST_AUTO,     // io_uring if available, otherwise pread
+  FIXEDPOINT_INGEST_IO_URING, // io_uring (failing if it isn't available)
+  FIXEDPOINT_INGEST_PREAD     // a pool of threads calling pread
+};
+
+typedef struct
+{
+  int backend;       // one of the FIXEDPOINT_INGEST_ values
+  int parse_threads; // number of parser threads (0 means one per online CPU)
+  int queue_depth;   // reads in flight (0 means 8)
+  size_t chunk_size; // bytes per read (0 means 1 MiB)
+} FixedpointIngestConfig;
+
+typedef struct
+{
+  int backend;      // the way the file was read (IO_URING or PREAD)
+  uint64_t bytes;   // size of the file
+  uint64_t values;  // number of lines
+  uint64_t invalid; // number of lines which weren't valid values
+  double seconds;   // time taken
+} FixedpointIngestStats;
+
+// Receive the values of the lines which start in a chunk.  Called from
+// the parser threads, possibly several at once, with chunks in any order;
+// the lines of chunk k come before those of chunk k + 1 in the file.  The
+// values are only valid during the call.
+typedef void (*FixedpointIngestSink)(const Fixedpoint *vals, size_t n, uint64_t chunk, void *ctx);
+
+// Read and parse a file.  The status flags raised by parsing are raised
+// in the calling thread.
+//
+// Parameters:
+//   path - the file
+//   sink - receives the values (may be NULL, to just count them)
+//   ctx - passed to sink
+//   config - how to read the file, or NULL for the defaults
+//   stats - if not NULL, set to statistics of the ingestion
+//
+// Returns:
+//   1 if successful, 0 if the file couldn't be read, io_uring was asked
+//   for and isn't available, or memory or threads couldn't be allocated
+//   (with errno set)
+int fixedpoint_ingest_file(const char *path, FixedpointIngestSink sink, void *ctx,
+                           const FixedpointIngestConfig *config, FixedpointIngestStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_INGEST_H
@@ -0,0 +1,232 @@
+#ifndef FIXEDPOINT_INTERNAL_H
+#define FIXEDPOINT_INTERNAL_H
+
+// Helpers shared by the Fixedpoint modules.  Not part of the public API.
+//
+// Internally, most operations work on the 128 bit magnitude of a value
+// (whole part in the high 64 bits, fraction in the low 64 bits) and a
+// separate sign, which avoids the case analysis on the tags.
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "fixedpoint.h"
+#include "fixedpoint_stats.h"
+#include "fixedpoint_trace.h"
+
+__extension__ typedef unsigned __int128 u128;
+
+// Count a call of operation op (one of the FIXEDPOINT_OP_ values) which
+// returned a value with the given tag (or -1 if it doesn't return a
+// value).  Without FIXEDPOINT_STATS, this compiles to nothing.
+#ifdef FIXEDPOINT_STATS
+void fixedpoint_stats_record(int op, int tag);
+#define STATS_RECORD(op, tag) fixedpoint_stats_record(op, tag)
+#else
+#define STATS_RECORD(op, tag) ((void)0)
+#endif
+
+// Fire a tracepoint (see fixedpoint_trace.h) with the operands and result
+// of an operation which took an exceptional path.  While no trace hook is
+// set, this is a load and an untaken branch.
+extern _Atomic(FixedpointTraceHook) fixedpoint_trace_hook;
+void fixedpoint_trace_fire(int probe, Fixedpoint left, Fixedpoint right, const char *text, Fixedpoint result);
+#define TRACE_PROBE(probe, left, right, text, result)                                                       \
+  do                                                                                                        \
+  {                                                                                                         \
+    if (__builtin_expect(atomic_load_explicit(&fixedpoint_trace_hook, memory_order_relaxed) != NULL, 0))    \
+    {                                                                                                       \
+      fixedpoint_trace_fire(probe, left, right, text, result);                                              \
+    }                                                                                                       \
+  } while (0)
+
+#define MAX_MAG (~(u128)0)
+
+static inline u128 get_mag(Fixedpoint val)
+{
+  return ((u128)val.integer << 64) | val.fraction;
+}
+
+// 1 if val is a valid nonzero negative value, 0 otherwise
+static inline int get_neg(Fixedpoint val)
+{
+  return val.tag == 1 && (val.integer | val.fraction) != 0;
+}
+
+// Make a valid value; zero is never negative
+static inline Fixedpoint from_mag(u128 mag, int neg)
+{
+  Fixedpoint result;
+  result.integer = (uint64_t)(mag >> 64);
+  result.fraction = (uint64_t)mag;
+  result.tag = neg & (mag != 0);
+  return result;
+}
+
+// Compute the 256 bit product of two magnitudes as hi:lo
+static inline void mul_mag(u128 a, u128 b, u128 *hi, u128 *lo)
+{
+  u128 al = (uint64_t)a, ah = a >> 64;
+  u128 bl = (uint64_t)b, bh = b >> 64;
+  u128 ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+  // middle column, including the carry out of the low 64 bits of ll
+  u128 mid = (ll >> 64) + (uint64_t)lh + (uint64_t)hl;
+
+  *lo = (mid << 64) | (uint64_t)ll;
+  *hi = hh + (lh >> 64) + (hl >> 64) + (mid >> 64);
+}
+
+// Compute the rounding increment (0 or 1) for the truncated magnitude q of
+// a result.  half is the first bit below q, and sticky is 1 if any bit
+// below that is nonzero.  The increment is computed arithmetically from
+// the mode, so there are no branches on the data.
+static inline int round_inc(u128 q, int half, int sticky, int neg, int mode)
+{
+  int inexact = half | sticky;
+  return ((mode == FIXEDPOINT_ROUND_NEAREST_EVEN) & half & (sticky | (int)(q & 1))) |
+         ((mode == FIXEDPOINT_ROUND_FLOOR) & neg & inexact) |
+         ((mode == FIXEDPOINT_ROUND_CEIL) & !neg & inexact);
+}
+
+// Round the truncated magnitude q of a result according to mode.  The
+// status flag for an underflow or overflow result is raised.
+static inline Fixedpoint round_mag(u128 q, int half, int sticky, int neg, int mode)
+{
+  int inexact = half | sticky;
+  int inc = round_inc(q, half, sticky, neg, mode);
+  int overflow = inc & (q == MAX_MAG);
+
+  Fixedpoint result = from_mag(q + inc, neg);
+  if ((mode == FIXEDPOINT_ROUND_EXACT) & inexact)
+  {
+    result.tag = neg ? 5 : 6;
+  }
+  if (overflow)
+  {
+    result.tag = neg ? 3 : 4;
+  }
+  fixedpoint_status_raise(1 << result.tag);
+  return result;
+}
+
+// Saturating sum of two sign/magnitude values.  The selects below compile
+// to conditional moves, so there are no data-dependent branches.  Sets
+// *saturated to 1 if the result was clamped, 0 otherwise.
+static inline Fixedpoint add_sat_mag(u128 a, int na, u128 b, int nb, int *saturated)
+{
+  u128 sum = a + b;
+  u128 diff = a - b;
+  int same = na == nb;
+  int carry = same & (sum < a);
+  int borrow = a < b;
+  // two's complement negation of diff when b > a
+  u128 borrow_mask = -(u128)borrow;
+  u128 abs_diff = (diff ^ borrow_mask) - borrow_mask;
+
+  *saturated = carry;
+  u128 mag = same ? (sum | -(u128)carry) : abs_diff;
+  int neg = same ? na : (borrow ? nb : na);
+  return from_mag(mag, neg);
+}
+
+static inline Fixedpoint add_sat(Fixedpoint left, Fixedpoint right, int *saturated)
+{
+  return add_sat_mag(get_mag(left), get_neg(left), get_mag(right), get_neg(right), saturated);
+}
+
+static inline Fixedpoint sub_sat(Fixedpoint left, Fixedpoint right, int *saturated)
+{
+  return add_sat_mag(get_mag(left), get_neg(left), get_mag(right), !get_neg(right), saturated);
+}
+
+static inline Fixedpoint double_sat(Fixedpoint val, int *saturated)
+{
+  u128 mag = get_mag(val);
+  // saturate if the top bit would be shifted out
+  *saturated = (int)(mag >> 127);
+  return from_mag((mag << 1) | -(mag >> 127), get_neg(val));
+}
+
+static inline Fixedpoint mul_sat(Fixedpoint left, Fixedpoint right, int *saturated)
+{
+  u128 hi, lo;
+
+  mul_mag(get_mag(left), get_mag(right), &hi, &lo);
+  *saturated = (hi >> 64) != 0;
+  return from_mag((hi << 64) | (lo >> 64) | -(u128)*saturated, get_neg(left) ^ get_neg(right));
+}
+
+// Exact sum of Fixedpoint values, in two's complement with 64 bits more
+// than a Fixedpoint magnitude (lo holds the low 128 bits, hi the signed
+// high 64 bits).  Adding or subtracting fewer than 2^63 values can't
+// overflow it.
+typedef struct
+{
+  u128 lo;
+  int64_t hi;
+} WideSum;
+
+static inline void wide_add_mag(WideSum *sum, u128 mag, int neg)
+{
+  u128 lo = sum->lo;
+  if (neg)
+  {
+    sum->lo = lo - mag;
+    sum->hi -= sum->lo > lo;
+  }
+  else
+  {
+    sum->lo = lo + mag;
+    sum->hi += sum->lo < lo;
+  }
+}
+
+static inline void wide_add(WideSum *sum, Fixedpoint val)
+{
+  wide_add_mag(sum, get_mag(val), get_neg(val));
+}
+
+static inline void wide_sub(WideSum *sum, Fixedpoint val)
+{
+  wide_add_mag(sum, get_mag(val), !get_neg(val));
+}
+
+static inline void wide_add_sum(WideSum *sum, WideSum other)
+{
+  u128 lo = sum->lo;
+  sum->lo = lo + other.lo;
+  sum->hi += other.hi + (sum->lo < lo);
+}
+
+// The product of a sign/magnitude value and a count, as a WideSum (exact
+// for counts below 2^63)
+static inline WideSum wide_product(u128 mag, int neg, uint64_t count)
+{
+  u128 hi, lo;
+  mul_mag(mag, count, &hi, &lo);
+  WideSum product = {lo, (int64_t)hi};
+  if (neg)
+  {
+    product.hi = (int64_t)(~(uint64_t)product.hi + (lo == 0));
+    product.lo = -lo;
+  }
+  return product;
+}
+
+// Convert a sum to a Fixedpoint value, or an overflow value (with the
+// largest magnitude) if it is out of range
+static inline Fixedpoint wide_get(WideSum sum)
+{
+  if (sum.hi == 0)
+  {
+    return from_mag(sum.lo, 0);
+  }
+  if (sum.hi == -1 && sum.lo != 0)
+  {
+    return from_mag(-sum.lo, 1);
+  }
+  Fixedpoint result = from_mag(MAX_MAG, sum.hi < 0);
+  result.tag = sum.hi < 0 ? 3 : 4;
+  return result;
+}
+
+#endif // FIXEDPOINT_INTERNAL_H
@@ -0,0 +1,100 @@
+#ifndef FIXEDPOINT_LITERALS_HPP
+#define FIXEDPOINT_LITERALS_HPP
+
+// Compile-time Fixedpoint literals for C++, e.g.
+//
+//   using namespace fixedpoint::literals;
+//   constexpr Fixedpoint step = "0.8"_fx;
+//   Fixedpoint x = fixedpoint_add(y, "-1.8"_fx);
+//
+// The string is parsed by the compiler, with the same rules (and the same
+// result, bit for bit) as fixedpoint_create_from_hex.  In C++20 the
+// literal operator is consteval, so every literal is folded into a
+// constant and an invalid one is a compile error.  Before C++20 it is
+// constexpr: a literal is folded (and an invalid one rejected) wherever
+// a constant is required, such as a constexpr variable, and otherwise an
+// invalid literal gives an error value as fixedpoint_create_from_hex
+// does.
+
+#include <cstddef>
+#include "fixedpoint.h"
+
+#if defined(__cpp_consteval)
+#define FIXEDPOINT_CONSTEVAL consteval
+#else
+#define FIXEDPOINT_CONSTEVAL constexpr
+#endif
+
+namespace fixedpoint
+{
+
+namespace detail
+{
+
+// Not constexpr, so that reaching it while evaluating a literal at
+// compile time is an error naming the problem
+inline Fixedpoint invalid_hex_literal(const char *text)
+{
+  return fixedpoint_create_from_hex(text);
+}
+
+constexpr int hex_digit(char c)
+{
+  return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+constexpr Fixedpoint parse_hex_literal(const char *text, std::size_t len)
+{
+  Fixedpoint result{0, 0, 0};
+  // as with fixedpoint_create_from_hex, "." and "-." are zero
+  if ((len == 1 && text[0] == '.') || (len == 2 && text[0] == '-' && text[1] == '.'))
+  {
+    return result;
+  }
+
+  std::size_t start = len > 0 && text[0] == '-' ? 1 : 0;
+  std::size_t point = len;
+  for (std::size_t i = start; i < len; i++)
+  {
+    if (text[i] == '.' && point == len)
+    {
+      point = i;
+    }
+    else if (hex_digit(text[i]) < 0)
+    {
+      return invalid_hex_literal(text);
+    }
+  }
+  std::size_t frac_digits = point < len ? len - point - 1 : 0;
+  if (point - start > 16 || frac_digits > 16)
+  {
+    return invalid_hex_literal(text);
+  }
+
+  for (std::size_t i = start; i < point; i++)
+  {
+    result.integer = result.integer << 4 | static_cast<uint64_t>(hex_digit(text[i]));
+  }
+  for (std::size_t j = 0; j < frac_digits; j++)
+  {
+    result.fraction |= static_cast<uint64_t>(hex_digit(text[point + 1 + j])) << (60 - 4 * j);
+  }
+  result.tag = static_cast<int>(start);
+  return result;
+}
+
+} // namespace detail
+
+inline namespace literals
+{
+
+FIXEDPOINT_CONSTEVAL Fixedpoint operator""_fx(const char *text, std::size_t len)
+{
+  return detail::parse_hex_literal(text, len);
+}
+
+} // namespace literals
+
+} // namespace fixedpoint
+
+#endif // FIXEDPOINT_LITERALS_HPP
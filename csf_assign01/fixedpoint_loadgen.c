@@ -0,0 +1,202 @@
+// Load generator for the Fixedpoint arithmetic service (see
+// fixedpoint_service.h).
+//
+// Usage:
+//   fixedpoint_loadgen [-c connections] [-n requests] [-b ops] [-s seed] socket_path
+//
+// Each connection runs on a thread of its own, and sends requests of ops
+// random operations one at a time, until the connections have sent
+// requests requests between them.  Every result is checked against the
+// library, and the throughput and percentiles of the round trip time are
+// printed.  The exit status is 0 if every request succeeded with the
+// right results, 1 otherwise.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "fixedpoint.h"
+#include "fixedpoint_service.h"
+
+typedef struct
+{
+  const char *path;
+  uint64_t seed;
+  uint64_t num_requests;
+  uint32_t ops_per_request;
+  uint64_t *latencies; // round trip time of each request, in nanoseconds
+  uint64_t failures;
+} Connection;
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000UL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t next_rand(uint64_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// a random value, usually small enough that results don't overflow
+static Fixedpoint random_value(uint64_t *state)
+{
+  uint64_t r = next_rand(state);
+  Fixedpoint val = fixedpoint_create2((r & 0xf) == 0 ? next_rand(state) : next_rand(state) >> 40, next_rand(state));
+  val.tag = (int)(r >> 63);
+  return val;
+}
+
+static void *connection_main(void *arg)
+{
+  Connection *c = arg;
+  uint64_t state = c->seed * 0x9E3779B97F4A7C15UL + 1;
+  FixedpointServiceOp *ops = malloc(c->ops_per_request * sizeof(FixedpointServiceOp));
+  Fixedpoint *results = malloc(c->ops_per_request * sizeof(Fixedpoint));
+  FixedpointClient *client = fixedpoint_client_connect(c->path);
+  if (!client)
+  {
+    perror(c->path);
+    c->failures = c->num_requests;
+    c->num_requests = 0;
+  }
+
+  for (uint64_t r = 0; r < c->num_requests; r++)
+  {
+    for (uint32_t i = 0; i < c->ops_per_request; i++)
+    {
+      ops[i].op = (int)(next_rand(&state) % FIXEDPOINT_SERVICE_NUM_OPS);
+      ops[i].mode = (int)(next_rand(&state) % 5);
+      ops[i].left = random_value(&state);
+      ops[i].right = random_value(&state);
+    }
+    uint64_t start = now_ns();
+    int ok = fixedpoint_client_call(client, ops, results, c->ops_per_request);
+    c->latencies[r] = now_ns() - start;
+    for (uint32_t i = 0; ok && i < c->ops_per_request; i++)
+    {
+      Fixedpoint expected = fixedpoint_service_apply(&ops[i]);
+      ok = expected.integer == results[i].integer && expected.fraction == results[i].fraction &&
+           expected.tag == results[i].tag;
+    }
+    if (!ok)
+    {
+      c->failures++;
+    }
+  }
+  fixedpoint_client_close(client);
+  free(results);
+  free(ops);
+  return NULL;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+  long num_conns = 4;
+  uint64_t num_requests = 10000;
+  uint32_t ops_per_request = 64;
+  uint64_t seed = (uint64_t)time(NULL);
+  int opt;
+
+  while ((opt = getopt(argc, argv, "c:n:b:s:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'c':
+      num_conns = strtol(optarg, NULL, 0);
+      break;
+    case 'n':
+      num_requests = strtoull(optarg, NULL, 0);
+      break;
+    case 'b':
+      ops_per_request = (uint32_t)strtoul(optarg, NULL, 0);
+      break;
+    case 's':
+      seed = strtoull(optarg, NULL, 0);
+      break;
+    default:
+      optind = argc;
+    }
+  }
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "Usage: %s [-c connections] [-n requests] [-b ops] [-s seed] socket_path\n", argv[0]);
+    return 2;
+  }
+  if (num_conns < 1)
+  {
+    num_conns = 1;
+  }
+  if (ops_per_request < 1 || ops_per_request > FIXEDPOINT_SERVICE_MAX_OPS)
+  {
+    ops_per_request = ops_per_request < 1 ? 1 : FIXEDPOINT_SERVICE_MAX_OPS;
+  }
+
+  Connection *conns = calloc(num_conns, sizeof(Connection));
+  pthread_t *threads = calloc(num_conns, sizeof(pthread_t));
+  uint64_t *latencies = malloc((num_requests ? num_requests : 1) * sizeof(uint64_t));
+  uint64_t assigned = 0;
+  for (long i = 0; i < num_conns; i++)
+  {
+    conns[i].path = argv[optind];
+    conns[i].seed = seed + i;
+    conns[i].num_requests = num_requests / num_conns + ((uint64_t)i < num_requests % num_conns);
+    conns[i].ops_per_request = ops_per_request;
+    conns[i].latencies = latencies + assigned;
+    assigned += conns[i].num_requests;
+  }
+
+  uint64_t start = now_ns();
+  for (long i = 0; i < num_conns; i++)
+  {
+    pthread_create(&threads[i], NULL, connection_main, &conns[i]);
+  }
+  uint64_t done = 0, failures = 0;
+  for (long i = 0; i < num_conns; i++)
+  {
+    pthread_join(threads[i], NULL);
+    done += conns[i].num_requests;
+    failures += conns[i].failures;
+  }
+  double secs = (now_ns() - start) / 1e9;
+
+  // the requests of connections which failed to connect have no times
+  uint64_t timed = 0;
+  for (long i = 0; i < num_conns; i++)
+  {
+    memmove(latencies + timed, conns[i].latencies, conns[i].num_requests * sizeof(uint64_t));
+    timed += conns[i].num_requests;
+  }
+  qsort(latencies, timed, sizeof(uint64_t), compare_u64);
+  printf("%lu request(s) of %u op(s) on %ld connection(s) in %.2fs: %.0f requests/s, %.0f ops/s, %lu failure(s)\n",
+         done, ops_per_request, num_conns, secs, done / secs, done * (double)ops_per_request / secs, failures);
+  if (timed > 0)
+  {
+    static const double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+    printf("round trip");
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+    {
+      uint64_t rank = (uint64_t)(percentiles[i] * timed);
+      printf("%s p%g %.1fus", i ? "," : "", percentiles[i] * 100, latencies[rank < timed ? rank : timed - 1] / 1e3);
+    }
+    printf("\n");
+  }
+
+  free(latencies);
+  free(threads);
+  free(conns);
+  return failures != 0;
+}
@@ -0,0 +1,405 @@
+#include "fixedpoint.h"
+#include "fixedpoint_internal.h"
+#include "fixedpoint_math.h"
+
+// exp2_table[i - 1] is 2^(2^-i) in fixed point with 127 fraction bits
+// (hi, lo words), rounded to nearest
+static const struct
+{
+  uint64_t hi, lo;
+} exp2_table[64] = {
+  {0xb504f333f9de6484UL, 0x597d89b3754abe9fUL}, // 2^(2^-1)
+  {0x9837f0518db8a96fUL, 0x46ad23182e42f6f6UL}, // 2^(2^-2)
+  {0x8b95c1e3ea8bd6e6UL, 0xfbe4628758a53c90UL}, // 2^(2^-3)
+  {0x85aac367cc487b14UL, 0xc5c95b8c2154c1b2UL}, // 2^(2^-4)
+  {0x82cd8698ac2ba1d7UL, 0x3e2a475b46520bffUL}, // 2^(2^-5)
+  {0x8164d1f3bc030773UL, 0x7be56527bd14def5UL}, // 2^(2^-6)
+  {0x80b1ed4fd999ab6cUL, 0x25335719b6e6fd20UL}, // 2^(2^-7)
+  {0x8058d7d2d5e5f6b0UL, 0x94d589f608ee4aa2UL}, // 2^(2^-8)
+  {0x802c6436d0e04f50UL, 0xff8ce94a6797b3ceUL}, // 2^(2^-9)
+  {0x8016302f17467628UL, 0x3690dfe44d11d008UL}, // 2^(2^-10)
+  {0x800b179c82028fd0UL, 0x945e54e2ae18f2f0UL}, // 2^(2^-11)
+  {0x80058baf7fee3b5dUL, 0x1c718b38e549cb93UL}, // 2^(2^-12)
+  {0x8002c5d00fdcfcb6UL, 0xb6566a58c048be1fUL}, // 2^(2^-13)
+  {0x800162e61bed4a48UL, 0xe84c2e1a463473daUL}, // 2^(2^-14)
+  {0x8000b17292f702a3UL, 0xaa22beacca949013UL}, // 2^(2^-15)
+  {0x800058b92abbae02UL, 0x030c5fa5256f41feUL}, // 2^(2^-16)
+  {0x80002c5c8dade4d7UL, 0x1776c0f4dbea67d6UL}, // 2^(2^-17)
+  {0x8000162e44eaf636UL, 0x526be456600bdbe5UL}, // 2^(2^-18)
+  {0x80000b1721fa7c18UL, 0x8307016c1cd4e8b7UL}, // 2^(2^-19)
+  {0x8000058b90de7e4cUL, 0xecfc487503488bb2UL}, // 2^(2^-20)
+  {0x800002c5c8678f36UL, 0xcbfce50a6de60b14UL}, // 2^(2^-21)
+  {0x80000162e431db9fUL, 0x80b2347b5d62e516UL}, // 2^(2^-22)
+  {0x800000b1721872d0UL, 0xc7b08cf1e0114153UL}, // 2^(2^-23)
+  {0x80000058b90c1aa8UL, 0xa5c3736cb77e8e00UL}, // 2^(2^-24)
+  {0x8000002c5c8605a4UL, 0x635f2efc2362d978UL}, // 2^(2^-25)
+  {0x800000162e4300e6UL, 0x35cf4a109e3939bdUL}, // 2^(2^-26)
+  {0x8000000b17217ff8UL, 0x1bef9c551590cf83UL}, // 2^(2^-27)
+  {0x800000058b90bfddUL, 0x4e39cd52c0cfa27dUL}, // 2^(2^-28)
+  {0x80000002c5c85fe6UL, 0xf72d669e0e76e412UL}, // 2^(2^-29)
+  {0x8000000162e42ff1UL, 0x8f9ad35186d0df28UL}, // 2^(2^-30)
+  {0x80000000b17217f8UL, 0x4cce71aa0dcfffe8UL}, // 2^(2^-31)
+  {0x8000000058b90bfcUL, 0x07a77ad56ed22aaaUL}, // 2^(2^-32)
+  {0x800000002c5c85fdUL, 0xfc23cdead40da8d7UL}, // 2^(2^-33)
+  {0x80000000162e42feUL, 0xfc25eb1571853a66UL}, // 2^(2^-34)
+  {0x800000000b17217fUL, 0x7d97f692baacded5UL}, // 2^(2^-35)
+  {0x80000000058b90bfUL, 0xbead3b8b5dd254d8UL}, // 2^(2^-36)
+  {0x8000000002c5c85fUL, 0xdf4eedd62f084e68UL}, // 2^(2^-37)
+  {0x800000000162e42fUL, 0xefa58aef378bf587UL}, // 2^(2^-38)
+  {0x8000000000b17217UL, 0xf7d24a78a3c7ef03UL}, // 2^(2^-39)
+  {0x800000000058b90bUL, 0xfbe9067c93e474a6UL}, // 2^(2^-40)
+  {0x80000000002c5c85UL, 0xfdf47b8e5a72599fUL}, // 2^(2^-41)
+  {0x8000000000162e42UL, 0xfefa3bdb315934a3UL}, // 2^(2^-42)
+  {0x80000000000b1721UL, 0x7f7d1d7299b49c46UL}, // 2^(2^-43)
+  {0x8000000000058b90UL, 0xbfbe8e9a8d1c4ea0UL}, // 2^(2^-44)
+  {0x800000000002c5c8UL, 0x5fdf4745969ea76fUL}, // 2^(2^-45)
+  {0x80000000000162e4UL, 0x2fefa3a0df5373c0UL}, // 2^(2^-46)
+  {0x800000000000b172UL, 0x17f7d1cff4aac1e2UL}, // 2^(2^-47)
+  {0x80000000000058b9UL, 0x0bfbe8e7db95a2f1UL}, // 2^(2^-48)
+  {0x8000000000002c5cUL, 0x85fdf473e61ae1f9UL}, // 2^(2^-49)
+  {0x800000000000162eUL, 0x42fefa39f121751cUL}, // 2^(2^-50)
+  {0x8000000000000b17UL, 0x217f7d1cf815bb96UL}, // 2^(2^-51)
+  {0x800000000000058bUL, 0x90bfbe8e7bec1e0dUL}, // 2^(2^-52)
+  {0x80000000000002c5UL, 0xc85fdf473dee5f17UL}, // 2^(2^-53)
+  {0x8000000000000162UL, 0xe42fefa39ef54390UL}, // 2^(2^-54)
+  {0x80000000000000b1UL, 0x7217f7d1cf7a26c9UL}, // 2^(2^-55)
+  {0x8000000000000058UL, 0xb90bfbe8e7bcf4a5UL}, // 2^(2^-56)
+  {0x800000000000002cUL, 0x5c85fdf473de72a2UL}, // 2^(2^-57)
+  {0x8000000000000016UL, 0x2e42fefa39ef3765UL}, // 2^(2^-58)
+  {0x800000000000000bUL, 0x17217f7d1cf79b38UL}, // 2^(2^-59)
+  {0x8000000000000005UL, 0x8b90bfbe8e7bcd7dUL}, // 2^(2^-60)
+  {0x8000000000000002UL, 0xc5c85fdf473de6b7UL}, // 2^(2^-61)
+  {0x8000000000000001UL, 0x62e42fefa39ef359UL}, // 2^(2^-62)
+  {0x8000000000000000UL, 0xb17217f7d1cf79acUL}, // 2^(2^-63)
+  {0x8000000000000000UL, 0x58b90bfbe8e7bcd6UL}, // 2^(2^-64)
+};
+
+static Fixedpoint error_value(void)
+{
+  Fixedpoint result = fixedpoint_create(0UL);
+  result.tag = 2;
+  fixedpoint_status_raise(1 << result.tag);
+  return result;
+}
+
+// Round mag >> shift (shift >= 1) according to mode.  sticky is
+// 1 if the exact result is known to be above mag * 2^-shift.
+static Fixedpoint round_shifted(u128 mag, int shift, int sticky, int neg, int mode)
+{
+  if (shift > 128)
+  {
+    return round_mag(0, 0, sticky | (mag != 0), neg, mode);
+  }
+  u128 q = (shift == 128) ? 0 : mag >> shift;
+  int half = (int)(mag >> (shift - 1)) & 1;
+  if (shift > 1)
+  {
+    sticky |= (mag << (129 - shift)) != 0;
+  }
+  return round_mag(q, half, sticky, neg, mode);
+}
+
+Fixedpoint fixedpoint_sqrt(Fixedpoint val, int mode)
+{
+  u128 mag = get_mag(val);
+  if (get_neg(val))
+  {
+    return error_value();
+  }
+
+  // Digit-by-digit square root of the 192 bit value N = mag * 2^64, two
+  // bits of N (one bit of the root) per step.  The remainder N - root^2
+  // is at most 2 * root, so it fits in 98 bits.
+  u128 root = 0, rem = 0;
+  for (int i = 95; i >= 0; i--)
+  {
+    u128 pair = (i >= 32) ? (mag >> (2 * i - 64)) & 3 : 0;
+    rem = (rem << 2) | pair;
+    u128 trial = (root << 2) | 1;
+    u128 take = rem >= trial;
+    rem -= trial & -take;
+    root = (root << 1) | take;
+  }
+
+  // The true root is at least root + 1/2 iff N >= root^2 + root + 1/4,
+  // i.e. rem > root.  It is never exactly halfway.
+  return round_mag(root, rem > root, rem != 0, 0, mode);
+}
+
+Fixedpoint fixedpoint_exp2(Fixedpoint val, int mode)
+{
+  // split val into n + f, where n is an integer and 0 <= f < 1 (in units
+  // of 2^-64); very negative n are clamped, since they all round the same
+  uint64_t whole = val.integer, f = val.fraction;
+  int64_t n;
+  if (get_neg(val))
+  {
+    n = -(int64_t)(whole > 256 ? 256 : whole) - (f != 0);
+    f = -f;
+  }
+  else if (whole >= 64)
+  {
+    Fixedpoint result = from_mag(MAX_MAG, 0);
+    result.tag = 4;
+    fixedpoint_status_raise(1 << result.tag);
+    return result;
+  }
+  else
+  {
+    n = (int64_t)whole;
+  }
+
+  // 2^f is the product of 2^(2^-i) over the set bits i of f.  acc holds
+  // it with 127 fraction bits; each step truncates, so with the table's
+  // rounding the relative error stays below 64 * 2^-126.
+  u128 acc = (u128)1 << 127;
+  for (int i = 1; i <= 64; i++)
+  {
+    if ((f >> (64 - i)) & 1)
+    {
+      u128 hi, lo;
+      mul_mag(acc, ((u128)exp2_table[i - 1].hi << 64) | exp2_table[i - 1].lo, &hi, &lo);
+      acc = (hi << 1) | (lo >> 127);
+    }
+  }
+
+  // The result is acc * 2^(n - 127), i.e. acc * 2^(n - 63) in units of
+  // 2^-64.  2^f is irrational for f != 0, so the result is then inexact.
+  if (n == 63)
+  {
+    return round_mag(acc, 0, f != 0, 0, mode);
+  }
+  return round_shifted(acc, (int)(63 - n), f != 0, 0, mode);
+}
+
+Fixedpoint fixedpoint_log2(Fixedpoint val, int mode)
+{
+  u128 mag = get_mag(val);
+  if (mag == 0 || get_neg(val))
+  {
+    return error_value();
+  }
+
+  // val = 2^e * y / 2^127 with 2^127 <= y < 2^128
+  int top = 127;
+  while (!(mag >> top))
+  {
+    top--;
+  }
+  int e = top - 64;
+  u128 y = mag << (127 - top);
+  // log2 of y / 2^127 is irrational unless y / 2^127 = 1
+  int sticky = y != (u128)1 << 127;
+
+  // Each squaring of y / 2^127 doubles its logarithm; when the square is
+  // at least 2, the next fraction bit is 1 and the square is halved.
+  // Collect 66 bits: 64 for the result, then the half and a sticky bit.
+  u128 frac = 0;
+  for (int i = 0; i < 66; i++)
+  {
+    u128 hi, lo;
+    mul_mag(y, y, &hi, &lo);
+    int bit = (int)(hi >> 127);
+    y = bit ? hi : (hi << 1) | (lo >> 127);
+    frac = (frac << 1) | bit;
+  }
+
+  // The logarithm, in units of 2^-66, is e * 2^66 + frac plus a positive
+  // amount less than one unit if sticky is set.  For negative e, take the
+  // magnitude, moving the extra amount to the unit below.
+  u128 total;
+  int neg = e < 0;
+  if (neg)
+  {
+    total = ((u128)-e << 66) - frac - sticky;
+  }
+  else
+  {
+    total = ((u128)e << 66) + frac;
+  }
+  return round_shifted(total, 2, sticky, neg, mode);
+}
+
+void fixedpoint_sqrt_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_sqrt(vals[i], mode);
+  }
+}
+
+void fixedpoint_exp2_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_exp2(vals[i], mode);
+  }
+}
+
+void fixedpoint_log2_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    out[i] = fixedpoint_log2(vals[i], mode);
+  }
+}
+
+// number of points evaluated together by fixedpoint_poly_eval_n
+#define POLY_LANES 4
+
+// Accumulator for polynomial evaluation: a sign/magnitude value with 128
+// whole bits and 64 fraction bits, stored as three 64 bit limbs (least
+// significant first)
+typedef struct
+{
+  uint64_t limb[3];
+  int neg;
+  int overflow;
+  int inexact;
+} PolyAcc;
+
+static void poly_init(PolyAcc *acc, Fixedpoint c)
+{
+  u128 mag = get_mag(c);
+  acc->limb[0] = (uint64_t)mag;
+  acc->limb[1] = (uint64_t)(mag >> 64);
+  acc->limb[2] = 0;
+  acc->neg = get_neg(c);
+  acc->overflow = 0;
+  acc->inexact = 0;
+}
+
+// acc = acc * x + c, where x has magnitude xmag and sign xneg
+static void poly_step(PolyAcc *acc, u128 xmag, int xneg, Fixedpoint c)
+{
+  uint64_t x[2] = {(uint64_t)xmag, (uint64_t)(xmag >> 64)};
+  uint64_t p[5] = {0, 0, 0, 0, 0};
+
+  // 320 bit product of the limbs, with 128 fraction bits
+  for (int i = 0; i < 3; i++)
+  {
+    u128 carry = 0;
+    for (int j = 0; j < 2; j++)
+    {
+      u128 t = (u128)acc->limb[i] * x[j] + p[i + j] + carry;
+      p[i + j] = (uint64_t)t;
+      carry = t >> 64;
+    }
+    p[i + 2] = (uint64_t)carry;
+  }
+  acc->inexact |= p[0] != 0;
+  acc->overflow |= p[4] != 0;
+  acc->limb[0] = p[1];
+  acc->limb[1] = p[2];
+  acc->limb[2] = p[3];
+  acc->neg ^= xneg;
+
+  // add c in sign/magnitude; the limbs are compared from the top
+  uint64_t cl[3] = {(uint64_t)get_mag(c), (uint64_t)(get_mag(c) >> 64), 0};
+  int cneg = get_neg(c);
+  if (acc->neg == cneg)
+  {
+    u128 carry = 0;
+    for (int i = 0; i < 3; i++)
+    {
+      u128 t = (u128)acc->limb[i] + cl[i] + carry;
+      acc->limb[i] = (uint64_t)t;
+      carry = t >> 64;
+    }
+    acc->overflow |= carry != 0;
+  }
+  else
+  {
+    int i = 2;
+    while (i > 0 && acc->limb[i] == cl[i])
+    {
+      i--;
+    }
+    const uint64_t *big = acc->limb, *small = cl;
+    if (acc->limb[i] < cl[i])
+    {
+      big = cl;
+      small = acc->limb;
+      acc->neg = cneg;
+    }
+    uint64_t diff[3];
+    uint64_t borrow = 0;
+    for (int k = 0; k < 3; k++)
+    {
+      u128 t = (u128)big[k] - small[k] - borrow;
+      diff[k] = (uint64_t)t;
+      borrow = (uint64_t)(t >> 127);
+    }
+    acc->limb[0] = diff[0];
+    acc->limb[1] = diff[1];
+    acc->limb[2] = diff[2];
+  }
+}
+
+// Convert an accumulator to a Fixedpoint value, raising the status flag
+// for an exceptional result
+static Fixedpoint poly_finish(const PolyAcc *acc)
+{
+  Fixedpoint result;
+  if (acc->overflow || acc->limb[2] != 0)
+  {
+    result = from_mag(MAX_MAG, acc->neg);
+    result.tag = acc->neg ? 3 : 4;
+  }
+  else
+  {
+    result = from_mag(((u128)acc->limb[1] << 64) | acc->limb[0], acc->neg);
+    if (acc->inexact)
+    {
+      result.tag = acc->neg ? 5 : 6;
+    }
+  }
+  fixedpoint_status_raise(1 << result.tag);
+  return result;
+}
+
+size_t fixedpoint_poly_eval_n(const Fixedpoint *coeffs, int degree, const Fixedpoint *xs, Fixedpoint *out,
+                              size_t n)
+{
+  size_t invalid = 0;
+
+  // there is no polynomial of negative degree
+  if (degree < 0)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      out[i] = error_value();
+    }
+    return n;
+  }
+
+  for (size_t base = 0; base < n; base += POLY_LANES)
+  {
+    size_t lanes = n - base < POLY_LANES ? n - base : POLY_LANES;
+    PolyAcc acc[POLY_LANES];
+    u128 xmag[POLY_LANES];
+    int xneg[POLY_LANES];
+
+    for (size_t l = 0; l < lanes; l++)
+    {
+      poly_init(&acc[l], coeffs[degree]);
+      xmag[l] = get_mag(xs[base + l]);
+      xneg[l] = get_neg(xs[base + l]);
+    }
+    // the lanes' steps don't depend on each other, so their
+    // multiplications can overlap
+    for (int k = degree - 1; k >= 0; k--)
+    {
+      for (size_t l = 0; l < lanes; l++)
+      {
+        poly_step(&acc[l], xmag[l], xneg[l], coeffs[k]);
+      }
+    }
+    for (size_t l = 0; l < lanes; l++)
+    {
+      out[base + l] = poly_finish(&acc[l]);
+      invalid += !fixedpoint_is_valid(out[base + l]);
+    }
+  }
+  return invalid;
+}
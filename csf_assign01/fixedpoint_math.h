@@ -0,0 +1,99 @@
+#ifndef FIXEDPOINT_MATH_H
+#define FIXEDPOINT_MATH_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Elementary functions computed directly on the 64.64 representation,
+// without converting to double.  Like the other rounding operations, each
+// takes one of the FIXEDPOINT_ROUND_ modes; with FIXEDPOINT_ROUND_EXACT,
+// a result which can't be represented exactly is an underflow value.
+// Exceptional results raise the sticky status flags.
+
+// Compute the square root of a valid Fixedpoint value.  The result is
+// correctly rounded (computed digit by digit on the exact 192 bit value
+// val * 2^64), and can never overflow.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded square root; an underflow value if mode is
+//   FIXEDPOINT_ROUND_EXACT and the root isn't exact; or a value for which
+//   fixedpoint_is_err returns true if val is negative
+Fixedpoint fixedpoint_sqrt(Fixedpoint val, int mode);
+
+// Compute 2^val for a valid Fixedpoint value.  The power is computed with
+// a relative error below 2^-120 before the final rounding, so results less
+// than 2^56 are within one unit in the last place (2^-64), and are exact
+// when val is an integer.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded power; an overflow value if val >= 64; or, if mode is
+//   FIXEDPOINT_ROUND_EXACT, an underflow value if the power isn't exact
+Fixedpoint fixedpoint_exp2(Fixedpoint val, int mode);
+
+// Compute the base 2 logarithm of a valid Fixedpoint value.  The result
+// is within one unit in the last place (2^-64) of the true logarithm, and
+// is exact when val is a power of 2.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded logarithm; an underflow value if mode is
+//   FIXEDPOINT_ROUND_EXACT and the logarithm isn't exact; or a value for
+//   which fixedpoint_is_err returns true if val is zero or negative
+Fixedpoint fixedpoint_log2(Fixedpoint val, int mode);
+
+// Batch versions of the functions above.  out[i] is the result of
+// fixedpoint_sqrt (etc.) on vals[i], using the same rounding mode for
+// every element.  The output array may be the same as the input array.
+//
+// Parameters:
+//   vals - array of n operands
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_sqrt_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t n);
+void fixedpoint_exp2_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t n);
+void fixedpoint_log2_n(const Fixedpoint *vals, int mode, Fixedpoint *out, size_t n);
+
+// Evaluate the polynomial coeffs[0] + coeffs[1] x + ... + coeffs[degree]
+// x^degree at each of n points, using Horner's rule.  The running value
+// is kept in a wide accumulator (128 whole bits and 64 fraction bits), so
+// intermediate values may exceed the Fixedpoint range as long as the
+// final result is in range.  Each product is truncated toward zero, as by
+// fixedpoint_mul.  Several points are evaluated together, so that their
+// multiplications are independent.
+//
+// Parameters:
+//   coeffs - array of degree + 1 valid coefficients, constant term first
+//   degree - the degree of the polynomial (if it is negative, every
+//            result is an error value)
+//   xs - array of n valid points
+//   out - array of n results (may be the same as xs)
+//   n - number of elements
+//
+// Returns:
+//   the number of results which are not valid: out[i] is an overflow
+//   value if the result (or an intermediate value) was too large for the
+//   accumulator, or else an underflow value if any product was truncated
+size_t fixedpoint_poly_eval_n(const Fixedpoint *coeffs, int degree, const Fixedpoint *xs, Fixedpoint *out,
+                              size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_MATH_H
@@ -0,0 +1,335 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "fixedpoint_internal.h"
+#include "fixedpoint_matrix.h"
+
+// Blocking: each task computes an MC x NC block of C, taking the inner
+// dimension KC values at a time, so that the packed blocks of A and B and
+// the block's accumulators stay in the L2 cache.  Within a block, the
+// microkernel computes MR x NR elements at once, loading each packed
+// value once for NR (or MR) products.
+#define MC 32
+#define NC 32
+#define KC 128
+#define MR 2
+#define NR 2
+
+// A packed operand: the magnitude, and a sign mask (all ones if negative)
+typedef struct
+{
+  uint64_t lo, hi;
+  uint64_t neg;
+} Packed;
+
+// Exact sum of products, in two's complement with 128 fraction bits and
+// 192 whole bits (least significant limb first).  A product of two
+// magnitudes is less than 2^256, so fewer than 2^63 of them can't
+// overflow it.
+typedef struct
+{
+  uint64_t limb[5];
+} Acc;
+
+typedef struct
+{
+  const Fixedpoint *a, *b;
+  size_t lda, ldb;
+  Fixedpoint *c;
+  size_t ldc;
+  size_t m, n, k;
+  int mode;
+  const unsigned char *bad_row, *bad_col; // rows of A and columns of B with invalid values
+  size_t row_blocks, num_tasks;
+  _Atomic size_t next_task;
+  _Atomic size_t invalid;
+  _Atomic int flags; // status flags of the worker threads
+} Gemm;
+
+static inline Packed pack_value(Fixedpoint val)
+{
+  Packed p = {val.fraction, val.integer, -(uint64_t)get_neg(val)};
+  // an invalid value contributes nothing (its results are errors anyway)
+  if (val.tag > 1)
+  {
+    p.lo = p.hi = p.neg = 0;
+  }
+  return p;
+}
+
+// Pack rows i0..i0+mb of A, columns p0..p0+kb, as panels of MR rows, each
+// stored column by column; rows past the end of the block are zero
+static void pack_a(const Gemm *g, size_t i0, size_t mb, size_t p0, size_t kb, Packed *out)
+{
+  static const Packed zero = {0, 0, 0};
+  for (size_t ir = 0; ir < mb; ir += MR)
+  {
+    for (size_t p = 0; p < kb; p++)
+    {
+      for (size_t r = 0; r < MR; r++)
+      {
+        *out++ = ir + r < mb ? pack_value(g->a[(i0 + ir + r) * g->lda + p0 + p]) : zero;
+      }
+    }
+  }
+}
+
+// Pack rows p0..p0+kb of B, columns j0..j0+nb, as panels of NR columns,
+// each stored row by row; columns past the end of the block are zero
+static void pack_b(const Gemm *g, size_t j0, size_t nb, size_t p0, size_t kb, Packed *out)
+{
+  static const Packed zero = {0, 0, 0};
+  for (size_t jr = 0; jr < nb; jr += NR)
+  {
+    for (size_t p = 0; p < kb; p++)
+    {
+      const Fixedpoint *row = &g->b[(p0 + p) * g->ldb + j0 + jr];
+      for (size_t r = 0; r < NR; r++)
+      {
+        *out++ = jr + r < nb ? pack_value(row[r]) : zero;
+      }
+    }
+  }
+}
+
+// Add the product of two packed values to an accumulator.  The product is
+// negated (as its complement plus one) when the signs differ, so there
+// are no branches on the data.
+static inline void acc_add_product(Acc *acc, const Packed *x, const Packed *y)
+{
+  u128 hi, lo;
+  mul_mag(((u128)x->hi << 64) | x->lo, ((u128)y->hi << 64) | y->lo, &hi, &lo);
+  uint64_t s = x->neg ^ y->neg;
+
+  u128 t = (u128)acc->limb[0] + ((uint64_t)lo ^ s) + (s & 1);
+  acc->limb[0] = (uint64_t)t;
+  t = (t >> 64) + acc->limb[1] + ((uint64_t)(lo >> 64) ^ s);
+  acc->limb[1] = (uint64_t)t;
+  t = (t >> 64) + acc->limb[2] + ((uint64_t)hi ^ s);
+  acc->limb[2] = (uint64_t)t;
+  t = (t >> 64) + acc->limb[3] + ((uint64_t)(hi >> 64) ^ s);
+  acc->limb[3] = (uint64_t)t;
+  acc->limb[4] += s + (uint64_t)(t >> 64);
+}
+
+// Accumulate an MR x NR tile of products over kb packed columns of A and
+// rows of B.  The tile's accumulators are kept in locals (registers, as
+// far as there are enough) for the whole loop.
+static void microkernel(const Packed *ap, const Packed *bp, size_t kb, Acc *tile)
+{
+  Acc c00 = tile[0], c01 = tile[1], c10 = tile[2], c11 = tile[3];
+  for (size_t p = 0; p < kb; p++, ap += MR, bp += NR)
+  {
+    acc_add_product(&c00, &ap[0], &bp[0]);
+    acc_add_product(&c01, &ap[0], &bp[1]);
+    acc_add_product(&c10, &ap[1], &bp[0]);
+    acc_add_product(&c11, &ap[1], &bp[1]);
+  }
+  tile[0] = c00;
+  tile[1] = c01;
+  tile[2] = c10;
+  tile[3] = c11;
+}
+
+// Round an accumulator to a Fixedpoint value, raising the status flag for
+// an exceptional result
+static Fixedpoint acc_finish(const Acc *acc, int mode)
+{
+  uint64_t mag[5];
+  int neg = (int)(acc->limb[4] >> 63);
+  uint64_t s = -(uint64_t)neg;
+  u128 t = neg;
+  for (int i = 0; i < 5; i++)
+  {
+    t += acc->limb[i] ^ s;
+    mag[i] = (uint64_t)t;
+    t >>= 64;
+  }
+  if (mag[3] | mag[4])
+  {
+    Fixedpoint result = from_mag(MAX_MAG, neg);
+    result.tag = neg ? 3 : 4;
+    fixedpoint_status_raise(1 << result.tag);
+    return result;
+  }
+  u128 q = ((u128)mag[2] << 64) | mag[1];
+  return round_mag(q, (int)(mag[0] >> 63), (mag[0] << 1) != 0, neg, mode);
+}
+
+// Compute one MC x NC block of C
+static size_t gemm_block(const Gemm *g, size_t task, Packed *apack, Packed *bpack, Acc *accs)
+{
+  size_t i0 = task % g->row_blocks * MC;
+  size_t j0 = task / g->row_blocks * NC;
+  size_t mb = g->m - i0 < MC ? g->m - i0 : MC;
+  size_t nb = g->n - j0 < NC ? g->n - j0 : NC;
+  size_t row_panels = (mb + MR - 1) / MR;
+  size_t col_panels = (nb + NR - 1) / NR;
+
+  // the accumulators are stored tile by tile, MR x NR at a time
+  memset(accs, 0, row_panels * col_panels * MR * NR * sizeof(Acc));
+  for (size_t p0 = 0; p0 < g->k; p0 += KC)
+  {
+    size_t kb = g->k - p0 < KC ? g->k - p0 : KC;
+    pack_a(g, i0, mb, p0, kb, apack);
+    pack_b(g, j0, nb, p0, kb, bpack);
+    for (size_t jr = 0; jr < col_panels; jr++)
+    {
+      for (size_t ir = 0; ir < row_panels; ir++)
+      {
+        microkernel(&apack[ir * kb * MR], &bpack[jr * kb * NR], kb, &accs[(jr * row_panels + ir) * MR * NR]);
+      }
+    }
+  }
+
+  size_t invalid = 0;
+  for (size_t i = 0; i < mb; i++)
+  {
+    for (size_t j = 0; j < nb; j++)
+    {
+      Fixedpoint *out = &g->c[(i0 + i) * g->ldc + j0 + j];
+      if (g->bad_row[i0 + i] | g->bad_col[j0 + j])
+      {
+        *out = fixedpoint_create(0UL);
+        out->tag = 2;
+        fixedpoint_status_raise(FIXEDPOINT_STATUS_ERR);
+      }
+      else
+      {
+        const Acc *tile = &accs[(j / NR * row_panels + i / MR) * MR * NR];
+        *out = acc_finish(&tile[i % MR * NR + j % NR], g->mode);
+      }
+      invalid += !fixedpoint_is_valid(*out);
+    }
+  }
+  return invalid;
+}
+
+static void *gemm_worker(void *arg)
+{
+  Gemm *g = arg;
+  Packed *apack = malloc(MC * KC * sizeof(Packed));
+  Packed *bpack = malloc(KC * NC * sizeof(Packed));
+  Acc *accs = malloc(MC * NC * sizeof(Acc));
+  if (!apack || !bpack || !accs)
+  {
+    // leave the blocks to the other threads
+    free(accs);
+    free(bpack);
+    free(apack);
+    return NULL;
+  }
+
+  size_t invalid = 0;
+  size_t task;
+  while ((task = atomic_fetch_add(&g->next_task, 1)) < g->num_tasks)
+  {
+    invalid += gemm_block(g, task, apack, bpack, accs);
+  }
+  atomic_fetch_add(&g->invalid, invalid);
+  atomic_fetch_or(&g->flags, fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+  free(accs);
+  free(bpack);
+  free(apack);
+  return NULL;
+}
+
+// Make every element of C an error value, when it can't be computed
+static size_t fill_errors(Fixedpoint *c, size_t ldc, size_t m, size_t n)
+{
+  Fixedpoint error = fixedpoint_create(0UL);
+  error.tag = 2;
+  for (size_t i = 0; i < m; i++)
+  {
+    for (size_t j = 0; j < n; j++)
+    {
+      c[i * ldc + j] = error;
+    }
+  }
+  fixedpoint_status_raise(1 << error.tag);
+  return m * n;
+}
+
+size_t fixedpoint_gemm(const Fixedpoint *a, size_t lda, const Fixedpoint *b, size_t ldb, Fixedpoint *c, size_t ldc,
+                       size_t m, size_t n, size_t k, int mode, int num_threads)
+{
+  if (m == 0 || n == 0)
+  {
+    return 0;
+  }
+
+  Gemm g;
+  g.a = a;
+  g.b = b;
+  g.lda = lda;
+  g.ldb = ldb;
+  g.c = c;
+  g.ldc = ldc;
+  g.m = m;
+  g.n = n;
+  g.k = k;
+  g.mode = mode;
+  g.row_blocks = (m + MC - 1) / MC;
+  g.num_tasks = g.row_blocks * ((n + NC - 1) / NC);
+  atomic_init(&g.next_task, 0);
+  atomic_init(&g.invalid, 0);
+  atomic_init(&g.flags, 0);
+
+  unsigned char *bad_row = calloc(m + n, 1);
+  if (!bad_row)
+  {
+    return fill_errors(c, ldc, m, n);
+  }
+  unsigned char *bad_col = bad_row + m;
+  for (size_t i = 0; i < m; i++)
+  {
+    for (size_t p = 0; p < k; p++)
+    {
+      bad_row[i] |= !fixedpoint_is_valid(a[i * lda + p]);
+    }
+  }
+  for (size_t p = 0; p < k; p++)
+  {
+    for (size_t j = 0; j < n; j++)
+    {
+      bad_col[j] |= !fixedpoint_is_valid(b[p * ldb + j]);
+    }
+  }
+  g.bad_row = bad_row;
+  g.bad_col = bad_col;
+
+  if (num_threads < 1)
+  {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = cpus > 0 ? (int)cpus : 1;
+  }
+  if ((size_t)num_threads > g.num_tasks)
+  {
+    num_threads = (int)g.num_tasks;
+  }
+
+  // the calling thread is one of the workers
+  pthread_t *threads = malloc((num_threads - 1) * sizeof(pthread_t) + 1);
+  int started = 0;
+  while (threads && started < num_threads - 1 && pthread_create(&threads[started], NULL, gemm_worker, &g) == 0)
+  {
+    started++;
+  }
+  gemm_worker(&g);
+  for (int i = 0; i < started; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  free(bad_row);
+
+  // the workers' status flags are thread-local, so raise them here
+  fixedpoint_status_raise(atomic_load(&g.flags));
+  if (atomic_load(&g.next_task) < g.num_tasks)
+  {
+    // no thread could allocate its buffers, so no task was done
+    return fill_errors(c, ldc, m, n);
+  }
+  return atomic_load(&g.invalid);
+}
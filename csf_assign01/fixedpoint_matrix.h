@@ -0,0 +1,52 @@
+#ifndef FIXEDPOINT_MATRIX_H
+#define FIXEDPOINT_MATRIX_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Matrix multiplication over Fixedpoint values.
+//
+// Matrices are arrays of values in row-major order, where the rows of a
+// matrix with leading dimension ld start ld elements apart.
+
+// Compute the product C = A B of an m x k matrix A and a k x n matrix B.
+// Each element of C is the exact dot product of a row of A and a column
+// of B (the products and their sum are kept in an accumulator wide enough
+// to hold them all exactly, so intermediate sums may be out of range),
+// rounded once according to mode.
+//
+// The work is split into blocks of C, which are computed on several
+// threads.  The status flags raised by the results are raised in the
+// calling thread.
+//
+// Parameters:
+//   a - the m x k matrix A
+//   lda - the leading dimension of A (at least k)
+//   b - the k x n matrix B
+//   ldb - the leading dimension of B (at least n)
+//   c - the m x n result C (which must not overlap A or B)
+//   ldc - the leading dimension of C (at least n)
+//   m, n, k - the dimensions
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//   num_threads - the most threads to use (0 means one per online CPU)
+//
+// Returns:
+//   the number of elements of C which are not valid: an element is a
+//   value for which fixedpoint_is_err returns true if its row of A or
+//   column of B has a value which isn't valid, otherwise an overflow
+//   value if its magnitude is too large to represent, or (if mode is
+//   FIXEDPOINT_ROUND_EXACT) an underflow value if it has nonzero bits
+//   beyond the 64 bits of the fractional part; or m * n if memory
+//   couldn't be allocated, in which case every element is an error value
+size_t fixedpoint_gemm(const Fixedpoint *a, size_t lda, const Fixedpoint *b, size_t ldb, Fixedpoint *c, size_t ldc,
+                       size_t m, size_t n, size_t k, int mode, int num_threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_MATRIX_H
@@ -0,0 +1,371 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "fixedpoint.h"
+#include "fixedpoint_pipeline.h"
+
+// the stages with threads, and the sink (which runs on the calling thread)
+enum
+{
+  STAGE_PARSE,
+  STAGE_COMPUTE,
+  STAGE_FORMAT,
+  STAGE_SINK,
+  NUM_STAGES
+};
+
+typedef struct
+{
+  size_t seq; // position of the batch in the input
+  size_t n;   // number of lines
+  Fixedpoint *vals;
+  char *text; // formatted output
+  size_t len; // length of the output
+} Batch;
+
+// A bounded lock-free queue of batch pointers, for any number of
+// producers and consumers (Vyukov's algorithm).  Each cell's sequence
+// number says whether it is ready to be written or read in the current
+// lap around the ring.  A NULL batch tells a stage thread to stop.
+typedef struct
+{
+  _Atomic size_t seq;
+  Batch *batch;
+} Cell;
+
+typedef struct
+{
+  Cell *cells;
+  size_t mask;
+  // producers and consumers each get a cache line of their own
+  _Alignas(64) _Atomic size_t tail;
+  _Alignas(64) _Atomic size_t head;
+} Ring;
+
+typedef struct
+{
+  const char *const *lines;
+  size_t n;
+  FixedpointPipelineTransform transform;
+  void *transform_ctx;
+  size_t batch_size;
+  size_t num_batches; // batches needed for all the lines
+
+  // rings[s] holds the batches waiting for stage s, where the batches
+  // waiting for the parse stage are the free ones
+  Ring rings[NUM_STAGES];
+  int num_threads[NUM_STAGES];
+  _Atomic int running[NUM_STAGES];
+
+  _Atomic size_t next_seq; // the next batch to parse
+  _Atomic int cancel;      // set to stop parsing new batches
+  _Atomic int flags;       // status flags of the stage threads
+} Pipeline;
+
+static int ring_init(Ring *ring, size_t min_capacity)
+{
+  size_t capacity = 1;
+  while (capacity < min_capacity)
+  {
+    capacity *= 2;
+  }
+  ring->cells = malloc(capacity * sizeof(Cell));
+  if (!ring->cells)
+  {
+    return 0;
+  }
+  for (size_t i = 0; i < capacity; i++)
+  {
+    atomic_init(&ring->cells[i].seq, i);
+  }
+  ring->mask = capacity - 1;
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->head, 0);
+  return 1;
+}
+
+// Add a batch to a ring, returning 0 if it is full
+static int ring_try_push(Ring *ring, Batch *batch)
+{
+  size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  for (;;)
+  {
+    Cell *cell = &ring->cells[pos & ring->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+    if (diff == 0)
+    {
+      if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed))
+      {
+        cell->batch = batch;
+        atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+        return 1;
+      }
+    }
+    else if (diff < 0)
+    {
+      return 0;
+    }
+    else
+    {
+      pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    }
+  }
+}
+
+// Remove a batch from a ring, returning 0 if it is empty
+static int ring_try_pop(Ring *ring, Batch **batch)
+{
+  size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  for (;;)
+  {
+    Cell *cell = &ring->cells[pos & ring->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    ptrdiff_t diff = (ptrdiff_t)(seq - (pos + 1));
+    if (diff == 0)
+    {
+      if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1, memory_order_relaxed,
+                                                memory_order_relaxed))
+      {
+        *batch = cell->batch;
+        atomic_store_explicit(&cell->seq, pos + ring->mask + 1, memory_order_release);
+        return 1;
+      }
+    }
+    else if (diff < 0)
+    {
+      return 0;
+    }
+    else
+    {
+      pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    }
+  }
+}
+
+// Waiting threads yield, since another stage (perhaps on the same core)
+// has to run before they can go on
+static void ring_push(Ring *ring, Batch *batch)
+{
+  while (!ring_try_push(ring, batch))
+  {
+    sched_yield();
+  }
+}
+
+static Batch *ring_pop(Ring *ring)
+{
+  Batch *batch;
+  while (!ring_try_pop(ring, &batch))
+  {
+    sched_yield();
+  }
+  return batch;
+}
+
+// Record that count threads of a stage have finished; after the last
+// one, tell each thread of the next stage to stop
+static void stage_finished(Pipeline *p, int stage, int count)
+{
+  if (atomic_fetch_sub(&p->running[stage], count) == count)
+  {
+    for (int i = 0; i < p->num_threads[stage + 1]; i++)
+    {
+      ring_push(&p->rings[stage + 1], NULL);
+    }
+  }
+}
+
+static void *parse_main(void *arg)
+{
+  Pipeline *p = arg;
+  for (;;)
+  {
+    // take a free batch before claiming lines, so that the batches
+    // waiting for the sink can never hold up the lines it waits for
+    Batch *batch = ring_pop(&p->rings[STAGE_PARSE]);
+    size_t seq = atomic_fetch_add(&p->next_seq, 1);
+    if (seq >= p->num_batches || atomic_load(&p->cancel))
+    {
+      ring_push(&p->rings[STAGE_PARSE], batch);
+      break;
+    }
+    size_t start = seq * p->batch_size;
+    batch->seq = seq;
+    batch->n = (p->n - start < p->batch_size) ? p->n - start : p->batch_size;
+    for (size_t i = 0; i < batch->n; i++)
+    {
+      batch->vals[i] = fixedpoint_create_from_hex(p->lines[start + i]);
+    }
+    ring_push(&p->rings[STAGE_COMPUTE], batch);
+  }
+  atomic_fetch_or(&p->flags, fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+  stage_finished(p, STAGE_PARSE, 1);
+  return NULL;
+}
+
+static void *compute_main(void *arg)
+{
+  Pipeline *p = arg;
+  Batch *batch;
+  while ((batch = ring_pop(&p->rings[STAGE_COMPUTE])) != NULL)
+  {
+    if (p->transform)
+    {
+      p->transform(batch->vals, batch->n, p->transform_ctx);
+    }
+    ring_push(&p->rings[STAGE_FORMAT], batch);
+  }
+  atomic_fetch_or(&p->flags, fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+  stage_finished(p, STAGE_COMPUTE, 1);
+  return NULL;
+}
+
+static void *format_main(void *arg)
+{
+  Pipeline *p = arg;
+  Batch *batch;
+  while ((batch = ring_pop(&p->rings[STAGE_FORMAT])) != NULL)
+  {
+    char *out = batch->text;
+    for (size_t i = 0; i < batch->n; i++)
+    {
+      out += fixedpoint_format_as_hex_buf(batch->vals[i], out, FIXEDPOINT_HEX_BUF_SIZE);
+      *out++ = '\n';
+    }
+    batch->len = out - batch->text;
+    ring_push(&p->rings[STAGE_SINK], batch);
+  }
+  atomic_fetch_or(&p->flags, fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+  stage_finished(p, STAGE_FORMAT, 1);
+  return NULL;
+}
+
+static void *(*const stage_main[STAGE_SINK])(void *) = {parse_main, compute_main, format_main};
+
+// Pass finished batches to the sink in order, until every batch has been
+// received or the format stage stops.  Batches which arrive early wait in
+// pending, at index seq % max_batches; since a batch is only claimed by
+// a parse thread when one is free, the batches in flight have distinct
+// indexes.
+static void run_sink(Pipeline *p, Batch **pending, size_t max_batches, FixedpointPipelineSink sink, void *sink_ctx)
+{
+  size_t next = 0;
+  while (next < p->num_batches)
+  {
+    Batch *batch = ring_pop(&p->rings[STAGE_SINK]);
+    if (!batch)
+    {
+      return;
+    }
+    pending[batch->seq % max_batches] = batch;
+    while (next < p->num_batches && pending[next % max_batches])
+    {
+      batch = pending[next % max_batches];
+      pending[next % max_batches] = NULL;
+      sink(batch->text, batch->len, sink_ctx);
+      ring_push(&p->rings[STAGE_PARSE], batch);
+      next++;
+    }
+  }
+}
+
+int fixedpoint_pipeline_run(const char *const *lines, size_t n, FixedpointPipelineTransform transform,
+                            void *transform_ctx, FixedpointPipelineSink sink, void *sink_ctx,
+                            const FixedpointPipelineConfig *config)
+{
+  FixedpointPipelineConfig defaults = {0, 0, 0, 0, 0};
+  const FixedpointPipelineConfig *c = config ? config : &defaults;
+  Pipeline p;
+  p.lines = lines;
+  p.n = n;
+  p.transform = transform;
+  p.transform_ctx = transform_ctx;
+  p.batch_size = c->batch_size ? c->batch_size : FIXEDPOINT_PIPELINE_BATCH_SIZE;
+  p.num_batches = (n + p.batch_size - 1) / p.batch_size;
+  p.num_threads[STAGE_PARSE] = c->parse_threads > 0 ? c->parse_threads : 1;
+  p.num_threads[STAGE_COMPUTE] = c->compute_threads > 0 ? c->compute_threads : 1;
+  p.num_threads[STAGE_FORMAT] = c->format_threads > 0 ? c->format_threads : 1;
+  p.num_threads[STAGE_SINK] = 1;
+  int total_threads = p.num_threads[STAGE_PARSE] + p.num_threads[STAGE_COMPUTE] + p.num_threads[STAGE_FORMAT];
+  size_t max_batches = c->max_batches > 0 ? (size_t)c->max_batches : 4 * (size_t)total_threads;
+  atomic_init(&p.next_seq, 0);
+  atomic_init(&p.cancel, 0);
+  atomic_init(&p.flags, 0);
+
+  // every ring can hold all the batches and stop signals at once, so
+  // pushes never wait for long
+  size_t ring_capacity = max_batches + total_threads + 1;
+  Batch *batches = calloc(max_batches, sizeof(Batch));
+  Batch **pending = calloc(max_batches, sizeof(Batch *));
+  Fixedpoint *vals = malloc(max_batches * p.batch_size * sizeof(Fixedpoint));
+  char *text = malloc(max_batches * p.batch_size * FIXEDPOINT_HEX_BUF_SIZE);
+  pthread_t *threads = malloc(total_threads * sizeof(pthread_t));
+  int ok = batches && pending && vals && text && threads;
+  int num_rings = 0;
+  while (ok && num_rings < NUM_STAGES && ring_init(&p.rings[num_rings], ring_capacity))
+  {
+    num_rings++;
+  }
+  ok = ok && num_rings == NUM_STAGES;
+
+  int started = 0;
+  if (ok)
+  {
+    for (size_t i = 0; i < max_batches; i++)
+    {
+      batches[i].vals = vals + i * p.batch_size;
+      batches[i].text = text + i * p.batch_size * FIXEDPOINT_HEX_BUF_SIZE;
+      ring_push(&p.rings[STAGE_PARSE], &batches[i]);
+    }
+    for (int s = 0; s < STAGE_SINK; s++)
+    {
+      atomic_init(&p.running[s], p.num_threads[s]);
+    }
+    // start the later stages first, so that the number of threads in the
+    // next stage is known when a stage finishes
+    for (int s = STAGE_FORMAT; s >= STAGE_PARSE; s--)
+    {
+      int count = 0;
+      while (!atomic_load(&p.cancel) && count < p.num_threads[s] &&
+             pthread_create(&threads[started], NULL, stage_main[s], &p) == 0)
+      {
+        count++;
+        started++;
+      }
+      if (count == 0)
+      {
+        // nothing can get through this stage, so the stages before it
+        // (started after it) must not take any lines
+        atomic_store(&p.cancel, 1);
+      }
+      if (count < p.num_threads[s])
+      {
+        int missing = p.num_threads[s] - count;
+        p.num_threads[s] = count;
+        stage_finished(&p, s, missing);
+      }
+    }
+    run_sink(&p, pending, max_batches, sink, sink_ctx);
+    ok = !atomic_load(&p.cancel);
+  }
+
+  for (int i = 0; i < started; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  // the stage threads' status flags are thread-local, so raise them here
+  fixedpoint_status_raise(atomic_load(&p.flags));
+  for (int i = 0; i < num_rings; i++)
+  {
+    free(p.rings[i].cells);
+  }
+  free(threads);
+  free(text);
+  free(vals);
+  free(pending);
+  free(batches);
+  return ok;
+}
@@ -0,0 +1,76 @@
+#ifndef FIXEDPOINT_PIPELINE_H
+#define FIXEDPOINT_PIPELINE_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A parse-compute-format pipeline over lines of hex values.
+//
+// Lines go through three stages, each run by its own group of threads:
+//   parse   - fixedpoint_create_from_hex on each line
+//   compute - a transform function, applied to a batch of values at once
+//   format  - fixedpoint_format_as_hex_buf on each value
+// and then the formatted lines are passed, in input order, to a sink
+// function on the calling thread.  Work moves between the stages in
+// batches of lines, through bounded lock-free ring buffers, so the stages
+// overlap on different cores.
+//
+// A fixed number of batches is allocated up front, and a parse thread
+// only starts on new lines once a batch is free again (when the sink has
+// taken its output), so a slow stage holds the earlier ones back rather
+// than letting work pile up.  Batches may finish the middle stages out of
+// order; the sink receives them in order.
+
+// default number of lines in a batch
+#define FIXEDPOINT_PIPELINE_BATCH_SIZE 1024
+
+// Apply the compute stage to n values, in place.  Called from several
+// threads at once (with different batches) if there are several compute
+// threads.
+typedef void (*FixedpointPipelineTransform)(Fixedpoint *vals, size_t n, void *ctx);
+
+// Receive the output for a batch of lines: each value formatted as hex
+// (or an empty line for an invalid value), followed by a newline, len
+// bytes in all.  The text is only valid during the call.
+typedef void (*FixedpointPipelineSink)(const char *text, size_t len, void *ctx);
+
+typedef struct
+{
+  int parse_threads;   // number of threads in each stage (0 means 1)
+  int compute_threads;
+  int format_threads;
+  size_t batch_size;   // lines per batch (0 means FIXEDPOINT_PIPELINE_BATCH_SIZE)
+  int max_batches;     // batches in flight (0 means 4 per thread)
+} FixedpointPipelineConfig;
+
+// Run lines through the pipeline.  The status flags of all the stages
+// are raised in the calling thread.
+//
+// Parameters:
+//   lines - array of n hex strings
+//   n - the number of lines
+//   transform - the compute stage (NULL to pass values through unchanged)
+//   transform_ctx - passed to transform
+//   sink - receives the output, in order
+//   sink_ctx - passed to sink
+//   config - the threads and batches to use, or NULL for one thread per
+//            stage and the default batches
+//
+// Returns:
+//   1 if successful, 0 if memory couldn't be allocated or a stage
+//   couldn't start any threads (in which case the sink may have received
+//   only some of the output).  A stage which can't start all its threads
+//   runs with those it has.
+int fixedpoint_pipeline_run(const char *const *lines, size_t n, FixedpointPipelineTransform transform,
+                            void *transform_ctx, FixedpointPipelineSink sink, void *sink_ctx,
+                            const FixedpointPipelineConfig *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_PIPELINE_H
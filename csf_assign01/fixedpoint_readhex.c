@@ -0,0 +1,119 @@
+// Reads a file of hex values, one per line, with fixedpoint_ingest_file
+// (see fixedpoint_ingest.h) and reports how fast it went.
+//
+// Usage:
+//   fixedpoint_readhex [-b auto|io_uring|pread] [-t threads] [-d depth] [-c chunk_size] [-g lines] file
+//
+// -t is the number of parser threads, -d the number of reads in flight
+// and -c the size of each read.  With -g, the file is first replaced by
+// lines random values.  Prints the number of values (and invalid ones), a
+// checksum of the values which doesn't depend on how the file was read,
+// MB/s and values/s.  The exit status is 0 if the file was read, 1
+// otherwise.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <time.h>
+#include "fixedpoint.h"
+#include "fixedpoint_ingest.h"
+
+static _Atomic uint64_t checksum;
+
+static void sum_values(const Fixedpoint *vals, size_t n, uint64_t chunk, void *ctx)
+{
+  (void)chunk;
+  (void)ctx;
+  uint64_t sum = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    sum ^= (vals[i].integer * 0x9E3779B97F4A7C15UL) ^ vals[i].fraction ^ (uint64_t)vals[i].tag << 56;
+  }
+  atomic_fetch_xor(&checksum, sum);
+}
+
+static uint64_t next_rand(uint64_t *state)
+{
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+static int generate(const char *path, uint64_t num_lines)
+{
+  FILE *out = fopen(path, "w");
+  if (!out)
+  {
+    return 0;
+  }
+  uint64_t state = (uint64_t)time(NULL) * 0x9E3779B97F4A7C15UL + 1;
+  for (uint64_t i = 0; i < num_lines; i++)
+  {
+    uint64_t r = next_rand(&state);
+    Fixedpoint val = fixedpoint_create2(next_rand(&state) >> (r & 63), next_rand(&state) << (r >> 8 & 63));
+    val.tag = (int)(r >> 63);
+    char *hex = fixedpoint_format_as_hex(val);
+    fprintf(out, "%s\n", hex);
+    free(hex);
+  }
+  return fclose(out) == 0;
+}
+
+int main(int argc, char **argv)
+{
+  FixedpointIngestConfig config = {FIXEDPOINT_INGEST_AUTO, 0, 0, 0};
+  uint64_t num_lines = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:t:d:c:g:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'b':
+      config.backend = strcmp(optarg, "io_uring") == 0 ? FIXEDPOINT_INGEST_IO_URING
+                       : strcmp(optarg, "pread") == 0  ? FIXEDPOINT_INGEST_PREAD
+                                                       : FIXEDPOINT_INGEST_AUTO;
+      break;
+    case 't':
+      config.parse_threads = (int)strtol(optarg, NULL, 0);
+      break;
+    case 'd':
+      config.queue_depth = (int)strtol(optarg, NULL, 0);
+      break;
+    case 'c':
+      config.chunk_size = strtoull(optarg, NULL, 0);
+      break;
+    case 'g':
+      num_lines = strtoull(optarg, NULL, 0);
+      break;
+    default:
+      optind = argc;
+    }
+  }
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "Usage: %s [-b auto|io_uring|pread] [-t threads] [-d depth] [-c chunk_size] [-g lines] file\n",
+            argv[0]);
+    return 2;
+  }
+  if (num_lines > 0 && !generate(argv[optind], num_lines))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  FixedpointIngestStats stats;
+  if (!fixedpoint_ingest_file(argv[optind], sum_values, NULL, &config, &stats))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+  printf("%s: %lu value(s) (%lu invalid), checksum %016lx, %lu bytes in %.3fs with %s: %.1f MB/s, %.0f values/s\n",
+         argv[optind], stats.values, stats.invalid, atomic_load(&checksum), stats.bytes, stats.seconds,
+         stats.backend == FIXEDPOINT_INGEST_IO_URING ? "io_uring" : "pread", stats.bytes / 1e6 / stats.seconds,
+         stats.values / stats.seconds);
+  return 0;
+}
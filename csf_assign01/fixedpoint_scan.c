@@ -0,0 +1,147 @@
+#include <pthread.h>
+#include "fixedpoint.h"
+#include "fixedpoint_internal.h"
+#include "fixedpoint_scan.h"
+
+// fewest elements worth giving to a thread
+#define SCAN_MIN_BLOCK 16384
+
+// One thread's part of a scan
+typedef struct
+{
+  const Fixedpoint *vals;
+  Fixedpoint *out;
+  size_t start, end;
+  int exclusive;
+  WideSum sum;           // first pass: total of the block
+  WideSum offset;        // second pass: total of the blocks before
+  size_t first_overflow; // second pass: end if there was no overflow
+  int flags;             // second pass: status flags of the results
+} ScanBlock;
+
+static void *sum_block(void *arg)
+{
+  ScanBlock *block = arg;
+  WideSum sum = {0, 0};
+  for (size_t i = block->start; i < block->end; i++)
+  {
+    wide_add(&sum, block->vals[i]);
+  }
+  block->sum = sum;
+  return NULL;
+}
+
+static void *scan_block(void *arg)
+{
+  ScanBlock *block = arg;
+  WideSum sum = block->offset;
+  block->first_overflow = block->end;
+  block->flags = 0;
+
+  for (size_t i = block->start; i < block->end; i++)
+  {
+    // read vals[i] before writing out[i], which may be the same element
+    Fixedpoint val = block->vals[i];
+    if (!block->exclusive)
+    {
+      wide_add(&sum, val);
+    }
+    Fixedpoint result = wide_get(sum);
+    if (!fixedpoint_is_valid(result) && block->first_overflow == block->end)
+    {
+      block->first_overflow = i;
+    }
+    block->flags |= 1 << result.tag;
+    block->out[i] = result;
+    if (block->exclusive)
+    {
+      wide_add(&sum, val);
+    }
+  }
+  return NULL;
+}
+
+// Run fn on each block, in its own thread except for the first block,
+// which runs on the calling thread
+static void run_blocks(void *(*fn)(void *), ScanBlock *blocks, int num_blocks)
+{
+  pthread_t threads[num_blocks];
+  int started[num_blocks];
+
+  for (int b = 1; b < num_blocks; b++)
+  {
+    started[b] = pthread_create(&threads[b], NULL, fn, &blocks[b]) == 0;
+    if (!started[b])
+    {
+      fn(&blocks[b]);
+    }
+  }
+  fn(&blocks[0]);
+  for (int b = 1; b < num_blocks; b++)
+  {
+    if (started[b])
+    {
+      pthread_join(threads[b], NULL);
+    }
+  }
+}
+
+static size_t scan(const Fixedpoint *vals, Fixedpoint *out, size_t n, int num_threads, int exclusive)
+{
+  size_t max_blocks = n / SCAN_MIN_BLOCK;
+  int num_blocks = num_threads < 1 ? 1 : num_threads;
+  if ((size_t)num_blocks > max_blocks)
+  {
+    num_blocks = max_blocks < 1 ? 1 : (int)max_blocks;
+  }
+
+  ScanBlock blocks[num_blocks];
+  for (int b = 0; b < num_blocks; b++)
+  {
+    blocks[b].vals = vals;
+    blocks[b].out = out;
+    blocks[b].start = n / num_blocks * b;
+    blocks[b].end = (b == num_blocks - 1) ? n : n / num_blocks * (b + 1);
+    blocks[b].exclusive = exclusive;
+  }
+
+  // the last block's total isn't needed for any offset
+  if (num_blocks > 1)
+  {
+    run_blocks(sum_block, blocks, num_blocks - 1);
+  }
+  WideSum offset = {0, 0};
+  for (int b = 0; b < num_blocks; b++)
+  {
+    blocks[b].offset = offset;
+    if (b < num_blocks - 1)
+    {
+      wide_add_sum(&offset, blocks[b].sum);
+    }
+  }
+  run_blocks(scan_block, blocks, num_blocks);
+
+  // the workers' status flags are thread-local, so raise them here
+  size_t first_overflow = n;
+  int flags = 0;
+  for (int b = 0; b < num_blocks; b++)
+  {
+    if (first_overflow == n)
+    {
+      first_overflow = blocks[b].first_overflow == blocks[b].end ? n : blocks[b].first_overflow;
+    }
+    flags |= blocks[b].flags;
+  }
+  fixedpoint_status_raise(flags);
+  return first_overflow;
+}
+
+size_t fixedpoint_scan_inclusive_n(const Fixedpoint *vals, Fixedpoint *out, size_t n, int num_threads)
+{
+  return scan(vals, out, n, num_threads, 0);
+}
+
+size_t fixedpoint_scan_exclusive_n(const Fixedpoint *vals, Fixedpoint *out, size_t n, int num_threads)
+{
+  return scan(vals, out, n, num_threads, 1);
+}
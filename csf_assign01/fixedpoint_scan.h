@@ -0,0 +1,41 @@
+#ifndef FIXEDPOINT_SCAN_H
+#define FIXEDPOINT_SCAN_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Prefix sums (scans) over arrays of valid Fixedpoint values.  Each
+// prefix sum is computed exactly, so a sum which goes out of range and
+// comes back is valid again, and an overflow in one element doesn't
+// affect later ones.  Since the sums are exact, the results don't depend
+// on how the work is divided between threads.
+//
+// Large arrays are scanned in two passes: threads first sum their own
+// blocks, and then scan them again starting from the total of the blocks
+// before.  Overflow results raise the status flags of the calling thread.
+//
+// Parameters:
+//   vals - array of n values
+//   out - array of n results (may be the same as vals)
+//   n - number of elements
+//   num_threads - the most threads to use (1 or less scans serially)
+//
+// Returns:
+//   the index of the first result which overflowed, or n if there was no
+//   overflow
+
+// out[i] = vals[0] + ... + vals[i]
+size_t fixedpoint_scan_inclusive_n(const Fixedpoint *vals, Fixedpoint *out, size_t n, int num_threads);
+
+// out[i] = vals[0] + ... + vals[i - 1], so out[0] is zero
+size_t fixedpoint_scan_exclusive_n(const Fixedpoint *vals, Fixedpoint *out, size_t n, int num_threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_SCAN_H
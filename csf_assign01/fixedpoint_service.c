@@ -0,0 +1,945 @@
+// for accept4
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "fixedpoint.h"
+#include "fixedpoint_service.h"
+
+// stop reading from a connection while this much output is waiting for it,
+// counting the responses to requests still being worked on
+#define OUT_LIMIT (4 << 20)
+
+// Latency histogram: values below 2^SUB_BITS nanoseconds have a bucket
+// each, and each larger power of two is split into 2^SUB_BITS buckets
+#define SUB_BITS 7
+#define NUM_BUCKETS ((1 << SUB_BITS) + (64 - SUB_BITS) * (1 << SUB_BITS))
+
+typedef struct Conn
+{
+  int fd;
+  unsigned char *in; // bytes read, from in_pos to in_len not yet handled
+  size_t in_pos, in_len, in_cap;
+  unsigned char *out; // bytes to send, from out_pos to out_len
+  size_t out_pos, out_len, out_cap;
+  uint32_t events; // the epoll events asked for
+  int refs;        // requests being worked on
+  size_t queued;   // the size of their responses
+  int closed;
+  struct Conn *prev, *next;
+} Conn;
+
+typedef struct Job
+{
+  struct Job *next;
+  Conn *conn;
+  uint32_t id;
+  uint32_t count;
+  uint64_t start; // when the request was read, in nanoseconds
+  // the request body, replaced by the whole response once done
+  unsigned char *data;
+  size_t len;
+} Job;
+
+typedef struct
+{
+  Job *head, *tail;
+} JobQueue;
+
+struct FixedpointServer
+{
+  char *path;
+  int listen_fd;
+  int epoll_fd;
+  int wake_fd; // eventfd, for finished jobs and stopping
+  int num_workers;
+  _Atomic int stopping;
+
+  pthread_mutex_t lock; // protects the job queues and shutdown
+  pthread_cond_t jobs_ready;
+  JobQueue waiting; // jobs for the workers
+  JobQueue done;    // finished jobs for the event loop
+  int shutdown;
+
+  Conn *conns;  // all open connections (used only by the event loop)
+  Conn *closed; // closed connections, freed at the end of a loop iteration
+
+  pthread_mutex_t stats_lock;
+  uint64_t requests;
+  uint64_t histogram[NUM_BUCKETS];
+};
+
+struct FixedpointClient
+{
+  int fd;
+  uint32_t next_id;
+  unsigned char *buf;
+  size_t cap;
+};
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000UL + (uint64_t)ts.tv_nsec;
+}
+
+// Encoding
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    p[i] = (unsigned char)(v >> (8 * i));
+  }
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+  uint32_t v = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    v |= (uint32_t)p[i] << (8 * i);
+  }
+  return v;
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    p[i] = (unsigned char)(v >> (8 * i));
+  }
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+  uint64_t v = 0;
+  for (int i = 0; i < 8; i++)
+  {
+    v |= (uint64_t)p[i] << (8 * i);
+  }
+  return v;
+}
+
+static void put_value(unsigned char *p, Fixedpoint val)
+{
+  put_u64(p, val.integer);
+  put_u64(p + 8, val.fraction);
+  p[16] = (unsigned char)val.tag;
+}
+
+// a value with a tag which doesn't exist is an error
+static Fixedpoint get_value(const unsigned char *p)
+{
+  Fixedpoint val = fixedpoint_create2(get_u64(p), get_u64(p + 8));
+  val.tag = (p[16] <= 6) ? p[16] : 2;
+  return val;
+}
+
+static void put_header(unsigned char *p, uint32_t len, uint32_t id, uint32_t count)
+{
+  put_u32(p, len);
+  put_u32(p + 4, id);
+  put_u32(p + 8, count);
+}
+
+Fixedpoint fixedpoint_service_apply(const FixedpointServiceOp *op)
+{
+  Fixedpoint error = fixedpoint_create(0UL);
+  error.tag = 2;
+  // the library's operations are for valid operands, and clients may send
+  // any tag or rounding mode
+  int unary = op->op == FIXEDPOINT_SERVICE_NEGATE || op->op == FIXEDPOINT_SERVICE_HALVE ||
+              op->op == FIXEDPOINT_SERVICE_DOUBLE;
+  int rounds = op->op == FIXEDPOINT_SERVICE_MUL || op->op == FIXEDPOINT_SERVICE_DIV;
+  if (!fixedpoint_is_valid(op->left) || (!unary && !fixedpoint_is_valid(op->right)) ||
+      (rounds && (op->mode < FIXEDPOINT_ROUND_EXACT || op->mode > FIXEDPOINT_ROUND_CEIL)))
+  {
+    return error;
+  }
+
+  switch (op->op)
+  {
+  case FIXEDPOINT_SERVICE_ADD:
+    return fixedpoint_add(op->left, op->right);
+  case FIXEDPOINT_SERVICE_SUB:
+    return fixedpoint_sub(op->left, op->right);
+  case FIXEDPOINT_SERVICE_MUL:
+    return fixedpoint_mul_round(op->left, op->right, op->mode);
+  case FIXEDPOINT_SERVICE_DIV:
+    return fixedpoint_div_round(op->left, op->right, op->mode);
+  case FIXEDPOINT_SERVICE_NEGATE:
+    return fixedpoint_negate(op->left);
+  case FIXEDPOINT_SERVICE_HALVE:
+    return fixedpoint_halve(op->left);
+  case FIXEDPOINT_SERVICE_DOUBLE:
+    return fixedpoint_double(op->left);
+  case FIXEDPOINT_SERVICE_COMPARE:
+  {
+    int cmp = fixedpoint_compare(op->left, op->right);
+    return cmp < 0 ? fixedpoint_negate(fixedpoint_create(1UL)) : fixedpoint_create((uint64_t)cmp);
+  }
+  default:
+    return error;
+  }
+}
+
+// Job queues (used with the server lock held)
+
+static void queue_push(JobQueue *queue, Job *job)
+{
+  job->next = NULL;
+  if (queue->tail)
+  {
+    queue->tail->next = job;
+  }
+  else
+  {
+    queue->head = job;
+  }
+  queue->tail = job;
+}
+
+static Job *queue_pop(JobQueue *queue)
+{
+  Job *job = queue->head;
+  if (job)
+  {
+    queue->head = job->next;
+    if (!queue->head)
+    {
+      queue->tail = NULL;
+    }
+  }
+  return job;
+}
+
+static void free_jobs(Job *job)
+{
+  while (job)
+  {
+    Job *next = job->next;
+    free(job->data);
+    free(job);
+    job = next;
+  }
+}
+
+// Workers
+
+// Replace a job's request with its response
+static int do_job(Job *job)
+{
+  size_t len = FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)job->count * FIXEDPOINT_SERVICE_VALUE_SIZE;
+  unsigned char *response = malloc(len);
+  if (!response)
+  {
+    return 0;
+  }
+  put_header(response, (uint32_t)(len - FIXEDPOINT_SERVICE_HEADER_SIZE), job->id, job->count);
+  for (uint32_t i = 0; i < job->count; i++)
+  {
+    const unsigned char *p = job->data + (size_t)i * FIXEDPOINT_SERVICE_OP_SIZE;
+    FixedpointServiceOp op = {p[0], p[1], get_value(p + 2), get_value(p + 2 + FIXEDPOINT_SERVICE_VALUE_SIZE)};
+    put_value(response + FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)i * FIXEDPOINT_SERVICE_VALUE_SIZE,
+              fixedpoint_service_apply(&op));
+  }
+  free(job->data);
+  job->data = response;
+  job->len = len;
+  return 1;
+}
+
+static void wake_loop(FixedpointServer *server)
+{
+  uint64_t one = 1;
+  // adding to the eventfd counter can only fail if it would overflow,
+  // in which case the loop has a wakeup pending anyway
+  ssize_t n = write(server->wake_fd, &one, sizeof(one));
+  (void)n;
+}
+
+static void *worker_main(void *arg)
+{
+  FixedpointServer *server = arg;
+  for (;;)
+  {
+    pthread_mutex_lock(&server->lock);
+    while (!server->waiting.head && !server->shutdown)
+    {
+      pthread_cond_wait(&server->jobs_ready, &server->lock);
+    }
+    Job *job = server->shutdown ? NULL : queue_pop(&server->waiting);
+    pthread_mutex_unlock(&server->lock);
+    if (!job)
+    {
+      return NULL;
+    }
+    if (!do_job(job))
+    {
+      // answered with nothing, which closes the connection
+      free(job->data);
+      job->data = NULL;
+      job->len = 0;
+    }
+    pthread_mutex_lock(&server->lock);
+    queue_push(&server->done, job);
+    pthread_mutex_unlock(&server->lock);
+    wake_loop(server);
+  }
+}
+
+// Connections (used only by the event loop)
+
+static void close_conn(FixedpointServer *server, Conn *conn)
+{
+  if (conn->closed)
+  {
+    return;
+  }
+  epoll_ctl(server->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+  close(conn->fd);
+  conn->closed = 1;
+  if (conn->prev)
+  {
+    conn->prev->next = conn->next;
+  }
+  else
+  {
+    server->conns = conn->next;
+  }
+  if (conn->next)
+  {
+    conn->next->prev = conn->prev;
+  }
+  // freed once no jobs refer to it, after this loop iteration
+  conn->next = server->closed;
+  server->closed = conn;
+}
+
+static void free_conn(Conn *conn)
+{
+  free(conn->in);
+  free(conn->out);
+  free(conn);
+}
+
+// Make room for at least need bytes in a buffer
+static int reserve(unsigned char **buf, size_t *cap, size_t need)
+{
+  if (need <= *cap)
+  {
+    return 1;
+  }
+  size_t new_cap = *cap ? *cap : 4096;
+  while (new_cap < need)
+  {
+    new_cap *= 2;
+  }
+  unsigned char *new_buf = realloc(*buf, new_cap);
+  if (!new_buf)
+  {
+    return 0;
+  }
+  *buf = new_buf;
+  *cap = new_cap;
+  return 1;
+}
+
+// Is a connection's output, sent or still to be computed, over the limit?
+// Reading requests is much cheaper than answering them, so the requests
+// a client has pipelined count as well as the output it hasn't read.
+static int over_limit(const Conn *conn)
+{
+  return conn->out_len - conn->out_pos + conn->queued >= OUT_LIMIT;
+}
+
+static void update_events(FixedpointServer *server, Conn *conn)
+{
+  if (conn->closed)
+  {
+    return;
+  }
+  size_t pending = conn->out_len - conn->out_pos;
+  uint32_t events = (over_limit(conn) ? 0 : EPOLLIN) | (pending > 0 ? EPOLLOUT : 0);
+  if (events != conn->events)
+  {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = conn;
+    epoll_ctl(server->epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+    conn->events = events;
+  }
+}
+
+// Send as much waiting output as the socket takes
+static void flush_conn(FixedpointServer *server, Conn *conn)
+{
+  while (conn->out_pos < conn->out_len)
+  {
+    ssize_t n = send(conn->fd, conn->out + conn->out_pos, conn->out_len - conn->out_pos, MSG_NOSIGNAL);
+    if (n < 0)
+    {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+      {
+        close_conn(server, conn);
+        return;
+      }
+      if (errno != EINTR)
+      {
+        break;
+      }
+      continue;
+    }
+    conn->out_pos += (size_t)n;
+  }
+  if (conn->out_pos == conn->out_len)
+  {
+    conn->out_pos = conn->out_len = 0;
+  }
+}
+
+// Hand each complete request in a connection's input to the workers.
+// Returns 0 if the input is malformed.
+static int dispatch_requests(FixedpointServer *server, Conn *conn)
+{
+  uint64_t start = now_ns();
+  while (conn->in_len - conn->in_pos >= FIXEDPOINT_SERVICE_HEADER_SIZE)
+  {
+    const unsigned char *header = conn->in + conn->in_pos;
+    uint32_t len = get_u32(header), count = get_u32(header + 8);
+    if (count > FIXEDPOINT_SERVICE_MAX_OPS || len != count * FIXEDPOINT_SERVICE_OP_SIZE)
+    {
+      return 0;
+    }
+    if (conn->in_len - conn->in_pos < FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)len)
+    {
+      break;
+    }
+    Job *job = malloc(sizeof(Job));
+    unsigned char *data = malloc(len ? len : 1);
+    if (!job || !data)
+    {
+      free(job);
+      free(data);
+      return 0;
+    }
+    memcpy(data, header + FIXEDPOINT_SERVICE_HEADER_SIZE, len);
+    job->conn = conn;
+    job->id = get_u32(header + 4);
+    job->count = count;
+    job->start = start;
+    job->data = data;
+    job->len = len;
+    conn->refs++;
+    conn->queued += FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)count * FIXEDPOINT_SERVICE_VALUE_SIZE;
+    conn->in_pos += FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)len;
+
+    pthread_mutex_lock(&server->lock);
+    queue_push(&server->waiting, job);
+    pthread_cond_signal(&server->jobs_ready);
+    pthread_mutex_unlock(&server->lock);
+  }
+  // keep the start of an incomplete request at the start of the buffer
+  memmove(conn->in, conn->in + conn->in_pos, conn->in_len - conn->in_pos);
+  conn->in_len -= conn->in_pos;
+  conn->in_pos = 0;
+  return 1;
+}
+
+static void read_conn(FixedpointServer *server, Conn *conn)
+{
+  // once over the limit, the rest waits until responses are sent
+  while (!over_limit(conn))
+  {
+    // read at least the rest of the current request, if it is known
+    size_t need = conn->in_len + 4096;
+    if (conn->in_len >= FIXEDPOINT_SERVICE_HEADER_SIZE)
+    {
+      size_t frame = FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)get_u32(conn->in);
+      need = frame > need ? frame : need;
+    }
+    if (!reserve(&conn->in, &conn->in_cap, need))
+    {
+      close_conn(server, conn);
+      return;
+    }
+    ssize_t n = recv(conn->fd, conn->in + conn->in_len, conn->in_cap - conn->in_len, 0);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      return;
+    }
+    if (n <= 0)
+    {
+      close_conn(server, conn);
+      return;
+    }
+    conn->in_len += (size_t)n;
+    if (!dispatch_requests(server, conn))
+    {
+      close_conn(server, conn);
+      return;
+    }
+  }
+}
+
+static void accept_conns(FixedpointServer *server)
+{
+  for (;;)
+  {
+    int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+    {
+      // EAGAIN when there are no more, or a failed connection
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      return;
+    }
+    Conn *conn = calloc(1, sizeof(Conn));
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = conn;
+    if (!conn || epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+      free(conn);
+      close(fd);
+      continue;
+    }
+    conn->fd = fd;
+    conn->events = EPOLLIN;
+    conn->next = server->conns;
+    if (server->conns)
+    {
+      server->conns->prev = conn;
+    }
+    server->conns = conn;
+  }
+}
+
+static void record_latency(FixedpointServer *server, uint64_t ns)
+{
+  size_t bucket;
+  if (ns < (1UL << SUB_BITS))
+  {
+    bucket = ns;
+  }
+  else
+  {
+    int e = 63 - __builtin_clzl(ns);
+    bucket = (1 << SUB_BITS) + (size_t)(e - SUB_BITS) * (1 << SUB_BITS) + ((ns >> (e - SUB_BITS)) - (1UL << SUB_BITS));
+  }
+  pthread_mutex_lock(&server->stats_lock);
+  server->requests++;
+  server->histogram[bucket]++;
+  pthread_mutex_unlock(&server->stats_lock);
+}
+
+// Queue the responses of finished jobs for sending
+static void finish_jobs(FixedpointServer *server)
+{
+  // reset the eventfd (which fails harmlessly if an earlier call already
+  // did); the jobs themselves are in the done queue
+  uint64_t count;
+  ssize_t n = read(server->wake_fd, &count, sizeof(count));
+  (void)n;
+  pthread_mutex_lock(&server->lock);
+  Job *job = server->done.head;
+  server->done.head = server->done.tail = NULL;
+  pthread_mutex_unlock(&server->lock);
+
+  while (job)
+  {
+    Job *next = job->next;
+    Conn *conn = job->conn;
+    conn->refs--;
+    conn->queued -= FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)job->count * FIXEDPOINT_SERVICE_VALUE_SIZE;
+    if (!conn->closed)
+    {
+      if (!job->data || !reserve(&conn->out, &conn->out_cap, conn->out_len + job->len))
+      {
+        close_conn(server, conn);
+      }
+      else
+      {
+        memcpy(conn->out + conn->out_len, job->data, job->len);
+        conn->out_len += job->len;
+        record_latency(server, now_ns() - job->start);
+        flush_conn(server, conn);
+        update_events(server, conn);
+      }
+    }
+    free(job->data);
+    free(job);
+    job = next;
+  }
+}
+
+// Free the closed connections which no jobs refer to
+static void free_closed(FixedpointServer *server)
+{
+  Conn **link = &server->closed;
+  while (*link)
+  {
+    Conn *conn = *link;
+    if (conn->refs == 0)
+    {
+      *link = conn->next;
+      free_conn(conn);
+    }
+    else
+    {
+      link = &conn->next;
+    }
+  }
+}
+
+// The server
+
+FixedpointServer *fixedpoint_server_create(const char *path, int num_workers)
+{
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return NULL;
+  }
+  FixedpointServer *server = calloc(1, sizeof(FixedpointServer));
+  if (!server)
+  {
+    return NULL;
+  }
+  server->listen_fd = server->epoll_fd = server->wake_fd = -1;
+  server->num_workers = num_workers > 0 ? num_workers : 1;
+  server->path = strdup(path);
+  pthread_mutex_init(&server->lock, NULL);
+  pthread_cond_init(&server->jobs_ready, NULL);
+  pthread_mutex_init(&server->stats_lock, NULL);
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  server->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  server->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (!server->path || server->listen_fd < 0 || server->epoll_fd < 0 || server->wake_fd < 0 ||
+      bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(server->listen_fd, 128) < 0)
+  {
+    int saved = errno;
+    fixedpoint_server_destroy(server);
+    errno = saved;
+    return NULL;
+  }
+
+  // the listening socket and the eventfd are told apart from
+  // connections by their data pointers
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = &server->listen_fd;
+  epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->listen_fd, &ev);
+  ev.data.ptr = &server->wake_fd;
+  epoll_ctl(server->epoll_fd, EPOLL_CTL_ADD, server->wake_fd, &ev);
+  return server;
+}
+
+int fixedpoint_server_run(FixedpointServer *server)
+{
+  pthread_t *workers = malloc(server->num_workers * sizeof(pthread_t));
+  int num_started = 0;
+  int ok = workers != NULL;
+  server->shutdown = 0;
+  while (ok && num_started < server->num_workers)
+  {
+    ok = pthread_create(&workers[num_started], NULL, worker_main, server) == 0;
+    num_started += ok;
+  }
+
+  struct epoll_event events[64];
+  while (ok && !atomic_load(&server->stopping))
+  {
+    int n = epoll_wait(server->epoll_fd, events, 64, -1);
+    if (n < 0)
+    {
+      ok = errno == EINTR;
+      continue;
+    }
+    for (int i = 0; i < n; i++)
+    {
+      void *ptr = events[i].data.ptr;
+      if (ptr == &server->listen_fd)
+      {
+        accept_conns(server);
+      }
+      else if (ptr == &server->wake_fd)
+      {
+        finish_jobs(server);
+      }
+      else
+      {
+        Conn *conn = ptr;
+        if (conn->closed)
+        {
+          // closed earlier in this batch (by finish_jobs, say), so its fd
+          // may already belong to a newly accepted connection
+          continue;
+        }
+        if (events[i].events & EPOLLOUT)
+        {
+          flush_conn(server, conn);
+        }
+        if ((events[i].events & (EPOLLHUP | EPOLLERR)) && over_limit(conn))
+        {
+          // the peer has gone, and read_conn wouldn't read to find out
+          close_conn(server, conn);
+        }
+        else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+        {
+          read_conn(server, conn);
+        }
+        update_events(server, conn);
+      }
+    }
+    free_closed(server);
+  }
+
+  int saved = errno;
+  pthread_mutex_lock(&server->lock);
+  server->shutdown = 1;
+  pthread_cond_broadcast(&server->jobs_ready);
+  pthread_mutex_unlock(&server->lock);
+  for (int i = 0; i < num_started; i++)
+  {
+    pthread_join(workers[i], NULL);
+  }
+  free(workers);
+
+  // drop the requests not yet answered, and the connections
+  free_jobs(server->waiting.head);
+  free_jobs(server->done.head);
+  server->waiting.head = server->waiting.tail = NULL;
+  server->done.head = server->done.tail = NULL;
+  while (server->conns)
+  {
+    close_conn(server, server->conns);
+  }
+  for (Conn *conn = server->closed; conn; conn = conn->next)
+  {
+    conn->refs = 0;
+  }
+  free_closed(server);
+  atomic_store(&server->stopping, 0);
+  errno = saved;
+  return ok;
+}
+
+void fixedpoint_server_stop(FixedpointServer *server)
+{
+  atomic_store(&server->stopping, 1);
+  wake_loop(server);
+}
+
+uint64_t fixedpoint_server_requests(FixedpointServer *server)
+{
+  pthread_mutex_lock(&server->stats_lock);
+  uint64_t requests = server->requests;
+  pthread_mutex_unlock(&server->stats_lock);
+  return requests;
+}
+
+uint64_t fixedpoint_server_latency(FixedpointServer *server, double q)
+{
+  uint64_t result = 0;
+  pthread_mutex_lock(&server->stats_lock);
+  if (server->requests > 0)
+  {
+    // the rank of the request, counting from 1
+    uint64_t rank = (uint64_t)(q * server->requests);
+    rank = rank < 1 ? 1 : (rank > server->requests ? server->requests : rank);
+    uint64_t seen = 0;
+    size_t bucket = 0;
+    while (seen + server->histogram[bucket] < rank)
+    {
+      seen += server->histogram[bucket++];
+    }
+    if (bucket < (1 << SUB_BITS))
+    {
+      result = bucket;
+    }
+    else
+    {
+      // the middle of the bucket
+      size_t e = (bucket >> SUB_BITS) - 1 + SUB_BITS;
+      uint64_t low = ((uint64_t)(bucket & ((1 << SUB_BITS) - 1)) + (1UL << SUB_BITS)) << (e - SUB_BITS);
+      result = low + (1UL << (e - SUB_BITS)) / 2;
+    }
+  }
+  pthread_mutex_unlock(&server->stats_lock);
+  return result;
+}
+
+void fixedpoint_server_destroy(FixedpointServer *server)
+{
+  if (!server)
+  {
+    return;
+  }
+  if (server->listen_fd >= 0)
+  {
+    close(server->listen_fd);
+    unlink(server->path);
+  }
+  if (server->epoll_fd >= 0)
+  {
+    close(server->epoll_fd);
+  }
+  if (server->wake_fd >= 0)
+  {
+    close(server->wake_fd);
+  }
+  pthread_mutex_destroy(&server->lock);
+  pthread_cond_destroy(&server->jobs_ready);
+  pthread_mutex_destroy(&server->stats_lock);
+  free(server->path);
+  free(server);
+}
+
+// The client
+
+FixedpointClient *fixedpoint_client_connect(const char *path)
+{
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path))
+  {
+    errno = ENAMETOOLONG;
+    return NULL;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  FixedpointClient *client = calloc(1, sizeof(FixedpointClient));
+  if (!client)
+  {
+    return NULL;
+  }
+  client->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (client->fd < 0 || connect(client->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+  {
+    int saved = errno;
+    if (client->fd >= 0)
+    {
+      close(client->fd);
+    }
+    free(client);
+    errno = saved;
+    return NULL;
+  }
+  return client;
+}
+
+static int send_all(int fd, const unsigned char *buf, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return 0;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+  return 1;
+}
+
+static int recv_all(int fd, unsigned char *buf, size_t len)
+{
+  while (len > 0)
+  {
+    ssize_t n = recv(fd, buf, len, 0);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n <= 0)
+    {
+      return 0;
+    }
+    buf += n;
+    len -= (size_t)n;
+  }
+  return 1;
+}
+
+int fixedpoint_client_call(FixedpointClient *client, const FixedpointServiceOp *ops, Fixedpoint *results,
+                           uint32_t count)
+{
+  if (count > FIXEDPOINT_SERVICE_MAX_OPS)
+  {
+    return 0;
+  }
+  size_t request_len = FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)count * FIXEDPOINT_SERVICE_OP_SIZE;
+  if (!reserve(&client->buf, &client->cap, request_len))
+  {
+    return 0;
+  }
+  uint32_t id = client->next_id++;
+  put_header(client->buf, count * FIXEDPOINT_SERVICE_OP_SIZE, id, count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    unsigned char *p = client->buf + FIXEDPOINT_SERVICE_HEADER_SIZE + (size_t)i * FIXEDPOINT_SERVICE_OP_SIZE;
+    p[0] = (unsigned char)ops[i].op;
+    p[1] = (unsigned char)ops[i].mode;
+    put_value(p + 2, ops[i].left);
+    put_value(p + 2 + FIXEDPOINT_SERVICE_VALUE_SIZE, ops[i].right);
+  }
+  if (!send_all(client->fd, client->buf, request_len))
+  {
+    return 0;
+  }
+
+  unsigned char header[FIXEDPOINT_SERVICE_HEADER_SIZE];
+  if (!recv_all(client->fd, header, sizeof(header)) || get_u32(header + 4) != id ||
+      get_u32(header + 8) != count || get_u32(header) != count * FIXEDPOINT_SERVICE_VALUE_SIZE)
+  {
+    return 0;
+  }
+  size_t response_len = (size_t)count * FIXEDPOINT_SERVICE_VALUE_SIZE;
+  if (!recv_all(client->fd, client->buf, response_len))
+  {
+    return 0;
+  }
+  for (uint32_t i = 0; i < count; i++)
+  {
+    results[i] = get_value(client->buf + (size_t)i * FIXEDPOINT_SERVICE_VALUE_SIZE);
+  }
+  return 1;
+}
+
+void fixedpoint_client_close(FixedpointClient *client)
+{
+  if (client)
+  {
+    close(client->fd);
+    free(client->buf);
+    free(client);
+  }
+}
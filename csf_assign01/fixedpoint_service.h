@@ -0,0 +1,173 @@
+#ifndef FIXEDPOINT_SERVICE_H
+#define FIXEDPOINT_SERVICE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A local arithmetic service: a server which does Fixedpoint operations
+// for clients connected to a Unix domain socket, and a client for it.
+//
+// Each request carries a batch of operations, and its response the
+// results, in the same order.  The protocol is binary, with all integers
+// little-endian:
+//
+//   request:  header, then count operations
+//   response: header, then count values
+//   header:   uint32 body length (bytes after the header), uint32 request
+//             id (chosen by the client, echoed in the response), uint32
+//             count
+//   operation: uint8 opcode (FIXEDPOINT_SERVICE_ADD, ...), uint8 rounding
+//             mode (for MUL and DIV), value left, value right (ignored by
+//             the operations with one operand)
+//   value:    uint64 whole part, uint64 fraction, uint8 tag
+//
+// Results are exactly what the library's functions return; COMPARE
+// returns -1, 0 or 1 as a value.  An unknown opcode, an operand which
+// isn't valid (an error, overflow or underflow value, or an unknown tag),
+// or a rounding mode which isn't one of the FIXEDPOINT_ROUND_ modes
+// returns an error value.  A client may send several requests without waiting for the
+// responses, which may then come back in any order.  The server closes a
+// connection which sends a malformed header.
+//
+// The server runs an epoll event loop on one thread, which does all the
+// socket I/O, and hands complete requests to a pool of worker threads.
+
+#define FIXEDPOINT_SERVICE_HEADER_SIZE 12
+#define FIXEDPOINT_SERVICE_VALUE_SIZE 17
+#define FIXEDPOINT_SERVICE_OP_SIZE (2 + 2 * FIXEDPOINT_SERVICE_VALUE_SIZE)
+
+// the most operations in a request
+#define FIXEDPOINT_SERVICE_MAX_OPS 65536
+
+// opcodes
+enum
+{
+  FIXEDPOINT_SERVICE_ADD,
+  FIXEDPOINT_SERVICE_SUB,
+  FIXEDPOINT_SERVICE_MUL, // fixedpoint_mul_round
+  FIXEDPOINT_SERVICE_DIV, // fixedpoint_div_round
+  FIXEDPOINT_SERVICE_NEGATE,
+  FIXEDPOINT_SERVICE_HALVE,
+  FIXEDPOINT_SERVICE_DOUBLE,
+  FIXEDPOINT_SERVICE_COMPARE,
+  FIXEDPOINT_SERVICE_NUM_OPS
+};
+
+typedef struct
+{
+  int op;   // opcode
+  int mode; // FIXEDPOINT_ROUND_ mode, for MUL and DIV
+  Fixedpoint left;
+  Fixedpoint right;
+} FixedpointServiceOp;
+
+typedef struct FixedpointServer FixedpointServer;
+typedef struct FixedpointClient FixedpointClient;
+
+// Do an operation, as the server does.
+//
+// Parameters:
+//   op - the operation
+//
+// Returns:
+//   the result, or an error value if the opcode is unknown, an operand
+//   used isn't valid, or (for MUL and DIV) the mode isn't a
+//   FIXEDPOINT_ROUND_ mode
+Fixedpoint fixedpoint_service_apply(const FixedpointServiceOp *op);
+
+// Create a server listening on a Unix domain socket.  Requests are
+// handled once fixedpoint_server_run is called.
+//
+// Parameters:
+//   path - path of the socket (an existing socket there is replaced)
+//   num_workers - the number of worker threads (at least 1)
+//
+// Returns:
+//   the server, to be freed with fixedpoint_server_destroy, or NULL if
+//   the socket can't be created (with errno set)
+FixedpointServer *fixedpoint_server_create(const char *path, int num_workers);
+
+// Handle requests until fixedpoint_server_stop is called.
+//
+// Parameters:
+//   server - the server
+//
+// Returns:
+//   1 if the server was stopped, 0 if it failed (with errno set)
+int fixedpoint_server_run(FixedpointServer *server);
+
+// Make fixedpoint_server_run return.  This may be called from any
+// thread, or from a signal handler.
+//
+// Parameters:
+//   server - the server
+void fixedpoint_server_stop(FixedpointServer *server);
+
+// Get the number of requests the server has answered.
+//
+// Parameters:
+//   server - the server
+//
+// Returns:
+//   the number of requests
+uint64_t fixedpoint_server_requests(FixedpointServer *server);
+
+// Get a percentile of the time the server took to answer requests (from
+// reading the whole request to having the whole response ready to send),
+// accurate to about 1%.
+//
+// Parameters:
+//   server - the server
+//   q - the fraction of requests, e.g. 0.99 for the 99th percentile
+//
+// Returns:
+//   the latency in nanoseconds, or 0 if no requests have been answered
+uint64_t fixedpoint_server_latency(FixedpointServer *server, double q);
+
+// Close the socket (removing it from the file system) and free a server.
+// The server must not be running.
+//
+// Parameters:
+//   server - the server (may be NULL)
+void fixedpoint_server_destroy(FixedpointServer *server);
+
+// Connect to a server.
+//
+// Parameters:
+//   path - path of the server's socket
+//
+// Returns:
+//   the client, to be freed with fixedpoint_client_close, or NULL if the
+//   connection fails (with errno set)
+FixedpointClient *fixedpoint_client_connect(const char *path);
+
+// Send one request and wait for its response.
+//
+// Parameters:
+//   client - the client
+//   ops - array of count operations
+//   results - array of count results
+//   count - the number of operations (at most FIXEDPOINT_SERVICE_MAX_OPS)
+//
+// Returns:
+//   1 if successful, 0 if the connection failed or the response was
+//   malformed
+int fixedpoint_client_call(FixedpointClient *client, const FixedpointServiceOp *ops, Fixedpoint *results,
+                           uint32_t count);
+
+// Close a connection to a server.
+//
+// Parameters:
+//   client - the client (may be NULL)
+void fixedpoint_client_close(FixedpointClient *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_SERVICE_H
@@ -0,0 +1,81 @@
+// Fixedpoint arithmetic service daemon (see fixedpoint_service.h).
+//
+// Usage:
+//   fixedpoint_serviced [-w workers] socket_path
+//
+// Serves requests on the Unix domain socket at socket_path until it gets
+// SIGINT or SIGTERM, and then prints the number of requests and the
+// percentiles of the time taken to answer them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include "fixedpoint_service.h"
+
+static FixedpointServer *server;
+
+static void handle_signal(int sig)
+{
+  (void)sig;
+  fixedpoint_server_stop(server);
+}
+
+int main(int argc, char **argv)
+{
+  long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+
+  while ((opt = getopt(argc, argv, "w:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'w':
+      num_workers = strtol(optarg, NULL, 0);
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-w workers] socket_path\n", argv[0]);
+      return 2;
+    }
+  }
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "Usage: %s [-w workers] socket_path\n", argv[0]);
+    return 2;
+  }
+  if (num_workers < 1)
+  {
+    num_workers = 1;
+  }
+
+  server = fixedpoint_server_create(argv[optind], (int)num_workers);
+  if (!server)
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = handle_signal;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  printf("serving on %s with %ld worker(s)\n", argv[optind], num_workers);
+  fflush(stdout);
+  int ok = fixedpoint_server_run(server);
+  if (!ok)
+  {
+    perror("fixedpoint_server_run");
+  }
+
+  static const double percentiles[] = {0.5, 0.9, 0.99, 0.999};
+  printf("%lu request(s)", fixedpoint_server_requests(server));
+  for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+  {
+    printf(", p%g %.1fus", percentiles[i] * 100, fixedpoint_server_latency(server, percentiles[i]) / 1e3);
+  }
+  printf("\n");
+  fixedpoint_server_destroy(server);
+  return !ok;
+}
@@ -0,0 +1,188 @@
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "fixedpoint_internal.h"
+#include "fixedpoint_stats.h"
+
+static const char *const op_names[FIXEDPOINT_NUM_OPS] = {
+    "create_from_hex", "create_from_dec", "add",        "sub",     "negate",        "halve",         "double",
+    "mul",             "mul_round",       "div_round",  "compare", "format_as_hex", "format_as_dec",
+};
+
+// columns of a thread's counters
+enum
+{
+  COUNT_CALLS,
+  COUNT_ERRORS,
+  COUNT_OVERFLOWS,
+  COUNT_UNDERFLOWS,
+  NUM_COUNTS
+};
+
+// One thread's counters.  Only the owning thread writes them; the atomic
+// type just makes the concurrent reads by snapshots well defined (relaxed
+// loads and stores are plain moves).
+typedef struct ThreadStats
+{
+  _Atomic uint64_t counts[FIXEDPOINT_NUM_OPS][NUM_COUNTS];
+  struct ThreadStats *prev, *next;
+} ThreadStats;
+
+// The registry of threads' counters, and the totals of exited threads.
+// The lock is only taken when a thread first counts, when it exits, and
+// by snapshots.
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadStats *registry;
+static uint64_t exited[FIXEDPOINT_NUM_OPS][NUM_COUNTS];
+
+#ifdef FIXEDPOINT_STATS
+static pthread_key_t exit_key;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+static _Thread_local ThreadStats *local_stats;
+
+// Fold an exiting thread's counters into the totals
+static void unregister(void *arg)
+{
+  ThreadStats *stats = arg;
+  pthread_mutex_lock(&registry_lock);
+  for (int op = 0; op < FIXEDPOINT_NUM_OPS; op++)
+  {
+    for (int c = 0; c < NUM_COUNTS; c++)
+    {
+      exited[op][c] += atomic_load_explicit(&stats->counts[op][c], memory_order_relaxed);
+    }
+  }
+  if (stats->prev)
+  {
+    stats->prev->next = stats->next;
+  }
+  else
+  {
+    registry = stats->next;
+  }
+  if (stats->next)
+  {
+    stats->next->prev = stats->prev;
+  }
+  pthread_mutex_unlock(&registry_lock);
+  free(stats);
+}
+
+static void create_exit_key(void)
+{
+  pthread_key_create(&exit_key, unregister);
+}
+
+static ThreadStats *register_thread(void)
+{
+  ThreadStats *stats = calloc(1, sizeof(ThreadStats));
+  if (!stats)
+  {
+    return NULL;
+  }
+  pthread_once(&exit_key_once, create_exit_key);
+  pthread_mutex_lock(&registry_lock);
+  stats->next = registry;
+  if (registry)
+  {
+    registry->prev = stats;
+  }
+  registry = stats;
+  pthread_mutex_unlock(&registry_lock);
+  pthread_setspecific(exit_key, stats);
+  return stats;
+}
+
+static void increment(_Atomic uint64_t *count)
+{
+  atomic_store_explicit(count, atomic_load_explicit(count, memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+void fixedpoint_stats_record(int op, int tag)
+{
+  ThreadStats *stats = local_stats;
+  if (!stats)
+  {
+    stats = local_stats = register_thread();
+    if (!stats)
+    {
+      return;
+    }
+  }
+  increment(&stats->counts[op][COUNT_CALLS]);
+  if (tag >= 2)
+  {
+    // 2 is an error, 3 and 4 overflows, 5 and 6 underflows
+    increment(&stats->counts[op][(tag + 1) / 2]);
+  }
+}
+#endif
+
+int fixedpoint_stats_enabled(void)
+{
+#ifdef FIXEDPOINT_STATS
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+void fixedpoint_stats_snapshot(FixedpointStats *stats)
+{
+  uint64_t totals[FIXEDPOINT_NUM_OPS][NUM_COUNTS];
+
+  pthread_mutex_lock(&registry_lock);
+  memcpy(totals, exited, sizeof(totals));
+  for (ThreadStats *t = registry; t; t = t->next)
+  {
+    for (int op = 0; op < FIXEDPOINT_NUM_OPS; op++)
+    {
+      for (int c = 0; c < NUM_COUNTS; c++)
+      {
+        totals[op][c] += atomic_load_explicit(&t->counts[op][c], memory_order_relaxed);
+      }
+    }
+  }
+  pthread_mutex_unlock(&registry_lock);
+
+  for (int op = 0; op < FIXEDPOINT_NUM_OPS; op++)
+  {
+    stats->calls[op] = totals[op][COUNT_CALLS];
+    stats->errors[op] = totals[op][COUNT_ERRORS];
+    stats->overflows[op] = totals[op][COUNT_OVERFLOWS];
+    stats->underflows[op] = totals[op][COUNT_UNDERFLOWS];
+  }
+}
+
+const char *fixedpoint_stats_op_name(int op)
+{
+  return (op >= 0 && op < FIXEDPOINT_NUM_OPS) ? op_names[op] : "unknown";
+}
+
+void fixedpoint_stats_write_text(const FixedpointStats *stats, FILE *out)
+{
+  fprintf(out, "%-16s %14s %14s %14s %14s\n", "operation", "calls", "errors", "overflows", "underflows");
+  for (int op = 0; op < FIXEDPOINT_NUM_OPS; op++)
+  {
+    if (stats->calls[op] != 0)
+    {
+      fprintf(out, "%-16s %14" PRIu64 " %14" PRIu64 " %14" PRIu64 " %14" PRIu64 "\n", op_names[op],
+              stats->calls[op], stats->errors[op], stats->overflows[op], stats->underflows[op]);
+    }
+  }
+}
+
+void fixedpoint_stats_write_json(const FixedpointStats *stats, FILE *out)
+{
+  fputc('{', out);
+  for (int op = 0; op < FIXEDPOINT_NUM_OPS; op++)
+  {
+    fprintf(out, "%s\"%s\": {\"calls\": %" PRIu64 ", \"errors\": %" PRIu64 ", \"overflows\": %" PRIu64
+                 ", \"underflows\": %" PRIu64 "}",
+            op == 0 ? "" : ", ", op_names[op], stats->calls[op], stats->errors[op], stats->overflows[op],
+            stats->underflows[op]);
+  }
+  fputs("}\n", out);
+}
@@ -0,0 +1,90 @@
+#ifndef FIXEDPOINT_STATS_H
+#define FIXEDPOINT_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Operation and exception counters.
+//
+// When the library is compiled with FIXEDPOINT_STATS defined (e.g. with
+// "make STATS=1"), each of the operations below counts its calls, and how
+// many of them returned an error, overflow or underflow value.  Otherwise
+// the counting compiles to nothing, and the counters are always zero.
+//
+// Each thread counts in counters of its own, which only it writes, so
+// counting needs no locks or atomic read-modify-write instructions.  A
+// snapshot adds up every thread's counters (including those of threads
+// which have exited); it may be taken at any time, from any thread.
+
+// operations with counters
+enum
+{
+  FIXEDPOINT_OP_CREATE_FROM_HEX,
+  FIXEDPOINT_OP_CREATE_FROM_DEC,
+  FIXEDPOINT_OP_ADD,
+  FIXEDPOINT_OP_SUB,
+  FIXEDPOINT_OP_NEGATE,
+  FIXEDPOINT_OP_HALVE,
+  FIXEDPOINT_OP_DOUBLE,
+  FIXEDPOINT_OP_MUL,
+  FIXEDPOINT_OP_MUL_ROUND,
+  FIXEDPOINT_OP_DIV_ROUND,
+  FIXEDPOINT_OP_COMPARE,
+  FIXEDPOINT_OP_FORMAT_AS_HEX,
+  FIXEDPOINT_OP_FORMAT_AS_DEC,
+  FIXEDPOINT_NUM_OPS
+};
+
+typedef struct
+{
+  uint64_t calls[FIXEDPOINT_NUM_OPS];
+  uint64_t errors[FIXEDPOINT_NUM_OPS];     // results with tag 2
+  uint64_t overflows[FIXEDPOINT_NUM_OPS];  // results with tags 3 and 4
+  uint64_t underflows[FIXEDPOINT_NUM_OPS]; // results with tags 5 and 6
+} FixedpointStats;
+
+// Check whether the library was compiled with counters.
+//
+// Returns:
+//   1 if operations are counted, 0 if not
+int fixedpoint_stats_enabled(void);
+
+// Get the counts so far, over all threads.
+//
+// Parameters:
+//   stats - set to the counts
+void fixedpoint_stats_snapshot(FixedpointStats *stats);
+
+// Get the name of an operation, e.g. "add" for FIXEDPOINT_OP_ADD.
+//
+// Parameters:
+//   op - one of the FIXEDPOINT_OP_ values
+//
+// Returns:
+//   the name
+const char *fixedpoint_stats_op_name(int op);
+
+// Write counts as a table, one line for each operation that was called.
+//
+// Parameters:
+//   stats - the counts
+//   out - the stream to write to
+void fixedpoint_stats_write_text(const FixedpointStats *stats, FILE *out);
+
+// Write counts as a JSON object, with an object for each operation, e.g.
+// {"add": {"calls": 10, "errors": 0, "overflows": 1, "underflows": 0}, ...}
+//
+// Parameters:
+//   stats - the counts
+//   out - the stream to write to
+void fixedpoint_stats_write_json(const FixedpointStats *stats, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_STATS_H
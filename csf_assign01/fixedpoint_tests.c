@@ -1,6 +1,30 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
 #include "fixedpoint.h"
+#include "fixedpoint_batch.h"
+#include "fixedpoint_expr.h"
+#include "fixedpoint_math.h"
+#include "fixedpoint_scan.h"
+#include "fixedpoint_window.h"
+#include "fixedpoint_codec.h"
+#include "fixedpoint_dict.h"
+#include "fixedpoint_arena.h"
+#include "fixedpoint_stats.h"
+#include "fixedpoint_trace.h"
+#include "fixedpoint_atomic.h"
+#include "fixedpoint_pipeline.h"
+#include "fixedpoint_service.h"
+#include "fixedpoint_ingest.h"
+#include "fixedpoint_matrix.h"
+#include "fixedpoint_wide.h"
+#include "fixedpoint_unchecked.h"
 #include "tctest.h"
 
 // Test fixture object, has some useful values for testing
@@ -44,6 +68,45 @@ void test_sub2(TestObjs *objs);
 void test_add2(TestObjs *objs);
 void test_create_from_hex2(TestObjs *objs);
 void test_format_as_hex2();
+void test_add_carry_overflow(TestObjs *objs);
+void test_status_flags(TestObjs *objs);
+void test_batch_ops(TestObjs *objs);
+void test_mul(TestObjs *objs);
+void test_saturating(TestObjs *objs);
+void test_rounding(TestObjs *objs);
+void test_div(TestObjs *objs);
+void test_create_from_dec(TestObjs *objs);
+void test_format_as_dec(TestObjs *objs);
+void test_double_conversion(TestObjs *objs);
+void test_int_conversion(TestObjs *objs);
+void test_expr(TestObjs *objs);
+void test_expr_errors(TestObjs *objs);
+void test_sqrt(TestObjs *objs);
+void test_exp2_log2(TestObjs *objs);
+void test_poly_eval(TestObjs *objs);
+void test_scan(TestObjs *objs);
+void test_scan_threads(TestObjs *objs);
+void test_window(TestObjs *objs);
+void test_window_n(TestObjs *objs);
+void test_codec(TestObjs *objs);
+void test_dict(TestObjs *objs);
+void test_arena(TestObjs *objs);
+void test_arena_local(TestObjs *objs);
+void test_stats(TestObjs *objs);
+void test_trace(TestObjs *objs);
+void test_trace_hook(TestObjs *objs);
+void test_atomic(TestObjs *objs);
+void test_atomic_threads(TestObjs *objs);
+void test_atomic_edge(TestObjs *objs);
+void test_pipeline(TestObjs *objs);
+void test_service(TestObjs *objs);
+void test_ingest(TestObjs *objs);
+void test_gemm(TestObjs *objs);
+void test_gemm_blocks(TestObjs *objs);
+void test_wide(TestObjs *objs);
+void test_wide_matches_fixedpoint(TestObjs *objs);
+void test_literals(TestObjs *objs);
+void test_unchecked(TestObjs *objs);
 
 int main(int argc, char **argv)
 {
@@ -77,6 +140,45 @@ int main(int argc, char **argv)
   TEST(test_add2);
   TEST(test_create_from_hex2);
   TEST(test_format_as_hex2);
+  TEST(test_add_carry_overflow);
+  TEST(test_status_flags);
+  TEST(test_batch_ops);
+  TEST(test_mul);
+  TEST(test_saturating);
+  TEST(test_rounding);
+  TEST(test_div);
+  TEST(test_create_from_dec);
+  TEST(test_format_as_dec);
+  TEST(test_double_conversion);
+  TEST(test_int_conversion);
+  TEST(test_expr);
+  TEST(test_expr_errors);
+  TEST(test_sqrt);
+  TEST(test_exp2_log2);
+  TEST(test_poly_eval);
+  TEST(test_scan);
+  TEST(test_scan_threads);
+  TEST(test_window);
+  TEST(test_window_n);
+  TEST(test_codec);
+  TEST(test_dict);
+  TEST(test_arena);
+  TEST(test_arena_local);
+  TEST(test_stats);
+  TEST(test_trace);
+  TEST(test_trace_hook);
+  TEST(test_atomic);
+  TEST(test_atomic_threads);
+  TEST(test_atomic_edge);
+  TEST(test_pipeline);
+  TEST(test_service);
+  TEST(test_ingest);
+  TEST(test_gemm);
+  TEST(test_gemm_blocks);
+  TEST(test_wide);
+  TEST(test_wide_matches_fixedpoint);
+  TEST(test_literals);
+  TEST(test_unchecked);
 
   // IMPORTANT: if you add additional test functions (which you should!),
   // make sure they are included here.  E.g., if you add a test function
@@ -614,4 +716,2252 @@ void test_format_as_hex2()
   s = fixedpoint_format_as_hex(a);
   ASSERT(0 == strcmp(s, "-1"));
   free(s);
-}
\ No newline at end of file
+}
+
+void test_add_carry_overflow(TestObjs *objs)
+{
+  Fixedpoint lhs, sum;
+  char *s;
+
+  // the carry out of the fraction is what overflows the whole part
+  lhs = fixedpoint_create2(0xFFFFFFFFFFFFFFFFUL, 0x8000000000000000UL);
+  sum = fixedpoint_add(lhs, objs->one_half);
+  ASSERT(fixedpoint_is_overflow_pos(sum));
+
+  sum = fixedpoint_add(fixedpoint_negate(lhs), fixedpoint_negate(objs->one_half));
+  ASSERT(fixedpoint_is_overflow_neg(sum));
+
+  // -1 + 1 is zero, and zero is formatted without a sign
+  sum = fixedpoint_add(fixedpoint_negate(objs->one), objs->one);
+  ASSERT(fixedpoint_is_zero(sum));
+  s = fixedpoint_format_as_hex(sum);
+  ASSERT(0 == strcmp(s, "0"));
+  free(s);
+}
+
+void test_status_flags(TestObjs *objs)
+{
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  ASSERT(0 == fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+
+  // valid results don't raise anything
+  fixedpoint_add(objs->one, objs->one_half);
+  fixedpoint_halve(objs->one);
+  ASSERT(0 == fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+
+  fixedpoint_add(objs->max, objs->one);
+  ASSERT(FIXEDPOINT_STATUS_OVERFLOW_POS == fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+
+  // flags are sticky
+  fixedpoint_add(objs->one, objs->one);
+  fixedpoint_halve(fixedpoint_negate(fixedpoint_create2(0UL, 1UL)));
+  fixedpoint_create_from_hex("xyz");
+  ASSERT(FIXEDPOINT_STATUS_OVERFLOW_POS == fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS));
+  ASSERT(FIXEDPOINT_STATUS_UNDERFLOW_NEG == fixedpoint_status_test(FIXEDPOINT_STATUS_UNDERFLOW_NEG));
+  ASSERT(FIXEDPOINT_STATUS_ERR == fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+  ASSERT(0 == fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_NEG | FIXEDPOINT_STATUS_UNDERFLOW_POS));
+
+  fixedpoint_sub(fixedpoint_negate(objs->max), objs->one);
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_NEG));
+
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_OVERFLOW_POS);
+  ASSERT(0 == fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  fixedpoint_status_raise(FIXEDPOINT_STATUS_UNDERFLOW_POS);
+  ASSERT(FIXEDPOINT_STATUS_UNDERFLOW_POS == fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_batch_ops(TestObjs *objs)
+{
+  Fixedpoint left[4] = {objs->one, objs->large1, objs->max, fixedpoint_negate(objs->one_fourth)};
+  Fixedpoint right[4] = {objs->one_half, objs->large2, objs->one, objs->one_fourth};
+  Fixedpoint out[4];
+  int cmp[4];
+
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  fixedpoint_add_n(left, right, out, 4);
+  for (int i = 0; i < 4; i++)
+  {
+    Fixedpoint expected = fixedpoint_add(left[i], right[i]);
+    ASSERT(expected.tag == out[i].tag);
+    ASSERT(0 == fixedpoint_compare(expected, out[i]) || !fixedpoint_is_valid(out[i]));
+  }
+  ASSERT(fixedpoint_is_overflow_pos(out[2]));
+  ASSERT(fixedpoint_is_zero(out[3]));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+  fixedpoint_sub_n(left, right, out, 4);
+  ASSERT(0 == fixedpoint_compare(out[0], objs->one_half));
+  ASSERT(0 == fixedpoint_compare(out[3], fixedpoint_negate(objs->one_half)));
+
+  fixedpoint_halve_n(left, out, 4);
+  ASSERT(0 == fixedpoint_compare(out[0], objs->one_half));
+  ASSERT(fixedpoint_is_underflow_pos(out[2]));
+
+  // in place
+  fixedpoint_double_n(out, out, 1);
+  ASSERT(0 == fixedpoint_compare(out[0], objs->one));
+
+  fixedpoint_negate_n(left, out, 4);
+  ASSERT(fixedpoint_is_neg(out[0]));
+  ASSERT(!fixedpoint_is_neg(out[3]));
+
+  fixedpoint_compare_n(left, right, cmp, 4);
+  ASSERT(1 == cmp[0]);
+  ASSERT(1 == cmp[1]);
+  ASSERT(1 == cmp[2]);
+  ASSERT(-1 == cmp[3]);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_mul(TestObjs *objs)
+{
+  Fixedpoint product;
+
+  product = fixedpoint_mul(objs->one_half, objs->one_half);
+  ASSERT(0 == fixedpoint_compare(product, objs->one_fourth));
+
+  product = fixedpoint_mul(fixedpoint_create_from_hex("-3.8"), fixedpoint_create(2UL));
+  ASSERT(fixedpoint_is_neg(product));
+  ASSERT(7UL == fixedpoint_whole_part(product));
+  ASSERT(0UL == fixedpoint_frac_part(product));
+
+  product = fixedpoint_mul(fixedpoint_create_from_hex("-1.8"), fixedpoint_create_from_hex("-1.8"));
+  ASSERT(0 == fixedpoint_compare(product, fixedpoint_create_from_hex("2.4")));
+
+  product = fixedpoint_mul(objs->zero, fixedpoint_negate(objs->max));
+  ASSERT(fixedpoint_is_zero(product));
+  ASSERT(!fixedpoint_is_neg(product));
+
+  product = fixedpoint_mul(objs->max, objs->max);
+  ASSERT(fixedpoint_is_overflow_pos(product));
+
+  product = fixedpoint_mul(fixedpoint_create(0x100000000UL), fixedpoint_negate(fixedpoint_create(0x100000000UL)));
+  ASSERT(fixedpoint_is_overflow_neg(product));
+
+  // 2^-64 * 2^-1 can't be represented
+  product = fixedpoint_mul(fixedpoint_create2(0UL, 1UL), objs->one_half);
+  ASSERT(fixedpoint_is_underflow_pos(product));
+  product = fixedpoint_mul(fixedpoint_create2(0UL, 1UL), fixedpoint_negate(objs->one_half));
+  ASSERT(fixedpoint_is_underflow_neg(product));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_saturating(TestObjs *objs)
+{
+  Fixedpoint neg_max = fixedpoint_negate(objs->max);
+  Fixedpoint result;
+
+  // in range: same as the exact operations
+  result = fixedpoint_add_sat(objs->large1, objs->large2);
+  ASSERT(0 == fixedpoint_compare(result, fixedpoint_add(objs->large1, objs->large2)));
+  result = fixedpoint_sub_sat(objs->large2, objs->large1);
+  ASSERT(0 == fixedpoint_compare(result, fixedpoint_sub(objs->large2, objs->large1)));
+  result = fixedpoint_double_sat(fixedpoint_negate(objs->large1));
+  ASSERT(0 == fixedpoint_compare(result, fixedpoint_double(fixedpoint_negate(objs->large1))));
+  result = fixedpoint_add_sat(objs->max, neg_max);
+  ASSERT(fixedpoint_is_zero(result));
+  ASSERT(!fixedpoint_is_neg(result));
+
+  // out of range: clamped with the right sign
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  result = fixedpoint_add_sat(objs->max, objs->one);
+  ASSERT(0 == fixedpoint_compare(result, objs->max));
+  result = fixedpoint_sub_sat(neg_max, objs->one_fourth);
+  ASSERT(0 == fixedpoint_compare(result, neg_max));
+  result = fixedpoint_double_sat(neg_max);
+  ASSERT(0 == fixedpoint_compare(result, neg_max));
+  result = fixedpoint_mul_sat(objs->max, neg_max);
+  ASSERT(0 == fixedpoint_compare(result, neg_max));
+  ASSERT(0 == fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+
+  // product bits below 2^-64 are truncated
+  result = fixedpoint_mul_sat(fixedpoint_create2(0UL, 3UL), objs->one_half);
+  ASSERT(0 == fixedpoint_compare(result, fixedpoint_create2(0UL, 1UL)));
+
+  Fixedpoint left[3] = {objs->max, objs->one, neg_max};
+  Fixedpoint right[3] = {objs->one, objs->one, objs->max};
+  Fixedpoint out[3];
+  ASSERT(1 == fixedpoint_add_sat_n(left, right, out, 3));
+  ASSERT(0 == fixedpoint_compare(out[0], objs->max));
+  ASSERT(0 == fixedpoint_compare(out[1], fixedpoint_create(2UL)));
+  ASSERT(fixedpoint_is_zero(out[2]));
+  ASSERT(1 == fixedpoint_sub_sat_n(right, left, out, 3));
+  ASSERT(2 == fixedpoint_double_sat_n(left, out, 3));
+  ASSERT(1 == fixedpoint_mul_sat_n(left, right, out, 3));
+  ASSERT(0 == fixedpoint_compare(out[2], neg_max));
+}
+
+void test_rounding(TestObjs *objs)
+{
+  // 2^-64 * 3, halved, is 1.5 units in the last place
+  Fixedpoint three_ulp = fixedpoint_create2(0UL, 3UL);
+  Fixedpoint one_ulp = fixedpoint_create2(0UL, 1UL);
+  Fixedpoint two_ulp = fixedpoint_create2(0UL, 2UL);
+  Fixedpoint r;
+
+  r = fixedpoint_halve_round(three_ulp, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_pos(r));
+  r = fixedpoint_halve_round(three_ulp, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, two_ulp));
+  r = fixedpoint_halve_round(three_ulp, FIXEDPOINT_ROUND_TOWARD_ZERO);
+  ASSERT(0 == fixedpoint_compare(r, one_ulp));
+  r = fixedpoint_halve_round(three_ulp, FIXEDPOINT_ROUND_FLOOR);
+  ASSERT(0 == fixedpoint_compare(r, one_ulp));
+  r = fixedpoint_halve_round(three_ulp, FIXEDPOINT_ROUND_CEIL);
+  ASSERT(0 == fixedpoint_compare(r, two_ulp));
+
+  // negative values: floor and ceil go the other way
+  r = fixedpoint_halve_round(fixedpoint_negate(three_ulp), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_neg(r));
+  r = fixedpoint_halve_round(fixedpoint_negate(three_ulp), FIXEDPOINT_ROUND_FLOOR);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_negate(two_ulp)));
+  r = fixedpoint_halve_round(fixedpoint_negate(three_ulp), FIXEDPOINT_ROUND_CEIL);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_negate(one_ulp)));
+
+  // ties go to even
+  r = fixedpoint_halve_round(one_ulp, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(fixedpoint_is_zero(r));
+  r = fixedpoint_shr_round(fixedpoint_create2(0UL, 0x1CUL), 3, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create2(0UL, 4UL)));
+  r = fixedpoint_shr_round(fixedpoint_create2(0UL, 0x1DUL), 3, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create2(0UL, 4UL)));
+  r = fixedpoint_shr_round(fixedpoint_create2(0UL, 0x14UL), 3, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create2(0UL, 2UL)));
+
+  // exact results are unaffected by the mode
+  r = fixedpoint_halve_round(objs->one, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, objs->one_half));
+  r = fixedpoint_shr_round(objs->max, 64, FIXEDPOINT_ROUND_TOWARD_ZERO);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create2(0UL, 0xFFFFFFFFFFFFFFFFUL)));
+
+  // rounding up can overflow
+  r = fixedpoint_mul_round(objs->max, fixedpoint_create2(0UL, 0xFFFFFFFFFFFFFFFFUL), FIXEDPOINT_ROUND_CEIL);
+  ASSERT(fixedpoint_is_valid(r));
+  r = fixedpoint_shl(objs->max, 1);
+  ASSERT(fixedpoint_is_overflow_pos(r));
+  r = fixedpoint_shl(fixedpoint_negate(objs->one), 63);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_negate(fixedpoint_create(0x8000000000000000UL))));
+  r = fixedpoint_shl(fixedpoint_negate(objs->one), 64);
+  ASSERT(fixedpoint_is_overflow_neg(r));
+
+  r = fixedpoint_mul_round(three_ulp, objs->one_half, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, two_ulp));
+  r = fixedpoint_mul_round(three_ulp, objs->one_half, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_pos(r));
+
+  Fixedpoint vals[2] = {three_ulp, fixedpoint_negate(three_ulp)};
+  Fixedpoint out[2];
+  fixedpoint_halve_round_n(vals, FIXEDPOINT_ROUND_FLOOR, out, 2);
+  ASSERT(0 == fixedpoint_compare(out[0], one_ulp));
+  ASSERT(0 == fixedpoint_compare(out[1], fixedpoint_negate(two_ulp)));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_div(TestObjs *objs)
+{
+  Fixedpoint r;
+
+  r = fixedpoint_div_round(objs->one, fixedpoint_create(4UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, objs->one_fourth));
+
+  r = fixedpoint_div_round(fixedpoint_create_from_hex("-2.4"), fixedpoint_create_from_hex("1.8"), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("-1.8")));
+
+  // 1/3 = 0.5555...
+  r = fixedpoint_div_round(objs->one, fixedpoint_create(3UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_pos(r));
+  r = fixedpoint_div_round(objs->one, fixedpoint_create(3UL), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("0.5555555555555555")));
+  r = fixedpoint_div_round(objs->one, fixedpoint_create(3UL), FIXEDPOINT_ROUND_CEIL);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("0.5555555555555556")));
+  // 2/3 = 0.aaaa...
+  r = fixedpoint_div_round(fixedpoint_create(2UL), fixedpoint_create(3UL), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("0.aaaaaaaaaaaaaaab")));
+  r = fixedpoint_div_round(fixedpoint_create(2UL), fixedpoint_negate(fixedpoint_create(3UL)), FIXEDPOINT_ROUND_TOWARD_ZERO);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("-0.aaaaaaaaaaaaaaaa")));
+
+  r = fixedpoint_div_round(objs->max, objs->max, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, objs->one));
+  r = fixedpoint_div_round(objs->large1, objs->one, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, objs->large1));
+
+  r = fixedpoint_div_round(objs->max, objs->one_half, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_overflow_pos(r));
+  r = fixedpoint_div_round(fixedpoint_negate(objs->one), fixedpoint_create2(0UL, 1UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_overflow_neg(r));
+
+  r = fixedpoint_div_round(objs->one, objs->zero, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_err(r));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_create_from_dec(TestObjs *objs)
+{
+  Fixedpoint val;
+
+  val = fixedpoint_create_from_dec("1.5");
+  ASSERT(0 == fixedpoint_compare(val, fixedpoint_create_from_hex("1.8")));
+
+  val = fixedpoint_create_from_dec("-123456789012345678.25");
+  ASSERT(fixedpoint_is_neg(val));
+  ASSERT(123456789012345678UL == fixedpoint_whole_part(val));
+  ASSERT(0x4000000000000000UL == fixedpoint_frac_part(val));
+
+  val = fixedpoint_create_from_dec("18446744073709551615");
+  ASSERT(0xFFFFFFFFFFFFFFFFUL == fixedpoint_whole_part(val));
+
+  // 0.1 rounds to nearest
+  val = fixedpoint_create_from_dec("0.1");
+  ASSERT(0x199999999999999AUL == fixedpoint_frac_part(val));
+  val = fixedpoint_create_from_dec_round("0.1", FIXEDPOINT_ROUND_TOWARD_ZERO);
+  ASSERT(0x1999999999999999UL == fixedpoint_frac_part(val));
+  val = fixedpoint_create_from_dec_round("-0.1", FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_neg(val));
+
+  // 2^-64 written out exactly
+  val = fixedpoint_create_from_dec_round("0.0000000000000000000542101086242752217003726400434970855712890625",
+                                         FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(val, fixedpoint_create2(0UL, 1UL)));
+
+  // empty parts, as with hex
+  ASSERT(fixedpoint_is_zero(fixedpoint_create_from_dec(".")));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_create_from_dec(".5"), objs->one_half));
+  ASSERT(!fixedpoint_is_neg(fixedpoint_create_from_dec("-0")));
+
+  val = fixedpoint_create_from_dec("18446744073709551616");
+  ASSERT(fixedpoint_is_overflow_pos(val));
+  val = fixedpoint_create_from_dec("-18446744073709551615.99999999999999999999");
+  ASSERT(fixedpoint_is_overflow_neg(val));
+
+  ASSERT(fixedpoint_is_err(fixedpoint_create_from_dec("12345678a")));
+  ASSERT(fixedpoint_is_err(fixedpoint_create_from_dec("1.2345678a")));
+  ASSERT(fixedpoint_is_err(fixedpoint_create_from_dec("1.2.3")));
+  ASSERT(fixedpoint_is_err(fixedpoint_create_from_dec("0x10")));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_format_as_dec(TestObjs *objs)
+{
+  char buf[FIXEDPOINT_DEC_BUF_SIZE];
+
+  fixedpoint_format_as_dec(objs->zero, buf, sizeof(buf));
+  ASSERT(0 == strcmp(buf, "0"));
+  fixedpoint_format_as_dec(objs->one_fourth, buf, sizeof(buf));
+  ASSERT(0 == strcmp(buf, "0.25"));
+  fixedpoint_format_as_dec(fixedpoint_negate(objs->large1), buf, sizeof(buf));
+  ASSERT(0 == strcmp(buf, "-20159855850.0000000550882011687"));
+  fixedpoint_format_as_dec(fixedpoint_create_from_dec("0.1"), buf, sizeof(buf));
+  ASSERT(0 == strcmp(buf, "0.1"));
+  fixedpoint_format_as_dec(fixedpoint_create2(0UL, 1UL), buf, sizeof(buf));
+  ASSERT(0 == strcmp(buf, "0.00000000000000000005"));
+
+  // the longest string fits in the buffer
+  ASSERT(42 == fixedpoint_format_as_dec(fixedpoint_negate(objs->max), buf, sizeof(buf)));
+  ASSERT(0 == strcmp(buf, "-18446744073709551615.99999999999999999995"));
+
+  // truncated like snprintf
+  ASSERT(4 == fixedpoint_format_as_dec(objs->one_fourth, buf, 3));
+  ASSERT(0 == strcmp(buf, "0."));
+
+  Fixedpoint vals[3] = {objs->one, objs->one_half, fixedpoint_negate(objs->one_fourth)};
+  char out[3][FIXEDPOINT_DEC_BUF_SIZE];
+  const char *strs[3] = {"1", "0.5", "-0.25"};
+  Fixedpoint back[3];
+  fixedpoint_format_as_dec_n(vals, out, 3);
+  fixedpoint_create_from_dec_n(strs, back, 3);
+  for (int i = 0; i < 3; i++)
+  {
+    ASSERT(0 == strcmp(out[i], strs[i]));
+    ASSERT(0 == fixedpoint_compare(back[i], vals[i]));
+  }
+}
+
+void test_double_conversion(TestObjs *objs)
+{
+  Fixedpoint val;
+
+  ASSERT(0.0 == fixedpoint_to_double(objs->zero));
+  ASSERT(0.5 == fixedpoint_to_double(objs->one_half));
+  ASSERT(-0.25 == fixedpoint_to_double(fixedpoint_negate(objs->one_fourth)));
+  ASSERT(0x1p64 == fixedpoint_to_double(objs->max));
+  ASSERT(0x1p-64 == fixedpoint_to_double(fixedpoint_create2(0UL, 1UL)));
+  // 1 + 2^-53 is a tie between 1 and 1 + 2^-52; the sticky bit breaks it
+  ASSERT(1.0 == fixedpoint_to_double(fixedpoint_create2(1UL, 0x800UL)));
+  ASSERT(1.0 + 0x1p-52 == fixedpoint_to_double(fixedpoint_create2(1UL, 0x801UL)));
+  ASSERT(1.5f == fixedpoint_to_float(fixedpoint_create_from_hex("1.8")));
+
+  val = fixedpoint_from_double(-1234.5, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(val, fixedpoint_create_from_dec("-1234.5")));
+  val = fixedpoint_from_double(0x1p-64, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(val, fixedpoint_create2(0UL, 1UL)));
+  val = fixedpoint_from_double(0x1p-65, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_pos(val));
+  val = fixedpoint_from_double(-0x3p-66, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(val, fixedpoint_negate(fixedpoint_create2(0UL, 1UL))));
+  val = fixedpoint_from_double(-1e-300, FIXEDPOINT_ROUND_FLOOR);
+  ASSERT(0 == fixedpoint_compare(val, fixedpoint_negate(fixedpoint_create2(0UL, 1UL))));
+  val = fixedpoint_from_double(-1e-300, FIXEDPOINT_ROUND_TOWARD_ZERO);
+  ASSERT(fixedpoint_is_zero(val));
+  val = fixedpoint_from_double(0x1p64, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_overflow_pos(val));
+  val = fixedpoint_from_double(-INFINITY, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_overflow_neg(val));
+  val = fixedpoint_from_double(NAN, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_err(val));
+  val = fixedpoint_from_double(0x1.fffffffffffffp63, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0xFFFFFFFFFFFFF800UL == fixedpoint_whole_part(val));
+
+  double ds[3] = {0.75, -2.0, 1e30};
+  Fixedpoint fs[3];
+  double back[3];
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  fixedpoint_from_double_n(ds, FIXEDPOINT_ROUND_EXACT, fs, 3);
+  ASSERT(fixedpoint_is_overflow_pos(fs[2]));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS));
+  fixedpoint_to_double_n(fs, back, 2);
+  ASSERT(0.75 == back[0]);
+  ASSERT(-2.0 == back[1]);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_int_conversion(TestObjs *objs)
+{
+  int64_t n;
+
+  ASSERT(0 == fixedpoint_compare(fixedpoint_from_int64(-5), fixedpoint_negate(fixedpoint_create(5UL))));
+  ASSERT(0x8000000000000000UL == fixedpoint_whole_part(fixedpoint_from_int64(INT64_MIN)));
+  ASSERT(fixedpoint_is_zero(fixedpoint_from_int64(0)));
+
+  ASSERT(0 == fixedpoint_to_int64(fixedpoint_create_from_dec("2.5"), FIXEDPOINT_ROUND_NEAREST_EVEN, &n));
+  ASSERT(2 == n);
+  ASSERT(1 == fixedpoint_to_int64(fixedpoint_create_from_dec("-2.5"), FIXEDPOINT_ROUND_FLOOR, &n));
+  ASSERT(-3 == n);
+  ASSERT(5 == fixedpoint_to_int64(fixedpoint_create_from_dec("-2.5"), FIXEDPOINT_ROUND_EXACT, &n));
+  ASSERT(-2 == n);
+  ASSERT(4 == fixedpoint_to_int64(objs->max, FIXEDPOINT_ROUND_TOWARD_ZERO, &n));
+  ASSERT(INT64_MAX == n);
+  ASSERT(1 == fixedpoint_to_int64(fixedpoint_from_int64(INT64_MIN), FIXEDPOINT_ROUND_EXACT, &n));
+  ASSERT(INT64_MIN == n);
+  ASSERT(3 == fixedpoint_to_int64(fixedpoint_create_from_dec("-9223372036854775808.5"), FIXEDPOINT_ROUND_FLOOR, &n));
+  ASSERT(INT64_MIN == n);
+
+  // cents
+  Fixedpoint val = fixedpoint_from_scaled(-1999, 100UL, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(val, fixedpoint_create_from_dec("-19.99")));
+  ASSERT(fixedpoint_is_underflow_neg(fixedpoint_from_scaled(-1999, 100UL, FIXEDPOINT_ROUND_EXACT)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_from_scaled(3, 4UL, FIXEDPOINT_ROUND_EXACT), fixedpoint_create_from_hex("0.c")));
+  ASSERT(1 == fixedpoint_to_scaled(val, 100UL, FIXEDPOINT_ROUND_NEAREST_EVEN, &n));
+  ASSERT(-1999 == n);
+
+  int64_t cents[3] = {150, -1, INT64_MAX};
+  Fixedpoint vals[3];
+  int64_t back[3];
+  fixedpoint_from_scaled_n(cents, 100UL, FIXEDPOINT_ROUND_NEAREST_EVEN, vals, 3);
+  ASSERT(0 == fixedpoint_to_scaled_n(vals, 100UL, FIXEDPOINT_ROUND_NEAREST_EVEN, back, 3));
+  ASSERT(150 == back[0] && -1 == back[1] && INT64_MAX == back[2]);
+  ASSERT(3 == fixedpoint_to_int64_n(vals, FIXEDPOINT_ROUND_EXACT, back, 3));
+  ASSERT(0 == fixedpoint_to_int64_n(vals, FIXEDPOINT_ROUND_TOWARD_ZERO, back, 3));
+  ASSERT(1 == back[0] && 0 == back[1] && INT64_MAX / 100 == back[2]);
+
+  // a scale of 0 gives errors, as a zero divisor does
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  ASSERT(fixedpoint_is_err(fixedpoint_from_scaled(5, 0UL, FIXEDPOINT_ROUND_NEAREST_EVEN)));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+  fixedpoint_from_scaled_n(cents, 0UL, FIXEDPOINT_ROUND_EXACT, vals, 3);
+  ASSERT(fixedpoint_is_err(vals[0]) && fixedpoint_is_err(vals[1]) && fixedpoint_is_err(vals[2]));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_expr(TestObjs *objs)
+{
+  const char *names[4] = {"a", "b", "c", "d"};
+  size_t n = 3000;
+  Fixedpoint *cols[4];
+  Fixedpoint *out = malloc(n * sizeof(Fixedpoint));
+
+  for (int j = 0; j < 4; j++)
+  {
+    cols[j] = malloc(n * sizeof(Fixedpoint));
+    for (size_t i = 0; i < n; i++)
+    {
+      cols[j][i] = fixedpoint_create2(i * (j + 1), (uint64_t)i << 40);
+      if (i % 3 == (size_t)j % 3)
+      {
+        cols[j][i] = fixedpoint_negate(cols[j][i]);
+      }
+    }
+  }
+
+  FixedpointExpr *expr = fixedpoint_expr_compile("(a + b) * c - d/2", names, 4, FIXEDPOINT_ROUND_EXACT, NULL);
+  ASSERT(expr != NULL);
+  ASSERT(fixedpoint_expr_eval(expr, (const Fixedpoint *const *)cols, out, n));
+  for (size_t i = 0; i < n; i++)
+  {
+    Fixedpoint expected = fixedpoint_sub(fixedpoint_mul(fixedpoint_add(cols[0][i], cols[1][i]), cols[2][i]),
+                                         fixedpoint_halve(cols[3][i]));
+    ASSERT(expected.tag == out[i].tag);
+    ASSERT(!fixedpoint_is_valid(out[i]) || 0 == fixedpoint_compare(expected, out[i]));
+  }
+  fixedpoint_expr_destroy(expr);
+
+  // constants, unary minus, and the result written over an input column
+  expr = fixedpoint_expr_compile("-a * 0x1.8 + 2.5 / b", names, 2, FIXEDPOINT_ROUND_NEAREST_EVEN, NULL);
+  ASSERT(expr != NULL);
+  Fixedpoint a[2] = {fixedpoint_create(2UL), objs->one};
+  Fixedpoint b[2] = {objs->one_half, objs->zero};
+  const Fixedpoint *ab[2] = {a, b};
+  ASSERT(fixedpoint_expr_eval(expr, ab, a, 2));
+  ASSERT(0 == fixedpoint_compare(a[0], fixedpoint_create(2UL)));
+  // division by zero propagates as an error
+  ASSERT(fixedpoint_is_err(a[1]));
+  fixedpoint_expr_destroy(expr);
+
+  // overflow in an intermediate result propagates through later steps
+  expr = fixedpoint_expr_compile("a * 2 - b", names, 2, FIXEDPOINT_ROUND_EXACT, NULL);
+  Fixedpoint big[1] = {objs->max};
+  Fixedpoint one[1] = {objs->one};
+  const Fixedpoint *big_one[2] = {big, one};
+  ASSERT(fixedpoint_expr_eval(expr, big_one, out, 1));
+  ASSERT(fixedpoint_is_overflow_pos(out[0]));
+  fixedpoint_expr_destroy(expr);
+
+  for (int j = 0; j < 4; j++)
+  {
+    free(cols[j]);
+  }
+  free(out);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_expr_errors(TestObjs *objs)
+{
+  (void)objs;
+  const char *names[2] = {"price", "qty"};
+  size_t pos = 0;
+
+  ASSERT(NULL == fixedpoint_expr_compile("price * qtx", names, 2, FIXEDPOINT_ROUND_EXACT, &pos));
+  ASSERT(8 == pos);
+  ASSERT(NULL == fixedpoint_expr_compile("(price + qty", names, 2, FIXEDPOINT_ROUND_EXACT, &pos));
+  ASSERT(12 == pos);
+  ASSERT(NULL == fixedpoint_expr_compile("price qty", names, 2, FIXEDPOINT_ROUND_EXACT, &pos));
+  ASSERT(6 == pos);
+  ASSERT(NULL == fixedpoint_expr_compile("1.2.3", names, 2, FIXEDPOINT_ROUND_EXACT, &pos));
+  ASSERT(NULL == fixedpoint_expr_compile("", names, 2, FIXEDPOINT_ROUND_EXACT, &pos));
+
+  // too deeply nested for the registers
+  ASSERT(NULL == fixedpoint_expr_compile("1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1+(1)))))))))))))))",
+                                         names, 2, FIXEDPOINT_ROUND_EXACT, NULL));
+
+  FixedpointExpr *expr = fixedpoint_expr_compile(" price*qty ", names, 2, FIXEDPOINT_ROUND_EXACT, NULL);
+  ASSERT(expr != NULL);
+  fixedpoint_expr_destroy(expr);
+
+  // unary minuses and parentheses nest up to FIXEDPOINT_EXPR_MAX_DEPTH,
+  // and a long chain of them fails rather than overflowing the stack
+  size_t len = 2000000;
+  char *src = malloc(len + sizeof("price"));
+  memset(src, '-', FIXEDPOINT_EXPR_MAX_DEPTH);
+  strcpy(src + FIXEDPOINT_EXPR_MAX_DEPTH, "price");
+  expr = fixedpoint_expr_compile(src, names, 2, FIXEDPOINT_ROUND_EXACT, NULL);
+  ASSERT(expr != NULL);
+  fixedpoint_expr_destroy(expr);
+  for (int i = 0; i < 2; i++)
+  {
+    memset(src, i == 0 ? '-' : '(', len);
+    strcpy(src + len, "price");
+    ASSERT(NULL == fixedpoint_expr_compile(src, names, 2, FIXEDPOINT_ROUND_EXACT, &pos));
+    ASSERT(FIXEDPOINT_EXPR_MAX_DEPTH == pos);
+  }
+  free(src);
+}
+
+void test_sqrt(TestObjs *objs)
+{
+  Fixedpoint r;
+
+  r = fixedpoint_sqrt(fixedpoint_create(4UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create(2UL)));
+  r = fixedpoint_sqrt(objs->one_fourth, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, objs->one_half));
+  r = fixedpoint_sqrt(objs->zero, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_zero(r));
+  r = fixedpoint_sqrt(fixedpoint_create2(0UL, 1UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create2(0UL, 0x100000000UL)));
+
+  // sqrt(2) = 1.6a09e667f3bcc908b2...
+  r = fixedpoint_sqrt(fixedpoint_create(2UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_pos(r));
+  r = fixedpoint_sqrt(fixedpoint_create(2UL), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("1.6a09e667f3bcc909")));
+  r = fixedpoint_sqrt(fixedpoint_create(2UL), FIXEDPOINT_ROUND_TOWARD_ZERO);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("1.6a09e667f3bcc908")));
+
+  // the largest value: sqrt(2^64 - 2^-64) is just below 2^32
+  r = fixedpoint_sqrt(objs->max, FIXEDPOINT_ROUND_FLOOR);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("ffffffff.ffffffffffffffff")));
+  r = fixedpoint_sqrt(objs->max, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create(0x100000000UL)));
+
+  r = fixedpoint_sqrt(fixedpoint_negate(objs->one), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(fixedpoint_is_err(r));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+
+  Fixedpoint vals[3] = {fixedpoint_create(9UL), fixedpoint_create(16UL), objs->one};
+  fixedpoint_sqrt_n(vals, FIXEDPOINT_ROUND_EXACT, vals, 3);
+  ASSERT(0 == fixedpoint_compare(vals[0], fixedpoint_create(3UL)));
+  ASSERT(0 == fixedpoint_compare(vals[1], fixedpoint_create(4UL)));
+  ASSERT(0 == fixedpoint_compare(vals[2], objs->one));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_exp2_log2(TestObjs *objs)
+{
+  Fixedpoint r;
+
+  // integer powers are exact
+  r = fixedpoint_exp2(fixedpoint_create(3UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create(8UL)));
+  r = fixedpoint_exp2(fixedpoint_negate(objs->one), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, objs->one_half));
+  r = fixedpoint_exp2(fixedpoint_create(63UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create(0x8000000000000000UL)));
+  r = fixedpoint_exp2(fixedpoint_negate(fixedpoint_create(64UL)), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create2(0UL, 1UL)));
+
+  r = fixedpoint_exp2(objs->one_half, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("1.6a09e667f3bcc909")));
+  r = fixedpoint_exp2(objs->one_half, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_pos(r));
+  r = fixedpoint_exp2(fixedpoint_create_from_hex("-1.4"), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("0.6ba27e656b4eb57a")));
+  r = fixedpoint_exp2(fixedpoint_create_from_hex("a.c"), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("6ba.27e656b4eb57a1cd")));
+
+  // out of range
+  r = fixedpoint_exp2(fixedpoint_create(64UL), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(fixedpoint_is_overflow_pos(r));
+  r = fixedpoint_exp2(fixedpoint_negate(objs->large1), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(fixedpoint_is_zero(r));
+  r = fixedpoint_exp2(fixedpoint_negate(objs->large1), FIXEDPOINT_ROUND_CEIL);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create2(0UL, 1UL)));
+  r = fixedpoint_exp2(fixedpoint_negate(objs->large1), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_pos(r));
+
+  // powers of 2 have exact logarithms
+  r = fixedpoint_log2(fixedpoint_create(8UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create(3UL)));
+  r = fixedpoint_log2(objs->one_fourth, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_negate(fixedpoint_create(2UL))));
+  r = fixedpoint_log2(objs->one, FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_zero(r));
+  r = fixedpoint_log2(fixedpoint_create2(0UL, 1UL), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_negate(fixedpoint_create(64UL))));
+
+  // log2(3) = 1.95c01a39fbd6879f a0..., log2(0.75) = -0.6a3fe5c604297860 5f...
+  r = fixedpoint_log2(fixedpoint_create(3UL), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("1.95c01a39fbd687a0")));
+  r = fixedpoint_log2(fixedpoint_create(3UL), FIXEDPOINT_ROUND_TOWARD_ZERO);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("1.95c01a39fbd6879f")));
+  r = fixedpoint_log2(fixedpoint_create_from_hex("0.c"), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("-0.6a3fe5c604297860")));
+  r = fixedpoint_log2(fixedpoint_create_from_hex("0.c"), FIXEDPOINT_ROUND_FLOOR);
+  ASSERT(0 == fixedpoint_compare(r, fixedpoint_create_from_hex("-0.6a3fe5c604297861")));
+  r = fixedpoint_log2(fixedpoint_create_from_hex("0.c"), FIXEDPOINT_ROUND_EXACT);
+  ASSERT(fixedpoint_is_underflow_neg(r));
+
+  r = fixedpoint_log2(objs->zero, FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(fixedpoint_is_err(r));
+  r = fixedpoint_log2(fixedpoint_negate(objs->one), FIXEDPOINT_ROUND_NEAREST_EVEN);
+  ASSERT(fixedpoint_is_err(r));
+
+  // round trips through the batch versions (for powers of at least 1, so
+  // that exp2 keeps enough significant bits)
+  Fixedpoint vals[3] = {objs->one_half, fixedpoint_create(5UL), fixedpoint_create_from_hex("2a.5")};
+  Fixedpoint out[3];
+  fixedpoint_exp2_n(vals, FIXEDPOINT_ROUND_NEAREST_EVEN, out, 3);
+  fixedpoint_log2_n(out, FIXEDPOINT_ROUND_NEAREST_EVEN, out, 3);
+  for (int i = 0; i < 3; i++)
+  {
+    Fixedpoint diff = fixedpoint_sub(out[i], vals[i]);
+    ASSERT(fixedpoint_whole_part(diff) == 0 && fixedpoint_frac_part(diff) <= 2);
+  }
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_poly_eval(TestObjs *objs)
+{
+  // 1.5 - 2x + 0.25x^2 + x^3, compared with Horner's rule using the scalar
+  // operations (all of these products are exact)
+  Fixedpoint coeffs[4] = {fixedpoint_create_from_hex("1.8"), fixedpoint_create_from_hex("-2"), objs->one_fourth,
+                          objs->one};
+  Fixedpoint xs[7] = {objs->zero,
+                      objs->one,
+                      fixedpoint_create_from_hex("-3.4"),
+                      fixedpoint_create_from_hex("100.c"),
+                      objs->one_half,
+                      fixedpoint_create_from_hex("-0.8"),
+                      fixedpoint_create(10UL)};
+  Fixedpoint out[7];
+  ASSERT(0 == fixedpoint_poly_eval_n(coeffs, 3, xs, out, 7));
+  for (int i = 0; i < 7; i++)
+  {
+    Fixedpoint expected = coeffs[3];
+    for (int k = 2; k >= 0; k--)
+    {
+      expected = fixedpoint_add(fixedpoint_mul(expected, xs[i]), coeffs[k]);
+    }
+    ASSERT(fixedpoint_is_valid(out[i]));
+    ASSERT(0 == fixedpoint_compare(out[i], expected));
+  }
+
+  // degree 0 is a constant, and the output may overwrite the points
+  fixedpoint_poly_eval_n(coeffs, 0, xs, xs, 7);
+  ASSERT(0 == fixedpoint_compare(xs[6], coeffs[0]));
+
+  // 2^32 * 2^32 - 1: the intermediate 2^64 is out of range, but the
+  // result isn't
+  Fixedpoint c[2] = {fixedpoint_negate(objs->one), fixedpoint_create(0x100000000UL)};
+  Fixedpoint x[3] = {fixedpoint_create(0x100000000UL), fixedpoint_create(0x100000001UL),
+                     fixedpoint_negate(fixedpoint_create(0x100000001UL))};
+  ASSERT(2 == fixedpoint_poly_eval_n(c, 1, x, out, 3));
+  ASSERT(0 == fixedpoint_compare(out[0], fixedpoint_create(0xFFFFFFFFFFFFFFFFUL)));
+  ASSERT(fixedpoint_is_overflow_pos(out[1]));
+  ASSERT(fixedpoint_is_overflow_neg(out[2]));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS | FIXEDPOINT_STATUS_OVERFLOW_NEG));
+
+  // a truncated product makes the result an underflow value
+  Fixedpoint tiny[1] = {fixedpoint_create2(0UL, 1UL)};
+  Fixedpoint square[3] = {objs->zero, objs->zero, fixedpoint_negate(objs->one)};
+  ASSERT(1 == fixedpoint_poly_eval_n(square, 2, tiny, out, 1));
+  ASSERT(fixedpoint_is_underflow_neg(out[0]));
+
+  // a negative degree gives errors, without reading any coefficients
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  ASSERT(3 == fixedpoint_poly_eval_n(NULL, -1, x, out, 3));
+  ASSERT(fixedpoint_is_err(out[0]) && fixedpoint_is_err(out[1]) && fixedpoint_is_err(out[2]));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_scan(TestObjs *objs)
+{
+  Fixedpoint vals[4] = {objs->one, objs->one_half, fixedpoint_negate(objs->one_fourth), objs->large1};
+  Fixedpoint out[4];
+
+  ASSERT(4 == fixedpoint_scan_inclusive_n(vals, out, 4, 1));
+  ASSERT(0 == fixedpoint_compare(out[0], objs->one));
+  ASSERT(0 == fixedpoint_compare(out[1], fixedpoint_create_from_hex("1.8")));
+  ASSERT(0 == fixedpoint_compare(out[2], fixedpoint_create_from_hex("1.4")));
+  ASSERT(0 == fixedpoint_compare(out[3], fixedpoint_add(objs->large1, out[2])));
+
+  // in place
+  ASSERT(4 == fixedpoint_scan_exclusive_n(vals, vals, 4, 1));
+  ASSERT(fixedpoint_is_zero(vals[0]));
+  ASSERT(0 == fixedpoint_compare(vals[1], out[0]));
+  ASSERT(0 == fixedpoint_compare(vals[2], out[1]));
+  ASSERT(0 == fixedpoint_compare(vals[3], out[2]));
+
+  // a running total which goes out of range and comes back
+  Fixedpoint swings[4] = {objs->max, objs->one, fixedpoint_negate(objs->max), fixedpoint_negate(objs->max)};
+  ASSERT(1 == fixedpoint_scan_inclusive_n(swings, out, 4, 1));
+  ASSERT(0 == fixedpoint_compare(out[0], objs->max));
+  ASSERT(fixedpoint_is_overflow_pos(out[1]));
+  ASSERT(0 == fixedpoint_compare(out[2], objs->one));
+  ASSERT(0 == fixedpoint_compare(out[3], fixedpoint_sub(objs->one, objs->max)));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS));
+  ASSERT(2 == fixedpoint_scan_exclusive_n(swings, out, 4, 1));
+  ASSERT(fixedpoint_is_overflow_pos(out[2]));
+
+  ASSERT(0 == fixedpoint_scan_inclusive_n(vals, out, 0, 4));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_scan_threads(TestObjs *objs)
+{
+  size_t n = 100000;
+  Fixedpoint *vals = malloc(n * sizeof(Fixedpoint));
+  Fixedpoint *serial = malloc(n * sizeof(Fixedpoint));
+  Fixedpoint *parallel = malloc(n * sizeof(Fixedpoint));
+
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = fixedpoint_create2(i * 0x9E3779B97F4A7C15UL >> 24, i * 0x2545F4914F6CDD1DUL);
+    if (i % 3 == 0)
+    {
+      vals[i] = fixedpoint_negate(vals[i]);
+    }
+  }
+  // push the total out of range in the last thread's block only
+  vals[n - 10] = objs->max;
+
+  size_t first = fixedpoint_scan_inclusive_n(vals, serial, n, 1);
+  ASSERT(first >= n - 10 && first < n);
+  ASSERT(first == fixedpoint_scan_inclusive_n(vals, parallel, n, 4));
+  for (size_t i = 0; i < n; i++)
+  {
+    ASSERT(serial[i].tag == parallel[i].tag);
+    ASSERT(serial[i].integer == parallel[i].integer && serial[i].fraction == parallel[i].fraction);
+  }
+
+  first = fixedpoint_scan_exclusive_n(vals, serial, n, 1);
+  ASSERT(first == fixedpoint_scan_exclusive_n(vals, vals, n, 3));
+  for (size_t i = 0; i < n; i++)
+  {
+    ASSERT(serial[i].tag == vals[i].tag);
+    ASSERT(serial[i].integer == vals[i].integer && serial[i].fraction == vals[i].fraction);
+  }
+
+  free(vals);
+  free(serial);
+  free(parallel);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_window(TestObjs *objs)
+{
+  FixedpointWindow *win = fixedpoint_window_create(3);
+  ASSERT(win != NULL);
+  ASSERT(NULL == fixedpoint_window_create(0));
+
+  ASSERT(0 == fixedpoint_window_count(win));
+  ASSERT(fixedpoint_is_zero(fixedpoint_window_sum(win)));
+  ASSERT(fixedpoint_is_err(fixedpoint_window_min(win)));
+  ASSERT(fixedpoint_is_err(fixedpoint_window_mean(win, FIXEDPOINT_ROUND_EXACT)));
+
+  fixedpoint_window_push(win, fixedpoint_create(5UL));
+  fixedpoint_window_push(win, objs->one);
+  fixedpoint_window_push(win, fixedpoint_create(3UL));
+  ASSERT(3 == fixedpoint_window_count(win));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_sum(win), fixedpoint_create(9UL)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_min(win), objs->one));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_max(win), fixedpoint_create(5UL)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_mean(win, FIXEDPOINT_ROUND_EXACT), fixedpoint_create(3UL)));
+
+  // evicts 5, then 1
+  fixedpoint_window_push(win, fixedpoint_create(2UL));
+  ASSERT(3 == fixedpoint_window_count(win));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_sum(win), fixedpoint_create(6UL)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_max(win), fixedpoint_create(3UL)));
+  fixedpoint_window_push(win, fixedpoint_negate(objs->one_half));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_min(win), fixedpoint_negate(objs->one_half)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_sum(win), fixedpoint_create_from_hex("4.8")));
+  // 4.5 / 3 = 1.5
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_mean(win, FIXEDPOINT_ROUND_EXACT), fixedpoint_create_from_hex("1.8")));
+
+  // the sum can go out of range and back, and the mean is always in range
+  fixedpoint_window_push(win, objs->max);
+  fixedpoint_window_push(win, objs->max);
+  ASSERT(fixedpoint_is_overflow_pos(fixedpoint_window_sum(win)));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS));
+  fixedpoint_window_push(win, objs->max);
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_mean(win, FIXEDPOINT_ROUND_EXACT), objs->max));
+  fixedpoint_window_push(win, fixedpoint_negate(objs->max));
+  fixedpoint_window_push(win, fixedpoint_negate(objs->max));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_sum(win), fixedpoint_negate(objs->max)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_window_mean(win, FIXEDPOINT_ROUND_TOWARD_ZERO),
+                                 fixedpoint_create_from_hex("-5555555555555555.5555555555555555")));
+  ASSERT(fixedpoint_is_valid(fixedpoint_window_mean(win, FIXEDPOINT_ROUND_EXACT)));
+  // (1 - 2 max) / 3 isn't exact
+  fixedpoint_window_push(win, objs->one);
+  ASSERT(fixedpoint_is_underflow_neg(fixedpoint_window_mean(win, FIXEDPOINT_ROUND_EXACT)));
+
+  fixedpoint_window_destroy(win);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_window_n(TestObjs *objs)
+{
+  (void)objs;
+  size_t n = 1000, window = 7;
+  Fixedpoint *vals = malloc(n * sizeof(Fixedpoint));
+  Fixedpoint *out = malloc(n * sizeof(Fixedpoint));
+
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = fixedpoint_create2((i * 37) % 101, i * 0x9E3779B97F4A7C15UL);
+    if (i % 4 == 1)
+    {
+      vals[i] = fixedpoint_negate(vals[i]);
+    }
+  }
+
+  // compare with recomputing each window from scratch
+  fixedpoint_window_sum_n(vals, window, out, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    Fixedpoint sum = objs->zero;
+    for (size_t j = i + 1 > window ? i + 1 - window : 0; j <= i; j++)
+    {
+      sum = fixedpoint_add(sum, vals[j]);
+    }
+    ASSERT(0 == fixedpoint_compare(out[i], sum));
+  }
+  fixedpoint_window_min_n(vals, window, out, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    for (size_t j = i + 1 > window ? i + 1 - window : 0; j <= i; j++)
+    {
+      ASSERT(fixedpoint_compare(out[i], vals[j]) <= 0);
+    }
+  }
+  fixedpoint_window_max_n(vals, window, out, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    for (size_t j = i + 1 > window ? i + 1 - window : 0; j <= i; j++)
+    {
+      ASSERT(fixedpoint_compare(out[i], vals[j]) >= 0);
+    }
+  }
+
+  // in place; the first mean is the first value
+  Fixedpoint first = vals[0];
+  fixedpoint_window_mean_n(vals, window, FIXEDPOINT_ROUND_NEAREST_EVEN, vals, n);
+  ASSERT(0 == fixedpoint_compare(vals[0], first));
+
+  free(vals);
+  free(out);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+// Check that vals round trip through the codec, and that the sum of the
+// encoded values is the same as the sum of vals.  Returns the encoded size.
+static size_t check_codec(const Fixedpoint *vals, size_t n)
+{
+  unsigned char *buf = malloc(fixedpoint_encode_bound(n));
+  Fixedpoint *decoded = malloc((n + 1) * sizeof(Fixedpoint));
+  Fixedpoint expected_sum;
+
+  size_t size = fixedpoint_encode(vals, n, buf);
+  ASSERT(size <= fixedpoint_encode_bound(n));
+  ASSERT(n == fixedpoint_encoded_count(buf, size));
+  ASSERT(fixedpoint_decode(buf, size, decoded));
+  for (size_t i = 0; i < n; i++)
+  {
+    ASSERT(vals[i].tag == decoded[i].tag);
+    ASSERT(vals[i].integer == decoded[i].integer && vals[i].fraction == decoded[i].fraction);
+  }
+  Fixedpoint sum = fixedpoint_encoded_sum(buf, size);
+  size_t num_valid = 0;
+  while (num_valid < n && fixedpoint_is_valid(vals[num_valid]))
+  {
+    num_valid++;
+  }
+  if (num_valid < n)
+  {
+    ASSERT(fixedpoint_is_err(sum));
+  }
+  else
+  {
+    fixedpoint_scan_inclusive_n(vals, decoded, n, 1);
+    expected_sum = n ? decoded[n - 1] : fixedpoint_create(0UL);
+    ASSERT(sum.tag == expected_sum.tag);
+    ASSERT(!fixedpoint_is_valid(sum) || 0 == fixedpoint_compare(sum, expected_sum));
+  }
+
+  // truncated data is rejected
+  ASSERT(n == 0 || !fixedpoint_decode(buf, size - 1, decoded));
+  free(buf);
+  free(decoded);
+  return size;
+}
+
+void test_codec(TestObjs *objs)
+{
+  size_t n = 1000;
+  Fixedpoint *vals = malloc(n * sizeof(Fixedpoint));
+
+  // prices around 100 in steps of 1/64: the distances have few bits
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = fixedpoint_create2(100 + i % 7, (i * 0x9E3779B97F4A7C15UL) & 0xFC00000000000000UL);
+  }
+  size_t size = check_codec(vals, n);
+  ASSERT(size * 4 < n * sizeof(Fixedpoint));
+
+  // a header whose shift would push distances past 128 bits is malformed
+  unsigned char *buf = malloc(fixedpoint_encode_bound(n));
+  Fixedpoint *decoded = malloc(n * sizeof(Fixedpoint));
+  size = fixedpoint_encode(vals, n, buf);
+  // the first block's header follows the 8 byte count: width, then shift
+  ASSERT(buf[8] > 0 && buf[8] <= 128);
+  buf[9] = (unsigned char)(129 - buf[8]);
+  ASSERT(!fixedpoint_decode(buf, size, decoded));
+  ASSERT(fixedpoint_is_err(fixedpoint_encoded_sum(buf, size)));
+  buf[9] = (unsigned char)(128 - buf[8]);
+  ASSERT(fixedpoint_decode(buf, size, decoded));
+  free(buf);
+  free(decoded);
+
+  // around zero
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = fixedpoint_create2(0, (i * 0x2545F4914F6CDD1DUL) >> 20);
+    if (i % 3 == 0)
+    {
+      vals[i] = fixedpoint_negate(vals[i]);
+    }
+  }
+  check_codec(vals, n);
+
+  // all negative, all equal, and the widest distances
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = fixedpoint_negate(fixedpoint_create2(i * 0x9E3779B97F4A7C15UL, i * 0x2545F4914F6CDD1DUL));
+  }
+  check_codec(vals, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = objs->large1;
+  }
+  ASSERT(check_codec(vals, n) < 200);
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = fixedpoint_create2(i * 0x9E3779B97F4A7C15UL, i * 0x2545F4914F6CDD1DUL);
+  }
+  vals[5] = objs->zero;
+  vals[6] = objs->max;
+  check_codec(vals, n);
+
+  // blocks which are stored as is
+  vals[7] = fixedpoint_negate(objs->max);
+  vals[300] = fixedpoint_create_from_hex("x");
+  check_codec(vals, 301);
+
+  // small and empty arrays
+  check_codec(vals, 1);
+  check_codec(vals, 0);
+
+  free(vals);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_dict(TestObjs *objs)
+{
+  size_t n = 5000;
+  Fixedpoint *vals = malloc(n * sizeof(Fixedpoint));
+  Fixedpoint *decoded = malloc(n * sizeof(Fixedpoint));
+  uint32_t *codes = malloc(n * sizeof(uint32_t));
+  size_t *rows = malloc(n * sizeof(size_t));
+
+  // 200 distinct prices between -50 and 49.5
+  for (size_t i = 0; i < n; i++)
+  {
+    size_t k = (i * 7919) % 200;
+    vals[i] = fixedpoint_halve(fixedpoint_create(k));
+    vals[i] = fixedpoint_sub(vals[i], fixedpoint_create(50UL));
+  }
+  FixedpointDict *dict = fixedpoint_dict_build(vals, n, codes);
+  ASSERT(dict != NULL);
+  ASSERT(200 == fixedpoint_dict_size(dict));
+
+  // sorted, and the codes decode to the column
+  const Fixedpoint *dvals = fixedpoint_dict_values(dict);
+  for (size_t d = 1; d < 200; d++)
+  {
+    ASSERT(fixedpoint_compare(dvals[d - 1], dvals[d]) < 0);
+  }
+  fixedpoint_dict_decode(dict, codes, decoded, n);
+  for (size_t i = 0; i < n; i++)
+  {
+    ASSERT(0 == fixedpoint_compare(decoded[i], vals[i]));
+    ASSERT((codes[i] < codes[0]) == (fixedpoint_compare(vals[i], vals[0]) < 0));
+  }
+
+  uint32_t code;
+  ASSERT(fixedpoint_dict_lookup(dict, fixedpoint_negate(objs->one_half), &code));
+  ASSERT(0 == fixedpoint_compare(dvals[code], fixedpoint_negate(objs->one_half)));
+  ASSERT(!fixedpoint_dict_lookup(dict, objs->one_fourth, &code));
+  ASSERT(0 == fixedpoint_dict_lower_bound(dict, fixedpoint_negate(objs->max)));
+  ASSERT(200 == fixedpoint_dict_lower_bound(dict, fixedpoint_create(50UL)));
+
+  // 0 <= v < 10
+  size_t count = fixedpoint_dict_select_range(dict, codes, n, objs->zero, fixedpoint_create(10UL), rows);
+  size_t expected = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    if (fixedpoint_compare(vals[i], objs->zero) >= 0 && fixedpoint_compare(vals[i], fixedpoint_create(10UL)) < 0)
+    {
+      ASSERT(expected < count && rows[expected] == i);
+      expected++;
+    }
+  }
+  ASSERT(count == expected);
+  ASSERT(0 == fixedpoint_dict_select_range(dict, codes, n, objs->one, objs->zero, rows));
+
+  fixedpoint_scan_inclusive_n(vals, decoded, n, 1);
+  ASSERT(0 == fixedpoint_compare(fixedpoint_dict_sum(dict, codes, n), decoded[n - 1]));
+  fixedpoint_dict_destroy(dict);
+
+  // zero and negative zero are the same value, and sums are exact
+  Fixedpoint few[4] = {objs->max, objs->zero, fixedpoint_negate(objs->zero), objs->max};
+  dict = fixedpoint_dict_build(few, 4, codes);
+  ASSERT(2 == fixedpoint_dict_size(dict));
+  ASSERT(codes[1] == 0 && codes[2] == 0 && codes[3] == 1);
+  ASSERT(fixedpoint_is_overflow_pos(fixedpoint_dict_sum(dict, codes, 4)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_dict_sum(dict, codes, 3), objs->max));
+  fixedpoint_dict_destroy(dict);
+
+  few[2] = fixedpoint_create_from_hex("x");
+  ASSERT(NULL == fixedpoint_dict_build(few, 4, codes));
+  dict = fixedpoint_dict_build(few, 0, NULL);
+  ASSERT(0 == fixedpoint_dict_size(dict));
+  fixedpoint_dict_destroy(dict);
+
+  free(vals);
+  free(decoded);
+  free(codes);
+  free(rows);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_arena(TestObjs *objs)
+{
+  Fixedpoint vals[6] = {objs->zero, objs->one_half, fixedpoint_negate(objs->one_fourth), objs->large1,
+                        objs->max, fixedpoint_negate(objs->max)};
+  FixedpointArena *arena = fixedpoint_arena_create(0);
+  char *strs[6];
+  size_t used = 0;
+
+  for (int i = 0; i < 6; i++)
+  {
+    strs[i] = fixedpoint_format_as_hex_arena(vals[i], arena);
+    char *expected = fixedpoint_format_as_hex(vals[i]);
+    ASSERT(0 == strcmp(strs[i], expected));
+    used += strlen(expected) + 1;
+    free(expected);
+  }
+  // strings are packed, and earlier ones are intact
+  ASSERT(used == fixedpoint_arena_used(arena));
+  ASSERT(strs[1] == strs[0] + 2);
+  ASSERT(0 == strcmp(strs[0], "0"));
+  ASSERT(0 == strcmp(strs[2], "-0.4"));
+  fixedpoint_arena_reset(arena);
+  ASSERT(0 == fixedpoint_arena_used(arena));
+  ASSERT(strs[0] == fixedpoint_format_as_hex_arena(objs->one, arena));
+  fixedpoint_arena_destroy(arena);
+
+  // chunks smaller than some strings
+  arena = fixedpoint_arena_create(16);
+  for (int round = 0; round < 2; round++)
+  {
+    for (int i = 0; i < 100; i++)
+    {
+      strs[i % 6] = fixedpoint_format_as_hex_arena(vals[i % 6], arena);
+      ASSERT(strs[i % 6] != NULL);
+    }
+    ASSERT(0 == strcmp(strs[4], "ffffffffffffffff.ffffffffffffffff"));
+    ASSERT(0 == strcmp(strs[5], "-ffffffffffffffff.ffffffffffffffff"));
+    fixedpoint_arena_reset(arena);
+  }
+  fixedpoint_arena_destroy(arena);
+
+  char buf[8];
+  ASSERT(33 == fixedpoint_format_as_hex_buf(objs->max, buf, sizeof(buf)));
+  ASSERT(0 == strcmp(buf, "fffffff"));
+}
+
+static void *format_in_local_arena(void *arg)
+{
+  const Fixedpoint *val = arg;
+  FixedpointArena *arena = fixedpoint_arena_local();
+  if (arena != fixedpoint_arena_local())
+  {
+    return NULL;
+  }
+  char *last = NULL;
+  for (int i = 0; i < 10000; i++)
+  {
+    last = fixedpoint_format_as_hex_arena(*val, arena);
+  }
+  // the arena is freed when the thread exits, so return a copy
+  return strdup(last);
+}
+
+void test_arena_local(TestObjs *objs)
+{
+  Fixedpoint vals[4] = {objs->one, objs->one_half, objs->large1, objs->max};
+  pthread_t threads[4];
+
+  for (int i = 0; i < 4; i++)
+  {
+    ASSERT(0 == pthread_create(&threads[i], NULL, format_in_local_arena, &vals[i]));
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    void *str;
+    pthread_join(threads[i], &str);
+    char *expected = fixedpoint_format_as_hex(vals[i]);
+    ASSERT(str != NULL && 0 == strcmp(str, expected));
+    free(expected);
+    free(str);
+  }
+  ASSERT(fixedpoint_arena_local() != NULL);
+}
+
+static void *count_adds(void *arg)
+{
+  const Fixedpoint *max = arg;
+  for (int i = 0; i < 1000; i++)
+  {
+    fixedpoint_add(*max, *max);
+  }
+  return NULL;
+}
+
+void test_stats(TestObjs *objs)
+{
+  FixedpointStats before, after;
+  fixedpoint_stats_snapshot(&before);
+
+  fixedpoint_add(objs->one, objs->one_half);
+  fixedpoint_add(objs->max, objs->one);
+  fixedpoint_sub(fixedpoint_negate(objs->max), objs->one);
+  fixedpoint_halve(objs->one);
+  fixedpoint_halve(fixedpoint_create_from_hex("0.0000000000000001"));
+  fixedpoint_create_from_hex("xyz");
+  fixedpoint_compare(objs->one, objs->zero);
+  free(fixedpoint_format_as_hex(objs->one));
+  // counts of threads which have exited are kept
+  pthread_t thread;
+  ASSERT(0 == pthread_create(&thread, NULL, count_adds, &objs->max));
+  pthread_join(thread, NULL);
+
+  fixedpoint_stats_snapshot(&after);
+  uint64_t scale = fixedpoint_stats_enabled() ? 1 : 0;
+  ASSERT(after.calls[FIXEDPOINT_OP_ADD] - before.calls[FIXEDPOINT_OP_ADD] == 1002 * scale);
+  ASSERT(after.overflows[FIXEDPOINT_OP_ADD] - before.overflows[FIXEDPOINT_OP_ADD] == 1001 * scale);
+  ASSERT(after.calls[FIXEDPOINT_OP_SUB] - before.calls[FIXEDPOINT_OP_SUB] == 1 * scale);
+  ASSERT(after.overflows[FIXEDPOINT_OP_SUB] - before.overflows[FIXEDPOINT_OP_SUB] == 1 * scale);
+  ASSERT(after.calls[FIXEDPOINT_OP_NEGATE] - before.calls[FIXEDPOINT_OP_NEGATE] == 1 * scale);
+  ASSERT(after.calls[FIXEDPOINT_OP_HALVE] - before.calls[FIXEDPOINT_OP_HALVE] == 2 * scale);
+  ASSERT(after.underflows[FIXEDPOINT_OP_HALVE] - before.underflows[FIXEDPOINT_OP_HALVE] == 1 * scale);
+  ASSERT(after.calls[FIXEDPOINT_OP_CREATE_FROM_HEX] - before.calls[FIXEDPOINT_OP_CREATE_FROM_HEX] == 2 * scale);
+  ASSERT(after.errors[FIXEDPOINT_OP_CREATE_FROM_HEX] - before.errors[FIXEDPOINT_OP_CREATE_FROM_HEX] == 1 * scale);
+  ASSERT(after.calls[FIXEDPOINT_OP_COMPARE] - before.calls[FIXEDPOINT_OP_COMPARE] == 1 * scale);
+  ASSERT(after.calls[FIXEDPOINT_OP_FORMAT_AS_HEX] - before.calls[FIXEDPOINT_OP_FORMAT_AS_HEX] == 1 * scale);
+  ASSERT(after.calls[FIXEDPOINT_OP_MUL] == before.calls[FIXEDPOINT_OP_MUL]);
+
+  char *text;
+  size_t len;
+  FILE *out = open_memstream(&text, &len);
+  fixedpoint_stats_write_json(&after, out);
+  fclose(out);
+  ASSERT(NULL != strstr(text, "\"halve\": {\"calls\": "));
+  ASSERT('}' == text[len - 2]);
+  free(text);
+
+  out = open_memstream(&text, &len);
+  fixedpoint_stats_write_text(&after, out);
+  fclose(out);
+  ASSERT(0 == strncmp(text, "operation", 9));
+  ASSERT(scale == (NULL != strstr(text, "\nadd ")));
+  free(text);
+  ASSERT(0 == strcmp("format_as_dec", fixedpoint_stats_op_name(FIXEDPOINT_OP_FORMAT_AS_DEC)));
+}
+
+void test_trace(TestObjs *objs)
+{
+  FixedpointTraceEvent events[8];
+
+  // nothing is recorded before tracing starts
+  fixedpoint_add(objs->max, objs->one);
+  ASSERT(1 == fixedpoint_trace_start(4));
+  ASSERT(0 == fixedpoint_trace_read(events, 8));
+
+  // the probes fire on exceptional paths only
+  fixedpoint_create_from_hex("1.8");
+  fixedpoint_add(objs->one, objs->one_half);
+  fixedpoint_halve(objs->one);
+  ASSERT(0 == fixedpoint_trace_read(events, 8));
+  fixedpoint_create_from_hex("12.3g");
+  fixedpoint_add(objs->max, objs->one);
+  fixedpoint_sub(fixedpoint_negate(objs->max), objs->one_half);
+  fixedpoint_halve(fixedpoint_negate(fixedpoint_create2(0UL, 3UL)));
+  ASSERT(4 == fixedpoint_trace_read(events, 8));
+
+  ASSERT(FIXEDPOINT_PROBE_HEX_INVALID == events[0].probe);
+  ASSERT(2 == events[0].tag);
+  ASSERT(0 == strcmp(events[0].text, "12.3g"));
+  ASSERT(FIXEDPOINT_PROBE_ADD_OVERFLOW == events[1].probe);
+  ASSERT(4 == events[1].tag);
+  ASSERT(0 == fixedpoint_compare(events[1].left, objs->max));
+  ASSERT(0 == fixedpoint_compare(events[1].right, objs->one));
+  ASSERT(0 == strcmp(events[1].text, ""));
+  ASSERT(FIXEDPOINT_PROBE_SUB_OVERFLOW == events[2].probe);
+  ASSERT(3 == events[2].tag);
+  ASSERT(0 == fixedpoint_compare(events[2].right, objs->one_half));
+  ASSERT(FIXEDPOINT_PROBE_HALVE_UNDERFLOW == events[3].probe);
+  ASSERT(5 == events[3].tag);
+  ASSERT(0 == fixedpoint_compare(events[3].left, fixedpoint_negate(fixedpoint_create2(0UL, 3UL))));
+
+  // a full buffer keeps the newest events; long strings are truncated
+  for (int i = 0; i < 6; i++)
+  {
+    fixedpoint_format_as_hex_buf(fixedpoint_create_from_hex("x"), (char *)events, 1);
+  }
+  fixedpoint_create_from_hex("0123456789abcdef0123456789abcdef0123456789abcdef");
+  ASSERT(9 == fixedpoint_trace_lost());
+  ASSERT(4 == fixedpoint_trace_read(events, 8));
+  ASSERT(FIXEDPOINT_PROBE_FORMAT_INVALID == events[2].probe);
+  ASSERT(2 == events[2].tag);
+  ASSERT(FIXEDPOINT_PROBE_HEX_INVALID == events[3].probe);
+  ASSERT(FIXEDPOINT_TRACE_TEXT_SIZE - 1 == strlen(events[3].text));
+  ASSERT(0 == strcmp(fixedpoint_trace_probe_name(events[3].probe), "hex_invalid"));
+
+  fixedpoint_trace_stop();
+  fixedpoint_halve(fixedpoint_negate(fixedpoint_create2(0UL, 3UL)));
+  ASSERT(0 == fixedpoint_trace_read(events, 8));
+  ASSERT(0 == fixedpoint_trace_start(0));
+}
+
+static int hook_calls[FIXEDPOINT_NUM_PROBES];
+
+static void count_probes(const FixedpointTraceEvent *event)
+{
+  hook_calls[event->probe]++;
+}
+
+void test_trace_hook(TestObjs *objs)
+{
+  memset(hook_calls, 0, sizeof(hook_calls));
+  fixedpoint_trace_set_hook(count_probes);
+  for (int i = 0; i < 100; i++)
+  {
+    fixedpoint_add(objs->max, objs->max);
+    fixedpoint_add(objs->max, fixedpoint_negate(objs->max));
+  }
+  // batch operations go through the same probes
+  Fixedpoint vals[4] = {objs->one, fixedpoint_create2(0UL, 1UL), objs->one_half, fixedpoint_create2(3UL, 3UL)};
+  Fixedpoint out[4];
+  fixedpoint_halve_n(vals, out, 4);
+  fixedpoint_trace_set_hook(NULL);
+  fixedpoint_add(objs->max, objs->max);
+
+  ASSERT(100 == hook_calls[FIXEDPOINT_PROBE_ADD_OVERFLOW]);
+  ASSERT(0 == hook_calls[FIXEDPOINT_PROBE_SUB_OVERFLOW]);
+  ASSERT(2 == hook_calls[FIXEDPOINT_PROBE_HALVE_UNDERFLOW]);
+}
+
+void test_atomic(TestObjs *objs)
+{
+  Fixedpoint half_max = fixedpoint_create2(0x7fffffffffffffffUL, 0xffffffffffffffffUL);
+  Fixedpoint least = fixedpoint_create2(0UL, 1UL);
+
+  // totals must be in the packed range
+  ASSERT(NULL == fixedpoint_atomic_create(objs->max));
+  ASSERT(NULL == fixedpoint_atomic_create(fixedpoint_add(half_max, least)));
+  ASSERT(NULL == fixedpoint_atomic_create(fixedpoint_create_from_hex("x")));
+
+  FixedpointAtomic *acc = fixedpoint_atomic_create(objs->one_half);
+  ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_load(acc), objs->one_half));
+  Fixedpoint total = fixedpoint_atomic_add(acc, objs->large1);
+  ASSERT(0 == fixedpoint_compare(total, fixedpoint_add(objs->one_half, objs->large1)));
+  total = fixedpoint_atomic_sub(acc, fixedpoint_double(objs->large1));
+  ASSERT(fixedpoint_is_neg(total));
+  ASSERT(0 == fixedpoint_compare(total, fixedpoint_sub(objs->one_half, objs->large1)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_load(acc), total));
+  fixedpoint_atomic_destroy(acc);
+
+  // overflows leave the total unchanged
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  acc = fixedpoint_atomic_create(half_max);
+  ASSERT(fixedpoint_is_overflow_pos(fixedpoint_atomic_add(acc, least)));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS));
+  ASSERT(fixedpoint_is_overflow_pos(fixedpoint_atomic_add(acc, objs->max)));
+  ASSERT(fixedpoint_is_err(fixedpoint_atomic_sub(acc, fixedpoint_create_from_hex("x"))));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_load(acc), half_max));
+  // the most negative total is one more than the most positive
+  total = fixedpoint_atomic_sub(acc, objs->max);
+  ASSERT(0 == fixedpoint_compare(total, fixedpoint_negate(fixedpoint_add(half_max, least))));
+  ASSERT(fixedpoint_is_overflow_neg(fixedpoint_atomic_sub(acc, least)));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_add(acc, fixedpoint_add(half_max, least)), objs->zero));
+  fixedpoint_atomic_destroy(acc);
+
+  FixedpointShardedSum *sum = fixedpoint_sharded_create(3);
+  ASSERT(0 == fixedpoint_sharded_add(sum, objs->large1));
+  ASSERT(0 == fixedpoint_sharded_sub(sum, objs->one_fourth));
+  ASSERT(2 == fixedpoint_sharded_add(sum, fixedpoint_create_from_hex("x")));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_sharded_load(sum), fixedpoint_sub(objs->large1, objs->one_fourth)));
+  fixedpoint_sharded_destroy(sum);
+}
+
+typedef struct
+{
+  FixedpointAtomic *acc;
+  FixedpointShardedSum *sum;
+  Fixedpoint val;
+} AtomicArg;
+
+static void *add_atomically(void *arg)
+{
+  AtomicArg *a = arg;
+  for (int i = 0; i < 20000; i++)
+  {
+    fixedpoint_atomic_add(a->acc, a->val);
+    fixedpoint_sharded_sub(a->sum, a->val);
+  }
+  return NULL;
+}
+
+void test_atomic_threads(TestObjs *objs)
+{
+  AtomicArg args[4];
+  pthread_t threads[4];
+  Fixedpoint expected = objs->zero;
+  FixedpointAtomic *acc = fixedpoint_atomic_create(objs->zero);
+  FixedpointShardedSum *sum = fixedpoint_sharded_create(0);
+
+  for (int i = 0; i < 4; i++)
+  {
+    args[i].acc = acc;
+    args[i].sum = sum;
+    // carries between the fraction and whole parts in both directions
+    args[i].val = fixedpoint_create2(i, 0xc000000000000001UL);
+    args[i].val.tag = i & 1;
+    for (int j = 0; j < 20000; j++)
+    {
+      expected = fixedpoint_add(expected, args[i].val);
+    }
+    ASSERT(0 == pthread_create(&threads[i], NULL, add_atomically, &args[i]));
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+  ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_load(acc), expected));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_sharded_load(sum), fixedpoint_negate(expected)));
+  fixedpoint_atomic_destroy(acc);
+  fixedpoint_sharded_destroy(sum);
+}
+
+typedef struct
+{
+  FixedpointAtomic *acc;
+  Fixedpoint val;
+  int failures;
+} AtomicEdgeArg;
+
+// add a value and take it away again, many times
+static void *add_and_undo(void *arg)
+{
+  AtomicEdgeArg *a = arg;
+  for (int i = 0; i < 100000; i++)
+  {
+    a->failures += !fixedpoint_is_valid(fixedpoint_atomic_add(a->acc, a->val));
+    a->failures += !fixedpoint_is_valid(fixedpoint_atomic_sub(a->acc, a->val));
+  }
+  return NULL;
+}
+
+void test_atomic_edge(TestObjs *objs)
+{
+  (void)objs;
+  Fixedpoint half_max = fixedpoint_create2(0x7fffffffffffffffUL, 0xffffffffffffffffUL);
+  Fixedpoint least = fixedpoint_create2(0UL, 1UL);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+  // totals moving across 2^63 - 1 and -(2^63 - 1), where a torn read can
+  // look like a total at the edge of the range; no update overflows
+  for (int side = 0; side < 2; side++)
+  {
+    Fixedpoint edge = fixedpoint_create(0x7fffffffffffffffUL);
+    Fixedpoint initial = side ? fixedpoint_negate(edge) : fixedpoint_sub(edge, least);
+    FixedpointAtomic *acc = fixedpoint_atomic_create(initial);
+    AtomicEdgeArg args[4];
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++)
+    {
+      args[i].acc = acc;
+      args[i].val = side ? fixedpoint_negate(least) : least;
+      args[i].failures = 0;
+      ASSERT(0 == pthread_create(&threads[i], NULL, add_and_undo, &args[i]));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+      pthread_join(threads[i], NULL);
+      ASSERT(0 == args[i].failures);
+    }
+    ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_load(acc), initial));
+    ASSERT(!fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+
+    // right up to the edge, and then one step past it
+    Fixedpoint limit = side ? fixedpoint_negate(fixedpoint_add(half_max, least)) : half_max;
+    ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_add(acc, fixedpoint_sub(limit, initial)), limit));
+    Fixedpoint past = fixedpoint_atomic_add(acc, args[0].val);
+    ASSERT(side ? fixedpoint_is_overflow_neg(past) : fixedpoint_is_overflow_pos(past));
+    ASSERT(0 == fixedpoint_compare(fixedpoint_atomic_load(acc), limit));
+    fixedpoint_atomic_destroy(acc);
+    fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  }
+}
+
+// pipeline transform: v -> (v + 1) / 2
+static void add_one_and_halve(Fixedpoint *vals, size_t n, void *ctx)
+{
+  const Fixedpoint *one = ctx;
+  for (size_t i = 0; i < n; i++)
+  {
+    vals[i] = fixedpoint_halve(fixedpoint_add(vals[i], *one));
+  }
+}
+
+typedef struct
+{
+  char *text;
+  size_t len;
+  size_t calls;
+} PipelineOutput;
+
+static void append_output(const char *text, size_t len, void *ctx)
+{
+  PipelineOutput *out = ctx;
+  memcpy(out->text + out->len, text, len);
+  out->len += len;
+  out->calls++;
+}
+
+void test_pipeline(TestObjs *objs)
+{
+  enum { NUM_LINES = 5000 };
+  char **lines = malloc(NUM_LINES * sizeof(char *));
+  char *expected = malloc(NUM_LINES * FIXEDPOINT_HEX_BUF_SIZE);
+  size_t expected_len = 0;
+  uint64_t state = 12345;
+
+  for (int i = 0; i < NUM_LINES; i++)
+  {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    Fixedpoint val = fixedpoint_create2(state >> 40, state | 1);
+    val.tag = (int)(state >> 63);
+    lines[i] = (i % 97 == 5) ? strdup("1.2.3") : fixedpoint_format_as_hex(val);
+    Fixedpoint result = fixedpoint_halve(fixedpoint_add(fixedpoint_create_from_hex(lines[i]), objs->one));
+    expected_len += fixedpoint_format_as_hex_buf(result, expected + expected_len, FIXEDPOINT_HEX_BUF_SIZE);
+    expected[expected_len++] = '\n';
+  }
+
+  FixedpointPipelineConfig configs[4] = {
+      {0, 0, 0, 0, 0},
+      {2, 3, 2, 7, 0},
+      {3, 1, 3, 64, 1},
+      {1, 4, 1, 500, 3},
+  };
+  for (int c = -1; c < 4; c++)
+  {
+    PipelineOutput out = {malloc(NUM_LINES * FIXEDPOINT_HEX_BUF_SIZE), 0, 0};
+    fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+    ASSERT(1 == fixedpoint_pipeline_run((const char *const *)lines, NUM_LINES, add_one_and_halve, &objs->one,
+                                        append_output, &out, c < 0 ? NULL : &configs[c]));
+    ASSERT(out.len == expected_len);
+    ASSERT(0 == memcmp(out.text, expected, expected_len));
+    size_t batch_size = (c < 0 || configs[c].batch_size == 0) ? FIXEDPOINT_PIPELINE_BATCH_SIZE : configs[c].batch_size;
+    ASSERT(out.calls == (NUM_LINES + batch_size - 1) / batch_size);
+    // flags raised in the stage threads reach the caller
+    ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+    ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_UNDERFLOW_POS | FIXEDPOINT_STATUS_UNDERFLOW_NEG));
+    free(out.text);
+  }
+
+  // no transform, and no lines
+  PipelineOutput out = {malloc(64), 0, 0};
+  const char *two[2] = {"-1.8", "ff"};
+  ASSERT(1 == fixedpoint_pipeline_run(two, 2, NULL, NULL, append_output, &out, NULL));
+  ASSERT(out.len == 8 && 0 == memcmp(out.text, "-1.8\nff\n", 8));
+  ASSERT(1 == fixedpoint_pipeline_run(two, 0, NULL, NULL, append_output, &out, NULL));
+  ASSERT(out.calls == 1);
+  free(out.text);
+
+  for (int i = 0; i < NUM_LINES; i++)
+  {
+    free(lines[i]);
+  }
+  free(lines);
+  free(expected);
+}
+
+static void *run_server(void *arg)
+{
+  return (void *)(intptr_t)fixedpoint_server_run(arg);
+}
+
+typedef struct
+{
+  const char *path;
+  FixedpointServiceOp *ops;
+  uint32_t count;
+  int ok;
+} ServiceClientArg;
+
+// Call the server repeatedly, checking every result
+static void *call_server(void *arg)
+{
+  ServiceClientArg *a = arg;
+  Fixedpoint *results = malloc(a->count * sizeof(Fixedpoint));
+  FixedpointClient *client = fixedpoint_client_connect(a->path);
+  a->ok = client != NULL;
+  for (int r = 0; a->ok && r < 50; r++)
+  {
+    a->ok = fixedpoint_client_call(client, a->ops, results, a->count);
+    for (uint32_t i = 0; a->ok && i < a->count; i++)
+    {
+      Fixedpoint expected = fixedpoint_service_apply(&a->ops[i]);
+      a->ok = expected.integer == results[i].integer && expected.fraction == results[i].fraction &&
+              expected.tag == results[i].tag;
+    }
+  }
+  fixedpoint_client_close(client);
+  free(results);
+  return NULL;
+}
+
+void test_service(TestObjs *objs)
+{
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/fixedpoint_tests_%d.sock", (int)getpid());
+  FixedpointServer *server = fixedpoint_server_create(path, 2);
+  ASSERT(server != NULL);
+  pthread_t server_thread;
+  ASSERT(0 == pthread_create(&server_thread, NULL, run_server, server));
+
+  // one of each operation
+  Fixedpoint bad = fixedpoint_create_from_hex("x");
+  FixedpointServiceOp ops[10] = {
+      {FIXEDPOINT_SERVICE_ADD, 0, objs->one, objs->one_half},
+      {FIXEDPOINT_SERVICE_SUB, 0, objs->one_fourth, objs->large1},
+      {FIXEDPOINT_SERVICE_MUL, FIXEDPOINT_ROUND_NEAREST_EVEN, objs->large1, objs->large2},
+      {FIXEDPOINT_SERVICE_DIV, FIXEDPOINT_ROUND_FLOOR, fixedpoint_negate(objs->one), objs->large2},
+      {FIXEDPOINT_SERVICE_NEGATE, 0, objs->large1, objs->zero},
+      {FIXEDPOINT_SERVICE_HALVE, 0, fixedpoint_create2(0UL, 1UL), objs->zero},
+      {FIXEDPOINT_SERVICE_DOUBLE, 0, objs->max, objs->zero},
+      {FIXEDPOINT_SERVICE_COMPARE, 0, objs->one_fourth, objs->one_half},
+      {FIXEDPOINT_SERVICE_ADD, 0, bad, objs->one},
+      {99, 0, objs->one, objs->one},
+  };
+  Fixedpoint results[10];
+  FixedpointClient *client = fixedpoint_client_connect(path);
+  ASSERT(client != NULL);
+  ASSERT(1 == fixedpoint_client_call(client, ops, results, 10));
+  ASSERT(0 == fixedpoint_compare(results[0], fixedpoint_create_from_hex("1.8")));
+  ASSERT(0 == fixedpoint_compare(results[1], fixedpoint_sub(objs->one_fourth, objs->large1)));
+  ASSERT(0 == fixedpoint_compare(results[2], fixedpoint_mul_round(objs->large1, objs->large2, FIXEDPOINT_ROUND_NEAREST_EVEN)));
+  ASSERT(0 == fixedpoint_compare(results[3], fixedpoint_div_round(fixedpoint_negate(objs->one), objs->large2, FIXEDPOINT_ROUND_FLOOR)));
+  ASSERT(0 == fixedpoint_compare(results[4], fixedpoint_negate(objs->large1)));
+  ASSERT(fixedpoint_is_underflow_pos(results[5]));
+  ASSERT(fixedpoint_is_overflow_pos(results[6]));
+  ASSERT(0 == fixedpoint_compare(results[7], fixedpoint_negate(objs->one)));
+  ASSERT(fixedpoint_is_err(results[8]));
+  ASSERT(fixedpoint_is_err(results[9]));
+  ASSERT(1 == fixedpoint_client_call(client, ops, results, 0));
+
+  // operands which aren't valid, and unknown rounding modes, give errors
+  // rather than valid-looking results; unary operations ignore right
+  Fixedpoint five_err = fixedpoint_create(5UL);
+  five_err.tag = 2;
+  Fixedpoint overflow = fixedpoint_double(objs->max);
+  Fixedpoint underflow = fixedpoint_halve(fixedpoint_create2(0UL, 1UL));
+  FixedpointServiceOp invalid_ops[7] = {
+      {FIXEDPOINT_SERVICE_MUL, FIXEDPOINT_ROUND_EXACT, five_err, objs->one},
+      {FIXEDPOINT_SERVICE_DIV, FIXEDPOINT_ROUND_EXACT, objs->one, overflow},
+      {FIXEDPOINT_SERVICE_NEGATE, 0, five_err, objs->zero},
+      {FIXEDPOINT_SERVICE_COMPARE, 0, underflow, objs->one},
+      {FIXEDPOINT_SERVICE_MUL, FIXEDPOINT_ROUND_CEIL + 1, objs->one, objs->one},
+      {FIXEDPOINT_SERVICE_DIV, 255, objs->one, objs->one},
+      {FIXEDPOINT_SERVICE_NEGATE, 0, objs->one, five_err},
+  };
+  ASSERT(1 == fixedpoint_client_call(client, invalid_ops, results, 7));
+  for (int i = 0; i < 6; i++)
+  {
+    ASSERT(fixedpoint_is_err(results[i]));
+  }
+  ASSERT(0 == fixedpoint_compare(results[6], fixedpoint_negate(objs->one)));
+
+  // several clients at once, with large requests
+  enum { COUNT = 3000 };
+  FixedpointServiceOp *many = malloc(COUNT * sizeof(FixedpointServiceOp));
+  for (int i = 0; i < COUNT; i++)
+  {
+    many[i] = ops[i % 10];
+    many[i].left.fraction += (uint64_t)i;
+  }
+  ServiceClientArg args[3];
+  pthread_t threads[3];
+  for (int i = 0; i < 3; i++)
+  {
+    args[i].path = path;
+    args[i].ops = many + i;
+    args[i].count = COUNT - 2;
+    ASSERT(0 == pthread_create(&threads[i], NULL, call_server, &args[i]));
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    pthread_join(threads[i], NULL);
+    ASSERT(args[i].ok);
+  }
+  free(many);
+
+  // a malformed header closes the connection, without affecting others
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  ASSERT(0 == connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+  unsigned char header[FIXEDPOINT_SERVICE_HEADER_SIZE] = {5, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0};
+  ASSERT(sizeof(header) == write(fd, header, sizeof(header)));
+  ASSERT(0 == read(fd, header, sizeof(header)));
+  close(fd);
+  ASSERT(1 == fixedpoint_client_call(client, ops, results, 1));
+  fixedpoint_client_close(client);
+
+  ASSERT(fixedpoint_server_requests(server) == 3 + 3 * 50 + 1);
+  uint64_t median = fixedpoint_server_latency(server, 0.5);
+  ASSERT(median > 0 && median <= fixedpoint_server_latency(server, 0.99));
+
+  // a client which pipelines requests without reading the responses is
+  // stopped reading from once their total size is over the limit, rather
+  // than queueing work for it without bound
+  enum { PIPELINED_OPS = 4096 };
+  size_t request_len = FIXEDPOINT_SERVICE_HEADER_SIZE + PIPELINED_OPS * FIXEDPOINT_SERVICE_OP_SIZE;
+  unsigned char *request = calloc(1, request_len);
+  request[0] = (unsigned char)(PIPELINED_OPS * FIXEDPOINT_SERVICE_OP_SIZE);
+  request[1] = (unsigned char)(PIPELINED_OPS * FIXEDPOINT_SERVICE_OP_SIZE >> 8);
+  request[2] = (unsigned char)(PIPELINED_OPS * FIXEDPOINT_SERVICE_OP_SIZE >> 16);
+  request[9] = PIPELINED_OPS >> 8;
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT(0 == connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+  size_t sent = 0;
+  while (sent < ((size_t)64 << 20))
+  {
+    ssize_t n = send(fd, request + sent % request_len, request_len - sent % request_len, MSG_DONTWAIT);
+    if (n > 0)
+    {
+      sent += (size_t)n;
+      continue;
+    }
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    if (poll(&pfd, 1, 500) == 0)
+    {
+      break;
+    }
+  }
+  ASSERT(sent < ((size_t)16 << 20));
+  close(fd);
+  free(request);
+  client = fixedpoint_client_connect(path);
+  ASSERT(client != NULL);
+  ASSERT(1 == fixedpoint_client_call(client, ops, results, 1));
+  ASSERT(0 == fixedpoint_compare(results[0], fixedpoint_create_from_hex("1.8")));
+  fixedpoint_client_close(client);
+
+  fixedpoint_server_stop(server);
+  void *ok;
+  pthread_join(server_thread, &ok);
+  ASSERT(ok == (void *)1);
+  fixedpoint_server_destroy(server);
+  ASSERT(NULL == fixedpoint_client_connect(path));
+}
+
+// the values of each chunk, collected by collect_chunk
+typedef struct
+{
+  pthread_mutex_t lock;
+  Fixedpoint **vals;
+  size_t *counts;
+  size_t num_chunks;
+  int bad;
+} IngestChunks;
+
+static void collect_chunk(const Fixedpoint *vals, size_t n, uint64_t chunk, void *ctx)
+{
+  IngestChunks *chunks = ctx;
+  pthread_mutex_lock(&chunks->lock);
+  if (chunk >= chunks->num_chunks || chunks->vals[chunk])
+  {
+    chunks->bad = 1;
+  }
+  else
+  {
+    chunks->vals[chunk] = malloc(n * sizeof(Fixedpoint));
+    memcpy(chunks->vals[chunk], vals, n * sizeof(Fixedpoint));
+    chunks->counts[chunk] = n;
+  }
+  pthread_mutex_unlock(&chunks->lock);
+}
+
+typedef struct
+{
+  const char *path;
+  size_t size;
+  int calls;
+  int truncated;
+} ShrinkFile;
+
+// ingestion sink which truncates the file being read, the first time
+static void shrink_file(const Fixedpoint *vals, size_t n, uint64_t chunk, void *ctx)
+{
+  (void)vals;
+  (void)n;
+  (void)chunk;
+  ShrinkFile *shrink = ctx;
+  if (shrink->calls++ == 0)
+  {
+    // this runs in a parser thread, so the test checks the result
+    shrink->truncated = truncate(shrink->path, (off_t)shrink->size) == 0;
+  }
+}
+
+void test_ingest(TestObjs *objs)
+{
+  (void)objs;
+  // lines of every length, with some longer than a chunk, and the last
+  // without a newline
+  static const char *lines[] = {"0", "1.8", "-f.f", "", "ffffffffffffffff.ffffffffffffffff", "1.2.3",
+                                "-0000000000000001.0000000000000001", "x",
+                                "1234567890abcdef1234567890abcdef1234567890abcdef1234567890abcdef1234567890abcdef",
+                                "a", "-.", "DEADBEEF.CAFE", "10000000000000000"};
+  size_t num_lines = sizeof(lines) / sizeof(lines[0]);
+  size_t repeats = 300;
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/fixedpoint_tests_%d.hex", (int)getpid());
+  FILE *out = fopen(path, "w");
+  ASSERT(out != NULL);
+  size_t expected_invalid = 0;
+  for (size_t r = 0; r < repeats; r++)
+  {
+    for (size_t i = 0; i < num_lines; i++)
+    {
+      int last = r == repeats - 1 && i == num_lines - 1;
+      fprintf(out, last ? "%s" : "%s\n", lines[i]);
+      expected_invalid += fixedpoint_is_err(fixedpoint_create_from_hex(lines[i])) != 0;
+    }
+  }
+  fclose(out);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+  static const int backends[] = {FIXEDPOINT_INGEST_AUTO, FIXEDPOINT_INGEST_PREAD};
+  static const size_t chunk_sizes[] = {1, 7, 64, 100, 4096, 0};
+  for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++)
+  {
+    for (size_t s = 0; s < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); s++)
+    {
+      FixedpointIngestConfig config = {backends[b], 3, 4, chunk_sizes[s]};
+      FixedpointIngestStats stats;
+      IngestChunks chunks;
+      pthread_mutex_init(&chunks.lock, NULL);
+      chunks.num_chunks = 100000;
+      chunks.vals = calloc(chunks.num_chunks, sizeof(Fixedpoint *));
+      chunks.counts = calloc(chunks.num_chunks, sizeof(size_t));
+      chunks.bad = 0;
+
+      ASSERT(1 == fixedpoint_ingest_file(path, collect_chunk, &chunks, &config, &stats));
+      ASSERT(!chunks.bad);
+      ASSERT(stats.values == repeats * num_lines);
+      ASSERT(stats.invalid == expected_invalid);
+      ASSERT(stats.bytes > 0 && stats.seconds > 0);
+      ASSERT(backends[b] == FIXEDPOINT_INGEST_AUTO || stats.backend == FIXEDPOINT_INGEST_PREAD);
+      // the parsers' status flags are raised in this thread
+      ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+      fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+      // in chunk order, the values are those of the lines
+      size_t line = 0;
+      for (size_t c = 0; c < chunks.num_chunks; c++)
+      {
+        for (size_t i = 0; i < chunks.counts[c]; i++, line++)
+        {
+          Fixedpoint expected = fixedpoint_create_from_hex(lines[line % num_lines]);
+          Fixedpoint val = chunks.vals[c][i];
+          ASSERT(val.integer == expected.integer && val.fraction == expected.fraction && val.tag == expected.tag);
+        }
+        free(chunks.vals[c]);
+      }
+      ASSERT(line == repeats * num_lines);
+      free(chunks.counts);
+      free(chunks.vals);
+      pthread_mutex_destroy(&chunks.lock);
+      fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+    }
+  }
+
+  // without a sink, the values are just counted
+  FixedpointIngestStats stats;
+  ASSERT(1 == fixedpoint_ingest_file(path, NULL, NULL, NULL, &stats));
+  ASSERT(stats.values == repeats * num_lines);
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+  // a file which shrinks while it is read gives the values of what was
+  // read, with later chunks reading nothing
+  static const size_t shrink_sizes[] = {0, 1000, 1001};
+  for (size_t i = 0; i < sizeof(shrink_sizes) / sizeof(shrink_sizes[0]); i++)
+  {
+    FixedpointIngestConfig config = {FIXEDPOINT_INGEST_PREAD, 1, 1, 64};
+    ShrinkFile shrink = {path, shrink_sizes[i], 0, 0};
+    ASSERT(1 == fixedpoint_ingest_file(path, shrink_file, &shrink, &config, &stats));
+    ASSERT(shrink.truncated);
+    ASSERT(stats.values < repeats * num_lines);
+    fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+    // put the file back
+    out = fopen(path, "w");
+    for (size_t r = 0; r < repeats; r++)
+    {
+      for (size_t j = 0; j < num_lines; j++)
+      {
+        fprintf(out, "%s\n", lines[j]);
+      }
+    }
+    fclose(out);
+  }
+
+  // an empty file has no values
+  out = fopen(path, "w");
+  fclose(out);
+  ASSERT(1 == fixedpoint_ingest_file(path, NULL, NULL, NULL, &stats));
+  ASSERT(stats.values == 0 && stats.bytes == 0);
+
+  unlink(path);
+  ASSERT(0 == fixedpoint_ingest_file(path, NULL, NULL, NULL, &stats));
+}
+
+void test_gemm(TestObjs *objs)
+{
+  Fixedpoint neg_one = fixedpoint_negate(objs->one);
+  Fixedpoint tiny = fixedpoint_create2(0UL, 1UL << 24); // 2^-40
+  Fixedpoint c[4];
+
+  // [1 1/2; -1 max] [1/4 1; 1 -1]: only the last element overflows
+  Fixedpoint a[4] = {objs->one, objs->one_half, neg_one, objs->max};
+  Fixedpoint b[4] = {objs->one_fourth, objs->one, objs->one, neg_one};
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  ASSERT(1 == fixedpoint_gemm(a, 2, b, 2, c, 2, 2, 2, 2, FIXEDPOINT_ROUND_EXACT, 1));
+  ASSERT(0 == fixedpoint_compare(c[0], fixedpoint_add(objs->one_fourth, objs->one_half)));
+  ASSERT(0 == fixedpoint_compare(c[1], objs->one_half));
+  ASSERT(0 == fixedpoint_compare(c[2], fixedpoint_sub(objs->max, objs->one_fourth)));
+  ASSERT(fixedpoint_is_overflow_neg(c[3]));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_NEG));
+  ASSERT(!fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_POS | FIXEDPOINT_STATUS_UNDERFLOW_POS));
+
+  // max + max - max is in range, though max + max isn't
+  Fixedpoint row[3] = {objs->max, objs->max, fixedpoint_negate(objs->max)};
+  Fixedpoint col[3] = {objs->one, objs->one, objs->one};
+  ASSERT(0 == fixedpoint_gemm(row, 3, col, 1, c, 1, 1, 1, 3, FIXEDPOINT_ROUND_EXACT, 1));
+  ASSERT(0 == fixedpoint_compare(c[0], objs->max));
+
+  // 2^-40 * 2^-40 - 2^-64 * 1 is rounded once, after the sum
+  Fixedpoint ulp = fixedpoint_create2(0UL, 1UL);
+  Fixedpoint x[2] = {tiny, ulp};
+  Fixedpoint y[2] = {tiny, neg_one};
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  ASSERT(1 == fixedpoint_gemm(x, 2, y, 1, c, 1, 1, 1, 2, FIXEDPOINT_ROUND_EXACT, 1));
+  ASSERT(fixedpoint_is_underflow_neg(c[0]));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_UNDERFLOW_NEG));
+  ASSERT(0 == fixedpoint_gemm(x, 2, y, 1, c, 1, 1, 1, 2, FIXEDPOINT_ROUND_NEAREST_EVEN, 1));
+  ASSERT(0 == fixedpoint_compare(c[0], fixedpoint_negate(ulp)));
+  ASSERT(0 == fixedpoint_gemm(x, 2, y, 1, c, 1, 1, 1, 2, FIXEDPOINT_ROUND_CEIL, 1));
+  ASSERT(fixedpoint_is_zero(c[0]));
+
+  // an invalid value makes its row's (or column's) results errors
+  Fixedpoint err = fixedpoint_create_from_hex("x");
+  Fixedpoint e[4] = {objs->one, err, objs->one, objs->one};
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  ASSERT(2 == fixedpoint_gemm(e, 2, b, 2, c, 2, 2, 2, 2, FIXEDPOINT_ROUND_EXACT, 2));
+  ASSERT(fixedpoint_is_err(c[0]) && fixedpoint_is_err(c[1]));
+  ASSERT(fixedpoint_is_valid(c[2]) && fixedpoint_is_valid(c[3]));
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+  // an empty inner dimension gives zeros
+  ASSERT(0 == fixedpoint_gemm(a, 0, b, 2, c, 2, 2, 2, 0, FIXEDPOINT_ROUND_EXACT, 1));
+  ASSERT(fixedpoint_is_zero(c[0]) && fixedpoint_is_zero(c[3]));
+}
+
+void test_gemm_blocks(TestObjs *objs)
+{
+  (void)objs;
+  // sizes which aren't multiples of the blocks, with values whose products
+  // and sums are exact, checked against fixedpoint_mul and fixedpoint_add
+  size_t m = 37, n = 45, k = 300;
+  size_t lda = k + 3, ldb = n + 1, ldc = n + 2;
+  Fixedpoint *a = malloc(m * lda * sizeof(Fixedpoint));
+  Fixedpoint *b = malloc(k * ldb * sizeof(Fixedpoint));
+  Fixedpoint *c = malloc(m * ldc * sizeof(Fixedpoint));
+  uint64_t state = 12345;
+  for (size_t i = 0; i < m * lda; i++)
+  {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    a[i] = fixedpoint_create2(state >> 52, (state >> 20 & 0xfff) << 52);
+    a[i].tag = (int)(state >> 19 & 1) && !fixedpoint_is_zero(a[i]);
+  }
+  for (size_t i = 0; i < k * ldb; i++)
+  {
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    b[i] = fixedpoint_create2(state >> 50, (state >> 20 & 0xfff) << 52);
+    b[i].tag = (int)(state >> 19 & 1) && !fixedpoint_is_zero(b[i]);
+  }
+
+  static const int threads[] = {1, 3, 0};
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++)
+  {
+    memset(c, 0, m * ldc * sizeof(Fixedpoint));
+    ASSERT(0 == fixedpoint_gemm(a, lda, b, ldb, c, ldc, m, n, k, FIXEDPOINT_ROUND_EXACT, threads[t]));
+    for (size_t i = 0; i < m; i++)
+    {
+      for (size_t j = 0; j < n; j++)
+      {
+        Fixedpoint sum = fixedpoint_create(0UL);
+        for (size_t p = 0; p < k; p++)
+        {
+          sum = fixedpoint_add(sum, fixedpoint_mul(a[i * lda + p], b[p * ldb + j]));
+        }
+        ASSERT(fixedpoint_is_valid(sum));
+        ASSERT(0 == fixedpoint_compare(c[i * ldc + j], sum));
+        ASSERT(c[i * ldc + j].tag == sum.tag);
+      }
+    }
+  }
+  ASSERT(!fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+  free(c);
+  free(b);
+  free(a);
+}
+
+void test_wide(TestObjs *objs)
+{
+  FixedpointWide a, b, r;
+  char buf[FIXEDPOINT_WIDE_HEX_BUF_SIZE];
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+  // 128.128: max + max carries into the second whole limb
+  fixedpoint_wide_from_fixedpoint(&a, objs->max, 2, 2);
+  fixedpoint_wide_add(&r, &a, &a);
+  ASSERT(r.tag == 0);
+  fixedpoint_wide_format_as_hex(&r, buf, sizeof(buf));
+  ASSERT(0 == strcmp(buf, "1ffffffffffffffff.fffffffffffffffe"));
+  fixedpoint_wide_sub(&r, &r, &a);
+  ASSERT(0 == fixedpoint_wide_compare(&r, &a));
+  ASSERT(0 == fixedpoint_compare(fixedpoint_wide_to_fixedpoint(&r), objs->max));
+  ASSERT(!fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+
+  // 192.64: the full width parses, formats and shifts
+  const char *hex = "-123456789abcdef0fedcba9876543210deadbeefcafef00d.8000000000000001";
+  fixedpoint_wide_from_hex(&a, hex, 3, 1);
+  ASSERT(a.tag == 1);
+  ASSERT(a.limb[0] == 0x8000000000000001UL && a.limb[3] == 0x123456789abcdef0UL);
+  ASSERT((int)strlen(hex) == fixedpoint_wide_format_as_hex(&a, buf, sizeof(buf)));
+  ASSERT(0 == strcmp(buf, hex));
+  fixedpoint_wide_shr(&r, &a, 1);
+  ASSERT(r.tag == 5);
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_UNDERFLOW_NEG));
+  fixedpoint_wide_shl(&r, &a, 4);
+  ASSERT(r.tag == 3);
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_OVERFLOW_NEG));
+  fixedpoint_wide_shl(&r, &a, 3);
+  ASSERT(r.tag == 1);
+  fixedpoint_wide_shr(&r, &r, 3);
+  ASSERT(0 == fixedpoint_wide_compare(&r, &a));
+  fixedpoint_wide_negate(&b, &a);
+  ASSERT(b.tag == 0 && 1 == fixedpoint_wide_compare(&b, &a));
+  fixedpoint_wide_add(&r, &a, &b);
+  ASSERT(r.tag == 0 && fixedpoint_wide_format_as_hex(&r, buf, sizeof(buf)) == 1 && buf[0] == '0');
+  fixedpoint_wide_from_hex(&r, "1123456789abcdef0fedcba9876543210deadbeefcafef00d", 3, 1);
+  ASSERT(r.tag == 2);
+  ASSERT(fixedpoint_wide_to_fixedpoint(&a).tag == 3);
+
+  // a size without specialized code (5.3), and overflow at the top limb
+  fixedpoint_wide_init(&a, 5, 3);
+  a.limb[7] = 1UL << 63;
+  fixedpoint_wide_add(&r, &a, &a);
+  ASSERT(r.tag == 4);
+  fixedpoint_wide_from_hex(&b, "0.000000000000000000000000000000000000000000001", 5, 3);
+  fixedpoint_wide_sub(&r, &a, &b);
+  ASSERT(r.tag == 0 && r.limb[0] == ~0UL << 12 && r.limb[7] == (1UL << 63) - 1);
+  ASSERT(-1 == fixedpoint_wide_compare(&r, &a));
+  ASSERT(fixedpoint_wide_to_fixedpoint(&b).tag == 6);
+
+  // operands must be valid, and of the same format
+  fixedpoint_wide_init(&b, 2, 2);
+  fixedpoint_wide_add(&r, &a, &b);
+  ASSERT(r.tag == 2);
+  fixedpoint_wide_init(&r, 9, 1);
+  ASSERT(r.tag == 2);
+  ASSERT(0 == fixedpoint_wide_format_as_hex(&r, buf, sizeof(buf)) && buf[0] == '\0');
+  ASSERT(fixedpoint_status_test(FIXEDPOINT_STATUS_ERR));
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+void test_wide_matches_fixedpoint(TestObjs *objs)
+{
+  (void)objs;
+  // with one limb in each part, the wide operations give the same results
+  // as the Fixedpoint ones, for random strings and values
+  static const char chars[] = "0123456789abcdefABCDEF.-x";
+  uint64_t state = 99;
+  for (int iter = 0; iter < 20000; iter++)
+  {
+    char hex[40];
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    int len = (int)(state >> 58) % 36;
+    for (int i = 0; i < len; i++)
+    {
+      state = state * 6364136223846793005UL + 1442695040888963407UL;
+      // mostly digits, sometimes a point, a sign or an invalid character
+      uint64_t r = state >> 40;
+      hex[i] = r % 50 == 0 ? chars[22 + r / 50 % 3] : chars[r % 22];
+    }
+    hex[len] = '\0';
+
+    Fixedpoint expected = fixedpoint_create_from_hex(hex);
+    FixedpointWide w;
+    fixedpoint_wide_from_hex(&w, hex, 1, 1);
+    ASSERT(w.tag == expected.tag);
+    if (fixedpoint_is_valid(expected))
+    {
+      ASSERT(w.limb[1] == expected.integer && w.limb[0] == expected.fraction);
+      char buf[FIXEDPOINT_WIDE_HEX_BUF_SIZE], expected_buf[FIXEDPOINT_HEX_BUF_SIZE];
+      fixedpoint_wide_format_as_hex(&w, buf, sizeof(buf));
+      fixedpoint_format_as_hex_buf(expected, expected_buf, sizeof(expected_buf));
+      ASSERT(0 == strcmp(buf, expected_buf));
+    }
+
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    Fixedpoint x = fixedpoint_create2(state >> (state & 63), state * 31);
+    x.tag = (int)(state >> 17 & 1) && !fixedpoint_is_zero(x);
+    state = state * 6364136223846793005UL + 1442695040888963407UL;
+    Fixedpoint y = fixedpoint_create2(state >> (state & 63), state * 37);
+    y.tag = (int)(state >> 17 & 1) && !fixedpoint_is_zero(y);
+    FixedpointWide wx, wy, wr;
+    fixedpoint_wide_from_fixedpoint(&wx, x, 1, 1);
+    fixedpoint_wide_from_fixedpoint(&wy, y, 1, 1);
+    ASSERT(fixedpoint_wide_compare(&wx, &wy) == fixedpoint_compare(x, y));
+
+    Fixedpoint sum = fixedpoint_add(x, y);
+    fixedpoint_wide_add(&wr, &wx, &wy);
+    ASSERT(wr.tag == sum.tag);
+    if (fixedpoint_is_valid(sum))
+    {
+      ASSERT(0 == fixedpoint_compare(fixedpoint_wide_to_fixedpoint(&wr), sum));
+    }
+    Fixedpoint diff = fixedpoint_sub(x, y);
+    fixedpoint_wide_sub(&wr, &wx, &wy);
+    ASSERT(wr.tag == diff.tag);
+    if (fixedpoint_is_valid(diff))
+    {
+      ASSERT(0 == fixedpoint_compare(fixedpoint_wide_to_fixedpoint(&wr), diff));
+    }
+    int n = (int)(state >> 9 & 127);
+    Fixedpoint shl = fixedpoint_shl(x, n);
+    fixedpoint_wide_shl(&wr, &wx, n);
+    ASSERT(wr.tag == shl.tag);
+    if (fixedpoint_is_valid(shl))
+    {
+      ASSERT(0 == fixedpoint_compare(fixedpoint_wide_to_fixedpoint(&wr), shl));
+    }
+    Fixedpoint shr = fixedpoint_shr_round(x, n, FIXEDPOINT_ROUND_EXACT);
+    fixedpoint_wide_shr(&wr, &wx, n);
+    ASSERT(wr.tag == shr.tag);
+    if (fixedpoint_is_valid(shr))
+    {
+      ASSERT(0 == fixedpoint_compare(fixedpoint_wide_to_fixedpoint(&wr), shr));
+    }
+  }
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+}
+
+// constants built at compile time, which must match the runtime parser
+static const Fixedpoint literals[] = {
+    FIXEDPOINT_LITERAL(0, 0),
+    FIXEDPOINT_LITERAL(1, 8),
+    FIXEDPOINT_LITERAL_NEG(0, 0004),
+    FIXEDPOINT_LITERAL_NEG(0, 0),
+    FIXEDPOINT_LITERAL(ffffffffffffffff, FFFFFFFFFFFFFFFF),
+    FIXEDPOINT_LITERAL(0000000000000001, 1000000000000000),
+    FIXEDPOINT_LITERAL_NEG(DeadBeef, cafe),
+};
+static const char *literal_strings[] = {"0.0", "1.8", "-0.0004", "-0.0", "ffffffffffffffff.FFFFFFFFFFFFFFFF",
+                                        "0000000000000001.1000000000000000", "-DeadBeef.cafe"};
+
+void test_literals(TestObjs *objs)
+{
+  for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]); i++)
+  {
+    Fixedpoint expected = fixedpoint_create_from_hex(literal_strings[i]);
+    ASSERT(literals[i].integer == expected.integer);
+    ASSERT(literals[i].fraction == expected.fraction);
+    ASSERT(literals[i].tag == expected.tag);
+  }
+  ASSERT(0 == fixedpoint_compare((Fixedpoint)FIXEDPOINT_LITERAL(0, 8), objs->one_half));
+  ASSERT(0 == fixedpoint_compare((Fixedpoint)FIXEDPOINT_LITERAL(0, 4), objs->one_fourth));
+}
+
+// a random valid value for test_unchecked: mostly arbitrary, sometimes
+// zero (of either sign), the largest magnitude, or a copy of other
+static Fixedpoint random_valid(uint64_t *state, Fixedpoint other)
+{
+  *state = *state * 6364136223846793005UL + 1442695040888963407UL;
+  uint64_t r = *state;
+  Fixedpoint val = fixedpoint_create2(r >> (r & 63), r * 31);
+  switch (r >> 59)
+  {
+  case 0:
+    val = fixedpoint_create(0UL);
+    break;
+  case 1:
+    val = fixedpoint_create2(UINT64_MAX, UINT64_MAX);
+    break;
+  case 2:
+  case 3:
+    val = other;
+    break;
+  case 4:
+    // same integer part, so the fractions decide
+    val.integer = other.integer;
+    break;
+  }
+  // negative zero is valid too, and fixedpoint_add can produce it
+  val.tag = (int)(r >> 17 & 1);
+  return val;
+}
+
+void test_unchecked(TestObjs *objs)
+{
+  (void)objs;
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+  // on valid operands (and sums in range) the unchecked variants give
+  // exactly the checked results
+  uint64_t state = 7;
+  Fixedpoint prev = fixedpoint_create(1UL);
+  for (int iter = 0; iter < 100000; iter++)
+  {
+    Fixedpoint x = random_valid(&state, prev);
+    Fixedpoint y = random_valid(&state, x);
+    prev = y;
+
+    ASSERT(fixedpoint_compare_unchecked(x, y) == fixedpoint_compare(x, y));
+    ASSERT(fixedpoint_compare_unchecked(y, x) == fixedpoint_compare(y, x));
+
+    Fixedpoint expected = fixedpoint_negate(x);
+    Fixedpoint neg = fixedpoint_negate_unchecked(x);
+    ASSERT(neg.integer == expected.integer && neg.fraction == expected.fraction && neg.tag == expected.tag);
+
+    expected = fixedpoint_add(x, y);
+    if (fixedpoint_is_valid(expected))
+    {
+      Fixedpoint sum = fixedpoint_add_unchecked(x, y);
+      ASSERT(sum.integer == expected.integer && sum.fraction == expected.fraction && sum.tag == expected.tag);
+    }
+  }
+  fixedpoint_status_clear(FIXEDPOINT_STATUS_ALL);
+
+  // the unchecked variants don't raise status flags
+  Fixedpoint max = fixedpoint_create2(UINT64_MAX, UINT64_MAX);
+  Fixedpoint sum = fixedpoint_add_unchecked(max, fixedpoint_negate_unchecked(max));
+  ASSERT(fixedpoint_is_zero(sum) && sum.tag == 0);
+  sum = fixedpoint_add_unchecked(fixedpoint_negate_unchecked(max), max);
+  ASSERT(fixedpoint_is_zero(sum) && sum.tag == 1);
+  ASSERT(fixedpoint_compare_unchecked(sum, fixedpoint_create(0UL)) == 0);
+  ASSERT(!fixedpoint_status_test(FIXEDPOINT_STATUS_ALL));
+}
@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "fixedpoint_internal.h"
+#include "fixedpoint_trace.h"
+
+static const char *const probe_names[FIXEDPOINT_NUM_PROBES] = {
+    "hex_invalid", "add_overflow", "sub_overflow", "halve_underflow", "format_invalid",
+};
+
+_Atomic(FixedpointTraceHook) fixedpoint_trace_hook;
+
+// The ring buffer.  Events are only recorded on exceptional paths, so a
+// lock is cheap enough, and keeps each event whole for readers.
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static FixedpointTraceEvent *ring;
+static size_t ring_capacity;
+static size_t ring_start; // index of the oldest event
+static size_t ring_count;
+static uint64_t ring_lost;
+
+void fixedpoint_trace_fire(int probe, Fixedpoint left, Fixedpoint right, const char *text, Fixedpoint result)
+{
+  FixedpointTraceHook hook = atomic_load_explicit(&fixedpoint_trace_hook, memory_order_relaxed);
+  if (!hook)
+  {
+    return;
+  }
+  FixedpointTraceEvent event;
+  event.probe = probe;
+  event.tag = result.tag;
+  event.left = left;
+  event.right = right;
+  event.text[0] = '\0';
+  if (text)
+  {
+    strncat(event.text, text, FIXEDPOINT_TRACE_TEXT_SIZE - 1);
+  }
+  hook(&event);
+}
+
+static void record_in_ring(const FixedpointTraceEvent *event)
+{
+  pthread_mutex_lock(&ring_lock);
+  // the buffer may have been freed since the hook was loaded
+  if (ring)
+  {
+    if (ring_count == ring_capacity)
+    {
+      ring_start = (ring_start + 1) % ring_capacity;
+      ring_count--;
+      ring_lost++;
+    }
+    ring[(ring_start + ring_count) % ring_capacity] = *event;
+    ring_count++;
+  }
+  pthread_mutex_unlock(&ring_lock);
+}
+
+void fixedpoint_trace_set_hook(FixedpointTraceHook hook)
+{
+  atomic_store_explicit(&fixedpoint_trace_hook, hook, memory_order_relaxed);
+}
+
+int fixedpoint_trace_start(size_t capacity)
+{
+  FixedpointTraceEvent *events = capacity ? malloc(capacity * sizeof(FixedpointTraceEvent)) : NULL;
+  if (!events)
+  {
+    return 0;
+  }
+  pthread_mutex_lock(&ring_lock);
+  free(ring);
+  ring = events;
+  ring_capacity = capacity;
+  ring_start = 0;
+  ring_count = 0;
+  ring_lost = 0;
+  pthread_mutex_unlock(&ring_lock);
+  fixedpoint_trace_set_hook(record_in_ring);
+  return 1;
+}
+
+void fixedpoint_trace_stop(void)
+{
+  fixedpoint_trace_set_hook(NULL);
+  pthread_mutex_lock(&ring_lock);
+  free(ring);
+  ring = NULL;
+  ring_capacity = 0;
+  ring_count = 0;
+  pthread_mutex_unlock(&ring_lock);
+}
+
+size_t fixedpoint_trace_read(FixedpointTraceEvent *events, size_t max)
+{
+  size_t n = 0;
+  pthread_mutex_lock(&ring_lock);
+  while (n < max && ring_count > 0)
+  {
+    events[n++] = ring[ring_start];
+    ring_start = (ring_start + 1) % ring_capacity;
+    ring_count--;
+  }
+  pthread_mutex_unlock(&ring_lock);
+  return n;
+}
+
+uint64_t fixedpoint_trace_lost(void)
+{
+  pthread_mutex_lock(&ring_lock);
+  uint64_t lost = ring_lost;
+  pthread_mutex_unlock(&ring_lock);
+  return lost;
+}
+
+const char *fixedpoint_trace_probe_name(int probe)
+{
+  return (probe >= 0 && probe < FIXEDPOINT_NUM_PROBES) ? probe_names[probe] : "unknown";
+}
@@ -0,0 +1,106 @@
+#ifndef FIXEDPOINT_TRACE_H
+#define FIXEDPOINT_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tracepoints on the exceptional paths of the library.
+//
+// Each probe below fires when an operation takes an exceptional path,
+// and passes an event (which operation, its operands and the tag of the
+// result) to the current trace hook.  While no hook is set, a probe is a
+// single load and untaken branch on a path which is already exceptional,
+// so the operations run at full speed.
+//
+// A hook may be any function; fixedpoint_trace_start installs a built-in
+// one which records events in a fixed-size ring buffer, to be read later
+// with fixedpoint_trace_read.
+
+// probes
+enum
+{
+  FIXEDPOINT_PROBE_HEX_INVALID,     // fixedpoint_create_from_hex given an invalid string
+  FIXEDPOINT_PROBE_ADD_OVERFLOW,    // fixedpoint_add overflowed
+  FIXEDPOINT_PROBE_SUB_OVERFLOW,    // fixedpoint_sub overflowed
+  FIXEDPOINT_PROBE_HALVE_UNDERFLOW, // fixedpoint_halve underflowed
+  FIXEDPOINT_PROBE_FORMAT_INVALID,  // fixedpoint_format_as_hex(_buf) given an invalid value
+  FIXEDPOINT_NUM_PROBES
+};
+
+// length of the text kept from an invalid hex string, including the NUL
+#define FIXEDPOINT_TRACE_TEXT_SIZE 40
+
+typedef struct
+{
+  int probe;         // one of the FIXEDPOINT_PROBE_ values
+  int tag;           // tag of the result
+  Fixedpoint left;   // the operand (the left one for add and sub), or
+                     // zero for HEX_INVALID
+  Fixedpoint right;  // the right operand of add and sub, otherwise zero
+  char text[FIXEDPOINT_TRACE_TEXT_SIZE]; // for HEX_INVALID, the start of
+                                         // the string, otherwise ""
+} FixedpointTraceEvent;
+
+// A trace hook.  It is called on the thread which hit the probe, and may
+// be called from several threads at once.  The event is only valid during
+// the call.
+typedef void (*FixedpointTraceHook)(const FixedpointTraceEvent *event);
+
+// Set the trace hook.  This may be called at any time, from any thread.
+//
+// Parameters:
+//   hook - the new hook, or NULL to disable tracing
+void fixedpoint_trace_set_hook(FixedpointTraceHook hook);
+
+// Start recording events in a ring buffer (replacing any hook and any
+// previously recorded events).  When the buffer is full, each new event
+// replaces the oldest one.
+//
+// Parameters:
+//   capacity - the number of events the buffer holds (at least 1)
+//
+// Returns:
+//   1 if successful, 0 if capacity is 0 or the buffer can't be allocated
+int fixedpoint_trace_start(size_t capacity);
+
+// Stop recording events in the ring buffer, disable tracing, and free the
+// buffer (discarding any events not yet read).
+void fixedpoint_trace_stop(void);
+
+// Remove events from the ring buffer, oldest first.
+//
+// Parameters:
+//   events - array of max events, set to the removed events
+//   max - the most events to remove
+//
+// Returns:
+//   the number of events removed
+size_t fixedpoint_trace_read(FixedpointTraceEvent *events, size_t max);
+
+// Get the number of events which were replaced before being read, since
+// fixedpoint_trace_start.
+//
+// Returns:
+//   the number of lost events
+uint64_t fixedpoint_trace_lost(void);
+
+// Get the name of a probe, e.g. "add_overflow" for
+// FIXEDPOINT_PROBE_ADD_OVERFLOW.
+//
+// Parameters:
+//   probe - one of the FIXEDPOINT_PROBE_ values
+//
+// Returns:
+//   the name
+const char *fixedpoint_trace_probe_name(int probe);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_TRACE_H
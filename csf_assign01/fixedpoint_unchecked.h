@@ -0,0 +1,100 @@
+#ifndef FIXEDPOINT_UNCHECKED_H
+#define FIXEDPOINT_UNCHECKED_H
+
+#include <assert.h>
+#include <stdint.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Unchecked versions of fixedpoint_add, fixedpoint_compare and
+// fixedpoint_negate, for inner loops whose operands are known to be
+// valid.  They skip the handling of the exceptional tags, don't raise
+// status flags or fire tracepoints, aren't counted by the operation
+// counters, and are inline, with no branches on the data beyond what the
+// compiler turns into conditional moves.
+//
+// Under their preconditions the results are exactly (bit for bit) those
+// of the checked functions.  The preconditions are checked with assert,
+// so a debug build catches a violation; with NDEBUG the result of a call
+// which violates them is unspecified.
+
+// Compute the sum of two valid values, whose sum is in range.
+//
+// Parameters:
+//   left - a valid Fixedpoint value
+//   right - a valid Fixedpoint value
+//
+// Returns:
+//   the sum, as fixedpoint_add returns it
+static inline Fixedpoint fixedpoint_add_unchecked(Fixedpoint left, Fixedpoint right)
+{
+  assert((left.tag == 0 || left.tag == 1) && (right.tag == 0 || right.tag == 1));
+  Fixedpoint sum;
+  if (left.tag == right.tag)
+  {
+    sum.fraction = left.fraction + right.fraction;
+    uint64_t carry = sum.fraction < left.fraction;
+    assert(right.integer <= UINT64_MAX - left.integer &&
+           !(carry && left.integer + right.integer == UINT64_MAX) && "sum out of range");
+    sum.integer = left.integer + right.integer + carry;
+    sum.tag = left.tag;
+  }
+  else
+  {
+    // subtract the smaller magnitude from the larger, whose sign the sum
+    // takes (the left one's if they are equal)
+    int swap = left.integer < right.integer || (left.integer == right.integer && left.fraction < right.fraction);
+    Fixedpoint big = swap ? right : left;
+    Fixedpoint small = swap ? left : right;
+    sum.fraction = big.fraction - small.fraction;
+    sum.integer = big.integer - small.integer - (big.fraction < small.fraction);
+    sum.tag = big.tag;
+  }
+  return sum;
+}
+
+// Compare two valid values.
+//
+// Parameters:
+//   left - a valid Fixedpoint value
+//   right - a valid Fixedpoint value
+//
+// Returns:
+//   -1 if left < right, 0 if left == right, 1 if left > right
+static inline int fixedpoint_compare_unchecked(Fixedpoint left, Fixedpoint right)
+{
+  assert((left.tag == 0 || left.tag == 1) && (right.tag == 0 || right.tag == 1));
+  int greater = left.integer > right.integer || (left.integer == right.integer && left.fraction > right.fraction);
+  int less = left.integer < right.integer || (left.integer == right.integer && left.fraction < right.fraction);
+  int magnitude = greater - less;
+  if (left.tag == right.tag)
+  {
+    return left.tag ? -magnitude : magnitude;
+  }
+  // zero equals zero whatever the signs
+  int both_zero = (left.integer | left.fraction | right.integer | right.fraction) == 0;
+  return both_zero ? 0 : (left.tag ? -1 : 1);
+}
+
+// Negate a valid value.
+//
+// Parameters:
+//   val - a valid Fixedpoint value
+//
+// Returns:
+//   the negation, as fixedpoint_negate returns it (zero is unchanged)
+static inline Fixedpoint fixedpoint_negate_unchecked(Fixedpoint val)
+{
+  assert(val.tag == 0 || val.tag == 1);
+  val.tag ^= (val.integer | val.fraction) != 0;
+  return val;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_UNCHECKED_H
@@ -0,0 +1,503 @@
+#include <string.h>
+#include "fixedpoint_internal.h"
+#include "fixedpoint_wide.h"
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+// Add with carry and subtract with borrow, one limb at a time.  On x86-64
+// these are the adc/sbb intrinsics, so that a chain of them keeps the
+// carry in the flags.
+
+ALWAYS_INLINE unsigned char addc(unsigned char carry, uint64_t a, uint64_t b, uint64_t *r)
+{
+#if defined(__x86_64__)
+  unsigned long long out;
+  carry = _addcarry_u64(carry, a, b, &out);
+  *r = out;
+  return carry;
+#else
+  u128 t = (u128)a + b + carry;
+  *r = (uint64_t)t;
+  return (unsigned char)(t >> 64);
+#endif
+}
+
+ALWAYS_INLINE unsigned char subb(unsigned char borrow, uint64_t a, uint64_t b, uint64_t *r)
+{
+#if defined(__x86_64__)
+  unsigned long long out;
+  borrow = _subborrow_u64(borrow, a, b, &out);
+  *r = out;
+  return borrow;
+#else
+  u128 t = (u128)a - b - borrow;
+  *r = (uint64_t)t;
+  return (unsigned char)(t >> 127);
+#endif
+}
+
+// Operations on n limb magnitudes.  r may be the same as a or b.  When n
+// is a constant the loops are unrolled into a single chain of adc (or
+// sbb) instructions.
+
+ALWAYS_INLINE unsigned char add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+{
+  unsigned char carry = 0;
+#pragma GCC unroll 16
+  for (int i = 0; i < n; i++)
+  {
+    carry = addc(carry, a[i], b[i], &r[i]);
+  }
+  return carry;
+}
+
+ALWAYS_INLINE unsigned char sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+{
+  unsigned char borrow = 0;
+#pragma GCC unroll 16
+  for (int i = 0; i < n; i++)
+  {
+    borrow = subb(borrow, a[i], b[i], &r[i]);
+  }
+  return borrow;
+}
+
+// the sign of a - b, from the borrow out of the subtraction and whether
+// any limb of the difference is nonzero
+ALWAYS_INLINE int cmp_n(const uint64_t *a, const uint64_t *b, int n)
+{
+  unsigned char borrow = 0;
+  uint64_t diff = 0, t;
+#pragma GCC unroll 16
+  for (int i = 0; i < n; i++)
+  {
+    borrow = subb(borrow, a[i], b[i], &t);
+    diff |= t;
+  }
+  return borrow ? -1 : diff != 0;
+}
+
+// The same, specialized (and so unrolled) for the common sizes: 2 limbs
+// (64.64), 3 (128.64 and 64.128) and 4 (128.128 and 192.64)
+
+static unsigned char add_limbs(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+{
+  switch (n)
+  {
+  case 2:
+    return add_n(r, a, b, 2);
+  case 3:
+    return add_n(r, a, b, 3);
+  case 4:
+    return add_n(r, a, b, 4);
+  default:
+    return add_n(r, a, b, n);
+  }
+}
+
+static unsigned char sub_limbs(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+{
+  switch (n)
+  {
+  case 2:
+    return sub_n(r, a, b, 2);
+  case 3:
+    return sub_n(r, a, b, 3);
+  case 4:
+    return sub_n(r, a, b, 4);
+  default:
+    return sub_n(r, a, b, n);
+  }
+}
+
+static int cmp_limbs(const uint64_t *a, const uint64_t *b, int n)
+{
+  switch (n)
+  {
+  case 2:
+    return cmp_n(a, b, 2);
+  case 3:
+    return cmp_n(a, b, 3);
+  case 4:
+    return cmp_n(a, b, 4);
+  default:
+    return cmp_n(a, b, n);
+  }
+}
+
+// Helpers
+
+static int format_ok(int whole_limbs, int frac_limbs)
+{
+  return whole_limbs >= 1 && whole_limbs <= FIXEDPOINT_WIDE_MAX_PART_LIMBS && frac_limbs >= 1 &&
+         frac_limbs <= FIXEDPOINT_WIDE_MAX_PART_LIMBS;
+}
+
+static int num_limbs(const FixedpointWide *val)
+{
+  return val->whole_limbs + val->frac_limbs;
+}
+
+static int is_valid(const FixedpointWide *val)
+{
+  return (val->tag == 0 || val->tag == 1) && format_ok(val->whole_limbs, val->frac_limbs);
+}
+
+static int same_format(const FixedpointWide *left, const FixedpointWide *right)
+{
+  return left->whole_limbs == right->whole_limbs && left->frac_limbs == right->frac_limbs;
+}
+
+static int is_zero(const FixedpointWide *val)
+{
+  uint64_t bits = 0;
+  for (int i = 0; i < num_limbs(val); i++)
+  {
+    bits |= val->limb[i];
+  }
+  return bits == 0;
+}
+
+// 1 if val is a valid nonzero negative value, 0 otherwise
+static int is_neg(const FixedpointWide *val)
+{
+  return val->tag == 1 && !is_zero(val);
+}
+
+static void zero(FixedpointWide *result, int whole_limbs, int frac_limbs)
+{
+  memset(result->limb, 0, sizeof(result->limb));
+  result->whole_limbs = whole_limbs;
+  result->frac_limbs = frac_limbs;
+  result->tag = 0;
+}
+
+// Raise the status flag for a result's tag, if it is exceptional
+static void record_status(const FixedpointWide *result)
+{
+  fixedpoint_status_raise((1 << result->tag) & FIXEDPOINT_STATUS_ALL);
+}
+
+static void set_error(FixedpointWide *result, int whole_limbs, int frac_limbs)
+{
+  if (!format_ok(whole_limbs, frac_limbs))
+  {
+    whole_limbs = frac_limbs = 0;
+  }
+  zero(result, whole_limbs, frac_limbs);
+  result->tag = 2;
+  record_status(result);
+}
+
+// Conversions
+
+void fixedpoint_wide_init(FixedpointWide *result, int whole_limbs, int frac_limbs)
+{
+  if (!format_ok(whole_limbs, frac_limbs))
+  {
+    set_error(result, whole_limbs, frac_limbs);
+    return;
+  }
+  zero(result, whole_limbs, frac_limbs);
+}
+
+void fixedpoint_wide_from_fixedpoint(FixedpointWide *result, Fixedpoint val, int whole_limbs, int frac_limbs)
+{
+  if (!format_ok(whole_limbs, frac_limbs))
+  {
+    set_error(result, whole_limbs, frac_limbs);
+    return;
+  }
+  zero(result, whole_limbs, frac_limbs);
+  result->limb[frac_limbs - 1] = val.fraction;
+  result->limb[frac_limbs] = val.integer;
+  result->tag = val.tag;
+}
+
+Fixedpoint fixedpoint_wide_to_fixedpoint(const FixedpointWide *val)
+{
+  Fixedpoint result = fixedpoint_create(0UL);
+  if (!is_valid(val))
+  {
+    result.tag = 2;
+    fixedpoint_status_raise(FIXEDPOINT_STATUS_ERR);
+    return result;
+  }
+  int frac = val->frac_limbs;
+  uint64_t high = 0, low = 0;
+  for (int i = frac + 1; i < num_limbs(val); i++)
+  {
+    high |= val->limb[i];
+  }
+  for (int i = 0; i < frac - 1; i++)
+  {
+    low |= val->limb[i];
+  }
+  result.integer = val->limb[frac];
+  result.fraction = val->limb[frac - 1];
+  result.tag = val->tag;
+  if (high | low)
+  {
+    int neg = is_neg(val);
+    result.tag = high ? (neg ? 3 : 4) : (neg ? 5 : 6);
+    fixedpoint_status_raise(1 << result.tag);
+  }
+  return result;
+}
+
+static int hex_value(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+void fixedpoint_wide_from_hex(FixedpointWide *result, const char *hex, int whole_limbs, int frac_limbs)
+{
+  if (!format_ok(whole_limbs, frac_limbs))
+  {
+    set_error(result, whole_limbs, frac_limbs);
+    return;
+  }
+  zero(result, whole_limbs, frac_limbs);
+  // as with fixedpoint_create_from_hex, "." and "-." are zero
+  if (strcmp(hex, "-.") == 0 || strcmp(hex, ".") == 0)
+  {
+    return;
+  }
+
+  int start = hex[0] == '-';
+  size_t len = strlen(hex);
+  size_t point = len;
+  for (size_t i = start; i < len; i++)
+  {
+    if (hex[i] == '.' && point == len)
+    {
+      point = i;
+    }
+    else if (hex_value(hex[i]) < 0)
+    {
+      set_error(result, whole_limbs, frac_limbs);
+      return;
+    }
+  }
+  size_t whole_digits = point - start;
+  size_t frac_digits = point < len ? len - point - 1 : 0;
+  if (whole_digits > 16 * (size_t)whole_limbs || frac_digits > 16 * (size_t)frac_limbs)
+  {
+    set_error(result, whole_limbs, frac_limbs);
+    return;
+  }
+
+  // the whole part is filled from its least significant digit, and the
+  // fraction from its most significant one
+  for (size_t j = 0; j < whole_digits; j++)
+  {
+    size_t bit = 64 * (size_t)frac_limbs + 4 * j;
+    result->limb[bit / 64] |= (uint64_t)hex_value(hex[point - 1 - j]) << (bit % 64);
+  }
+  for (size_t j = 0; j < frac_digits; j++)
+  {
+    size_t bit = 64 * (size_t)frac_limbs - 4 * (j + 1);
+    result->limb[bit / 64] |= (uint64_t)hex_value(hex[point + 1 + j]) << (bit % 64);
+  }
+  result->tag = start;
+}
+
+int fixedpoint_wide_format_as_hex(const FixedpointWide *val, char *buf, size_t size)
+{
+  static const char hex_digits[] = "0123456789abcdef";
+  char result[FIXEDPOINT_WIDE_HEX_BUF_SIZE];
+  int len = 0;
+
+  if (is_valid(val))
+  {
+    // zero has no sign, even if it was produced as -0
+    if (is_neg(val))
+    {
+      result[len++] = '-';
+    }
+    int frac_bits = 64 * val->frac_limbs;
+    int top = 64 * num_limbs(val) - 4;
+    while (top > frac_bits && ((val->limb[top / 64] >> (top % 64)) & 0xf) == 0)
+    {
+      top -= 4;
+    }
+    // fraction digits, without trailing zeros
+    int bottom = 0;
+    while (bottom < frac_bits && ((val->limb[bottom / 64] >> (bottom % 64)) & 0xf) == 0)
+    {
+      bottom += 4;
+    }
+    for (int bit = top; bit >= frac_bits; bit -= 4)
+    {
+      result[len++] = hex_digits[(val->limb[bit / 64] >> (bit % 64)) & 0xf];
+    }
+    if (bottom < frac_bits)
+    {
+      result[len++] = '.';
+    }
+    for (int bit = frac_bits - 4; bit >= bottom; bit -= 4)
+    {
+      result[len++] = hex_digits[(val->limb[bit / 64] >> (bit % 64)) & 0xf];
+    }
+  }
+  result[len] = '\0';
+
+  if (size > 0)
+  {
+    size_t n = ((size_t)len < size - 1) ? (size_t)len : size - 1;
+    memcpy(buf, result, n);
+    buf[n] = '\0';
+  }
+  return len;
+}
+
+// Arithmetic
+
+// left + right, with the sign of right given by right_neg
+static void add_signed(FixedpointWide *result, const FixedpointWide *left, const FixedpointWide *right,
+                       int right_neg)
+{
+  if (!is_valid(left) || !is_valid(right) || !same_format(left, right))
+  {
+    set_error(result, left->whole_limbs, left->frac_limbs);
+    return;
+  }
+  int n = num_limbs(left);
+  int left_neg = is_neg(left);
+  FixedpointWide sum;
+  zero(&sum, left->whole_limbs, left->frac_limbs);
+
+  if (left_neg == right_neg)
+  {
+    unsigned char carry = add_limbs(sum.limb, left->limb, right->limb, n);
+    sum.tag = carry ? (left_neg ? 3 : 4) : left_neg;
+  }
+  else if (cmp_limbs(left->limb, right->limb, n) >= 0)
+  {
+    sub_limbs(sum.limb, left->limb, right->limb, n);
+    sum.tag = left_neg;
+  }
+  else
+  {
+    sub_limbs(sum.limb, right->limb, left->limb, n);
+    sum.tag = right_neg;
+  }
+  if (sum.tag == 1 && is_zero(&sum))
+  {
+    sum.tag = 0;
+  }
+  *result = sum;
+  record_status(result);
+}
+
+void fixedpoint_wide_add(FixedpointWide *result, const FixedpointWide *left, const FixedpointWide *right)
+{
+  add_signed(result, left, right, is_neg(right));
+}
+
+void fixedpoint_wide_sub(FixedpointWide *result, const FixedpointWide *left, const FixedpointWide *right)
+{
+  add_signed(result, left, right, !is_neg(right) && !is_zero(right));
+}
+
+void fixedpoint_wide_negate(FixedpointWide *result, const FixedpointWide *val)
+{
+  if (!is_valid(val))
+  {
+    set_error(result, val->whole_limbs, val->frac_limbs);
+    return;
+  }
+  int neg = !is_neg(val) && !is_zero(val);
+  *result = *val;
+  result->tag = neg;
+}
+
+void fixedpoint_wide_shl(FixedpointWide *result, const FixedpointWide *val, int n)
+{
+  int total = num_limbs(val);
+  if (!is_valid(val) || n < 0 || n >= 64 * total)
+  {
+    set_error(result, val->whole_limbs, val->frac_limbs);
+    return;
+  }
+  int q = n / 64, s = n % 64;
+  uint64_t lost = 0;
+  for (int j = total - q; j < total; j++)
+  {
+    lost |= val->limb[j];
+  }
+  if (s)
+  {
+    lost |= val->limb[total - q - 1] >> (64 - s);
+  }
+
+  FixedpointWide shifted;
+  zero(&shifted, val->whole_limbs, val->frac_limbs);
+  for (int i = q; i < total; i++)
+  {
+    uint64_t below = s && i - q - 1 >= 0 ? val->limb[i - q - 1] >> (64 - s) : 0;
+    shifted.limb[i] = (val->limb[i - q] << s) | below;
+  }
+  int neg = is_neg(val);
+  shifted.tag = lost ? (neg ? 3 : 4) : neg && !is_zero(&shifted);
+  *result = shifted;
+  record_status(result);
+}
+
+void fixedpoint_wide_shr(FixedpointWide *result, const FixedpointWide *val, int n)
+{
+  int total = num_limbs(val);
+  if (!is_valid(val) || n < 0 || n >= 64 * total)
+  {
+    set_error(result, val->whole_limbs, val->frac_limbs);
+    return;
+  }
+  int q = n / 64, s = n % 64;
+  uint64_t lost = 0;
+  for (int j = 0; j < q; j++)
+  {
+    lost |= val->limb[j];
+  }
+  if (s)
+  {
+    lost |= val->limb[q] << (64 - s);
+  }
+
+  FixedpointWide shifted;
+  zero(&shifted, val->whole_limbs, val->frac_limbs);
+  for (int i = 0; i + q < total; i++)
+  {
+    uint64_t above = s && i + q + 1 < total ? val->limb[i + q + 1] << (64 - s) : 0;
+    shifted.limb[i] = (val->limb[i + q] >> s) | above;
+  }
+  int neg = is_neg(val);
+  shifted.tag = lost ? (neg ? 5 : 6) : neg && !is_zero(&shifted);
+  *result = shifted;
+  record_status(result);
+}
+
+int fixedpoint_wide_compare(const FixedpointWide *left, const FixedpointWide *right)
+{
+  int left_neg = is_neg(left), right_neg = is_neg(right);
+  if (left_neg != right_neg)
+  {
+    return left_neg ? -1 : 1;
+  }
+  int c = cmp_limbs(left->limb, right->limb, num_limbs(left));
+  return left_neg ? -c : c;
+}
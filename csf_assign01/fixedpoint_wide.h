@@ -0,0 +1,148 @@
+#ifndef FIXEDPOINT_WIDE_H
+#define FIXEDPOINT_WIDE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fixed-point values with more than 64 whole or fractional bits.
+//
+// A FixedpointWide has a format of whole_limbs 64 bit limbs of whole part
+// and frac_limbs limbs of fraction (each from 1 to
+// FIXEDPOINT_WIDE_MAX_PART_LIMBS), e.g. 2 and 2 for 128.128 or 3 and 1
+// for 192.64.  Like a Fixedpoint, it is a magnitude and a tag, and the
+// tags have the same meanings (0 non-negative, 1 negative, 2 error, 3 and
+// 4 negative and positive overflow, 5 and 6 negative and positive
+// underflow).  The operations below behave like their Fixedpoint
+// counterparts, and raise the same status flags, so a FixedpointWide with
+// one limb in each part gives the same results as a Fixedpoint.
+//
+// The values are fairly large, so they are passed by pointer; a result
+// may be the same as an operand.  Operands of an operation must have the
+// same format (otherwise the result is an error value).
+
+// the most limbs in each of the whole and fractional parts
+#define FIXEDPOINT_WIDE_MAX_PART_LIMBS 8
+#define FIXEDPOINT_WIDE_MAX_LIMBS (2 * FIXEDPOINT_WIDE_MAX_PART_LIMBS)
+
+// Size of a buffer large enough for any string produced by
+// fixedpoint_wide_format_as_hex, including the NUL terminator.
+#define FIXEDPOINT_WIDE_HEX_BUF_SIZE (3 + 2 * 16 * FIXEDPOINT_WIDE_MAX_PART_LIMBS)
+
+typedef struct
+{
+  // the magnitude, least significant limb first: frac_limbs limbs of
+  // fraction, then whole_limbs limbs of whole part (the rest are zero)
+  uint64_t limb[FIXEDPOINT_WIDE_MAX_LIMBS];
+  int whole_limbs;
+  int frac_limbs;
+  int tag;
+} FixedpointWide;
+
+// Create the value zero in a format.
+//
+// Parameters:
+//   result - set to zero, or to an error value if the format isn't
+//            supported
+//   whole_limbs - limbs of whole part
+//   frac_limbs - limbs of fraction
+void fixedpoint_wide_init(FixedpointWide *result, int whole_limbs, int frac_limbs);
+
+// Convert a Fixedpoint value to a wide format.  The value is always
+// representable, and its tag is kept.
+//
+// Parameters:
+//   result - set to the converted value
+//   val - the Fixedpoint value
+//   whole_limbs - limbs of whole part
+//   frac_limbs - limbs of fraction
+void fixedpoint_wide_from_fixedpoint(FixedpointWide *result, Fixedpoint val, int whole_limbs, int frac_limbs);
+
+// Convert a wide value to a Fixedpoint value.
+//
+// Parameters:
+//   val - the wide value
+//
+// Returns:
+//   the value, if it can be represented exactly; an overflow value if its
+//   magnitude is too large; an underflow value if it has nonzero
+//   fraction bits beyond the first 64; or an error value if val isn't
+//   valid
+Fixedpoint fixedpoint_wide_to_fixedpoint(const FixedpointWide *val);
+
+// Parse a hex string, as fixedpoint_create_from_hex does, allowing up to
+// 16 digits per limb in each part.
+//
+// Parameters:
+//   result - set to the value, or an error value if hex isn't valid
+//   hex - the string
+//   whole_limbs - limbs of whole part
+//   frac_limbs - limbs of fraction
+void fixedpoint_wide_from_hex(FixedpointWide *result, const char *hex, int whole_limbs, int frac_limbs);
+
+// Format a valid value as a hex string, as fixedpoint_format_as_hex_buf
+// does.  A value which isn't valid is formatted as an empty string.
+//
+// Parameters:
+//   val - the value
+//   buf - the buffer to write the NUL-terminated string to
+//   size - the size of buf; if it is too small, the string is truncated
+//
+// Returns:
+//   the length of the full string (not counting the NUL terminator)
+int fixedpoint_wide_format_as_hex(const FixedpointWide *val, char *buf, size_t size);
+
+// Compute the sum or difference of two valid values.
+//
+// Parameters:
+//   result - set to the exact result, or an overflow value (with the
+//            magnitude wrapped around) if its magnitude is too large
+//   left - the left value
+//   right - the right value
+void fixedpoint_wide_add(FixedpointWide *result, const FixedpointWide *left, const FixedpointWide *right);
+void fixedpoint_wide_sub(FixedpointWide *result, const FixedpointWide *left, const FixedpointWide *right);
+
+// Negate a valid value.
+//
+// Parameters:
+//   result - set to the negation (zero is never negative)
+//   val - the value
+void fixedpoint_wide_negate(FixedpointWide *result, const FixedpointWide *val);
+
+// Multiply a valid value by 2^n.
+//
+// Parameters:
+//   result - set to the exact result, or an overflow value (with the
+//            bits shifted out lost) if its magnitude is too large
+//   val - the value
+//   n - the shift amount, from 0 to 64 * (whole_limbs + frac_limbs) - 1
+void fixedpoint_wide_shl(FixedpointWide *result, const FixedpointWide *val, int n);
+
+// Divide a valid value by 2^n.
+//
+// Parameters:
+//   result - set to the exact result, or an underflow value (with the
+//            bits shifted out lost) if it can't be represented exactly
+//   val - the value
+//   n - the shift amount, from 0 to 64 * (whole_limbs + frac_limbs) - 1
+void fixedpoint_wide_shr(FixedpointWide *result, const FixedpointWide *val, int n);
+
+// Compare two valid values of the same format.
+//
+// Parameters:
+//   left - the left value
+//   right - the right value
+//
+// Returns:
+//   -1 if left < right, 0 if left == right, 1 if left > right
+int fixedpoint_wide_compare(const FixedpointWide *left, const FixedpointWide *right);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_WIDE_H
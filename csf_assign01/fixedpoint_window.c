@@ -0,0 +1,251 @@
+#include <stdlib.h>
+#include "fixedpoint.h"
+#include "fixedpoint_internal.h"
+#include "fixedpoint_window.h"
+
+// Double-ended queue of sequence numbers of values in the window, in a
+// ring buffer with room for the whole window
+typedef struct
+{
+  uint64_t *seq;
+  size_t head;
+  size_t len;
+} Deque;
+
+struct FixedpointWindow
+{
+  size_t size;
+  Fixedpoint *vals;  // vals[seq % size] is the value pushed as number seq
+  uint64_t pushed;   // number of values pushed so far
+  WideSum sum;
+  Deque min;         // values increase from front to back
+  Deque max;         // values decrease from front to back
+};
+
+static uint64_t deque_front(const Deque *q)
+{
+  return q->seq[q->head];
+}
+
+static uint64_t deque_back(const FixedpointWindow *win, const Deque *q)
+{
+  return q->seq[(q->head + q->len - 1) % win->size];
+}
+
+static void deque_push_back(const FixedpointWindow *win, Deque *q, uint64_t seq)
+{
+  q->seq[(q->head + q->len) % win->size] = seq;
+  q->len++;
+}
+
+static void deque_pop_front(const FixedpointWindow *win, Deque *q)
+{
+  q->head = (q->head + 1) % win->size;
+  q->len--;
+}
+
+// Add the newest value (number seq) to a monotonic deque, first removing
+// the values it supersedes: those at least as large for the minimum
+// (order = 1), or at most as large for the maximum (order = -1)
+static void deque_add(FixedpointWindow *win, Deque *q, uint64_t seq, int order)
+{
+  Fixedpoint val = win->vals[seq % win->size];
+  while (q->len > 0 && fixedpoint_compare(win->vals[deque_back(win, q) % win->size], val) * order >= 0)
+  {
+    q->len--;
+  }
+  deque_push_back(win, q, seq);
+}
+
+static Fixedpoint error_value(void)
+{
+  Fixedpoint result = fixedpoint_create(0UL);
+  result.tag = 2;
+  fixedpoint_status_raise(1 << result.tag);
+  return result;
+}
+
+FixedpointWindow *fixedpoint_window_create(size_t size)
+{
+  if (size == 0)
+  {
+    return NULL;
+  }
+  FixedpointWindow *win = calloc(1, sizeof(FixedpointWindow));
+  if (!win)
+  {
+    return NULL;
+  }
+  win->size = size;
+  win->vals = malloc(size * sizeof(Fixedpoint));
+  win->min.seq = malloc(size * sizeof(uint64_t));
+  win->max.seq = malloc(size * sizeof(uint64_t));
+  if (!win->vals || !win->min.seq || !win->max.seq)
+  {
+    fixedpoint_window_destroy(win);
+    return NULL;
+  }
+  return win;
+}
+
+void fixedpoint_window_destroy(FixedpointWindow *win)
+{
+  if (win)
+  {
+    free(win->vals);
+    free(win->min.seq);
+    free(win->max.seq);
+    free(win);
+  }
+}
+
+void fixedpoint_window_push(FixedpointWindow *win, Fixedpoint val)
+{
+  uint64_t seq = win->pushed++;
+
+  if (seq >= win->size)
+  {
+    // evict value number seq - size, whose slot the new value takes
+    uint64_t old = seq - win->size;
+    wide_sub(&win->sum, win->vals[old % win->size]);
+    if (deque_front(&win->min) == old)
+    {
+      deque_pop_front(win, &win->min);
+    }
+    if (deque_front(&win->max) == old)
+    {
+      deque_pop_front(win, &win->max);
+    }
+  }
+  win->vals[seq % win->size] = val;
+  wide_add(&win->sum, val);
+  deque_add(win, &win->min, seq, 1);
+  deque_add(win, &win->max, seq, -1);
+}
+
+size_t fixedpoint_window_count(const FixedpointWindow *win)
+{
+  return win->pushed < win->size ? (size_t)win->pushed : win->size;
+}
+
+Fixedpoint fixedpoint_window_sum(const FixedpointWindow *win)
+{
+  Fixedpoint result = wide_get(win->sum);
+  fixedpoint_status_raise(1 << result.tag);
+  return result;
+}
+
+Fixedpoint fixedpoint_window_min(const FixedpointWindow *win)
+{
+  if (win->pushed == 0)
+  {
+    return error_value();
+  }
+  return win->vals[deque_front(&win->min) % win->size];
+}
+
+Fixedpoint fixedpoint_window_max(const FixedpointWindow *win)
+{
+  if (win->pushed == 0)
+  {
+    return error_value();
+  }
+  return win->vals[deque_front(&win->max) % win->size];
+}
+
+Fixedpoint fixedpoint_window_mean(const FixedpointWindow *win, int mode)
+{
+  uint64_t count = fixedpoint_window_count(win);
+  if (count == 0)
+  {
+    return error_value();
+  }
+
+  // magnitude of the sum as 192 bits hi:lo
+  u128 lo = win->sum.lo;
+  uint64_t hi = (uint64_t)win->sum.hi;
+  int neg = win->sum.hi < 0;
+  if (neg)
+  {
+    hi = ~hi + (lo == 0);
+    lo = -lo;
+  }
+
+  // Long division by count, 64 bits at a time.  The mean of values in
+  // range is in range, so the quotient fits in 128 bits.
+  u128 rem = hi % count;
+  u128 part = (rem << 64) | (uint64_t)(lo >> 64);
+  u128 q1 = part / count;
+  rem = part % count;
+  part = (rem << 64) | (uint64_t)lo;
+  u128 q0 = part / count;
+  rem = part % count;
+
+  // compare 2 * rem with count without overflowing
+  int half = rem >= count - rem;
+  int sticky = half ? rem != count - rem : rem != 0;
+  return round_mag((q1 << 64) | q0, half, sticky, neg, mode);
+}
+
+// Aggregates computed by window_n
+enum
+{
+  AGG_SUM,
+  AGG_MIN,
+  AGG_MAX,
+  AGG_MEAN,
+};
+
+static void window_n(const Fixedpoint *vals, size_t window, int agg, int mode, Fixedpoint *out, size_t n)
+{
+  // the window keeps its own copy of the values, so out may overwrite vals
+  FixedpointWindow *win = fixedpoint_window_create(window);
+  if (!win)
+  {
+    for (size_t i = 0; i < n; i++)
+    {
+      out[i] = error_value();
+    }
+    return;
+  }
+  for (size_t i = 0; i < n; i++)
+  {
+    fixedpoint_window_push(win, vals[i]);
+    switch (agg)
+    {
+    case AGG_SUM:
+      out[i] = fixedpoint_window_sum(win);
+      break;
+    case AGG_MIN:
+      out[i] = fixedpoint_window_min(win);
+      break;
+    case AGG_MAX:
+      out[i] = fixedpoint_window_max(win);
+      break;
+    case AGG_MEAN:
+      out[i] = fixedpoint_window_mean(win, mode);
+      break;
+    }
+  }
+  fixedpoint_window_destroy(win);
+}
+
+void fixedpoint_window_sum_n(const Fixedpoint *vals, size_t window, Fixedpoint *out, size_t n)
+{
+  window_n(vals, window, AGG_SUM, 0, out, n);
+}
+
+void fixedpoint_window_min_n(const Fixedpoint *vals, size_t window, Fixedpoint *out, size_t n)
+{
+  window_n(vals, window, AGG_MIN, 0, out, n);
+}
+
+void fixedpoint_window_max_n(const Fixedpoint *vals, size_t window, Fixedpoint *out, size_t n)
+{
+  window_n(vals, window, AGG_MAX, 0, out, n);
+}
+
+void fixedpoint_window_mean_n(const Fixedpoint *vals, size_t window, int mode, Fixedpoint *out, size_t n)
+{
+  window_n(vals, window, AGG_MEAN, mode, out, n);
+}
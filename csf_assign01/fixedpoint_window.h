@@ -0,0 +1,111 @@
+#ifndef FIXEDPOINT_WINDOW_H
+#define FIXEDPOINT_WINDOW_H
+
+#include <stddef.h>
+#include "fixedpoint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Aggregates over a sliding window of the most recent Fixedpoint values.
+//
+// Values are pushed one at a time; once the window is full, each push
+// evicts the oldest value.  The sum is kept exactly in a wide accumulator,
+// so pushing is O(1) and the sum never drifts or overflows internally (it
+// is only out of range if the window's values really add up to more than
+// a Fixedpoint can hold).  The minimum and maximum are kept with monotonic
+// deques, ordered as by fixedpoint_compare, so pushing is O(1) amortized
+// and reading them is O(1).
+//
+// All values pushed must be valid.
+
+typedef struct FixedpointWindow FixedpointWindow;
+
+// Create an empty window.
+//
+// Parameters:
+//   size - the number of values the window holds (at least 1)
+//
+// Returns:
+//   the window, to be freed with fixedpoint_window_destroy, or NULL if
+//   size is 0 or memory couldn't be allocated
+FixedpointWindow *fixedpoint_window_create(size_t size);
+
+// Free a window.
+//
+// Parameters:
+//   win - the window (may be NULL)
+void fixedpoint_window_destroy(FixedpointWindow *win);
+
+// Add a value to a window, evicting the oldest value if it is full.
+//
+// Parameters:
+//   win - the window
+//   val - a valid Fixedpoint value
+void fixedpoint_window_push(FixedpointWindow *win, Fixedpoint val);
+
+// Get the number of values in a window (at most its size).
+//
+// Parameters:
+//   win - the window
+//
+// Returns:
+//   the number of values
+size_t fixedpoint_window_count(const FixedpointWindow *win);
+
+// Get the sum of the values in a window.
+//
+// Parameters:
+//   win - the window
+//
+// Returns:
+//   the exact sum (zero if the window is empty), or an overflow value if
+//   it is out of range
+Fixedpoint fixedpoint_window_sum(const FixedpointWindow *win);
+
+// Get the smallest or largest value in a window.
+//
+// Parameters:
+//   win - the window
+//
+// Returns:
+//   the smallest (or largest) value, or a value for which
+//   fixedpoint_is_err returns true if the window is empty
+Fixedpoint fixedpoint_window_min(const FixedpointWindow *win);
+Fixedpoint fixedpoint_window_max(const FixedpointWindow *win);
+
+// Get the mean of the values in a window.  The mean is computed from the
+// exact sum, so it is always in range and is correctly rounded.
+//
+// Parameters:
+//   win - the window
+//   mode - one of the FIXEDPOINT_ROUND_ modes
+//
+// Returns:
+//   the rounded mean; an underflow value if mode is FIXEDPOINT_ROUND_EXACT
+//   and the mean isn't exact; or a value for which fixedpoint_is_err
+//   returns true if the window is empty
+Fixedpoint fixedpoint_window_mean(const FixedpointWindow *win, int mode);
+
+// Batch versions: out[i] is the aggregate of the window of values ending
+// at vals[i], i.e. vals[i - window + 1] to vals[i] (or from vals[0], for
+// the first window - 1 results).  The output array may be the same as
+// the input array.
+//
+// Parameters:
+//   vals - array of n valid values
+//   window - the window size (at least 1)
+//   mode (mean only) - one of the FIXEDPOINT_ROUND_ modes
+//   out - array of n results
+//   n - number of elements
+void fixedpoint_window_sum_n(const Fixedpoint *vals, size_t window, Fixedpoint *out, size_t n);
+void fixedpoint_window_min_n(const Fixedpoint *vals, size_t window, Fixedpoint *out, size_t n);
+void fixedpoint_window_max_n(const Fixedpoint *vals, size_t window, Fixedpoint *out, size_t n);
+void fixedpoint_window_mean_n(const Fixedpoint *vals, size_t window, int mode, Fixedpoint *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FIXEDPOINT_WINDOW_H